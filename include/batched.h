@@ -0,0 +1,282 @@
+#ifndef MATRIX_BATCHED_H
+#define MATRIX_BATCHED_H
+
+#include <vector>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+#include <type_traits>
+
+#include "cpuFeatures.h"
+#include "kernelsAvx2.h"
+#include "kernelsAvx512.h"
+#include "simdVector.h"
+#include "gemm.h"
+#include "threadPool.h"
+#include "matrix.h"
+
+/**
+ * Batched multiplication of many independent small matrices. Packing, cache blocking and tiling the output pay off
+ * for large operands but dominate the cost of an 8 x 8 product, so products of up to BATCH_SMALL_MAX in every
+ * dimension skip them: the small kernels read A and B where they are and keep an MR x W block of C in registers,
+ * with W the vector width of the host. The kernels are generated from one template, instantiated once per
+ * instruction set. The batch is spread across the thread pool; each product runs on a single thread.
+ */
+namespace matmul {
+
+    /**
+     * Largest dimension handled by the small kernels; bigger products in a batch go through multiply().
+     */
+    const std::size_t BATCH_SMALL_MAX = 64;
+
+    /**
+     * Computes an MR x W block of C = A * B from unpacked, row-major operands.
+     */
+    template <typename T, int W, int MR>
+    inline void smallTile(std::size_t k, const T* a, std::size_t lda, const T* b, std::size_t ldb,
+                          T* c, std::size_t ldc) {
+#ifdef MATRIX_VECTOR_EXTENSIONS
+        typedef typename SimdVector<T, W>::type V;
+        V acc[MR];
+        for (int r = 0; r < MR; ++r)
+            acc[r] = V{};
+        for (std::size_t p = 0; p < k; ++p) {
+            V bv;
+            std::memcpy(&bv, b + p * ldb, sizeof(V));
+            for (int r = 0; r < MR; ++r)
+                acc[r] += a[r * lda + p] * bv;
+        }  // p
+        for (int r = 0; r < MR; ++r)
+            std::memcpy(c + r * ldc, &acc[r], sizeof(V));
+#else
+        T acc[MR][W];
+        for (int r = 0; r < MR; ++r)
+            for (int s = 0; s < W; ++s)
+                acc[r][s] = T(0);
+        for (std::size_t p = 0; p < k; ++p) {
+            const T* bRow = b + p * ldb;
+            for (int r = 0; r < MR; ++r) {
+                const T ar = a[r * lda + p];
+                for (int s = 0; s < W; ++s)
+                    acc[r][s] += ar * bRow[s];
+            }  // r
+        }  // p
+        for (int r = 0; r < MR; ++r)
+            for (int s = 0; s < W; ++s)
+                c[r * ldc + s] = acc[r][s];
+#endif
+    }
+
+    /**
+     * Covers columns [j, n) of an MR-row strip with tiles W wide, then hands the remainder to tiles half as wide.
+     */
+    template <typename T, int W, int MR>
+    struct SmallColumns {
+        static void run(std::size_t j, std::size_t n, std::size_t k, const T* a, std::size_t lda,
+                        const T* b, std::size_t ldb, T* c, std::size_t ldc) {
+            for (; j + W <= n; j += W)
+                smallTile<T, W, MR>(k, a, lda, b + j, ldb, c + j, ldc);
+            SmallColumns<T, W / 2, MR>::run(j, n, k, a, lda, b, ldb, c, ldc);
+        }
+    };
+
+    template <typename T, int MR>
+    struct SmallColumns<T, 0, MR> {
+        static void run(std::size_t, std::size_t, std::size_t, const T*, std::size_t,
+                        const T*, std::size_t, T*, std::size_t) {}
+    };
+
+    /**
+     * Covers rows [i, m) with strips MR tall, then hands the remainder to strips half as tall.
+     */
+    template <typename T, int W, int MR>
+    struct SmallRows {
+        static void run(std::size_t i, std::size_t m, std::size_t n, std::size_t k, const T* a, std::size_t lda,
+                        const T* b, std::size_t ldb, T* c, std::size_t ldc) {
+            for (; i + MR <= m; i += MR)
+                SmallColumns<T, W, MR>::run(0, n, k, a + i * lda, lda, b, ldb, c + i * ldc, ldc);
+            SmallRows<T, W, MR / 2>::run(i, m, n, k, a, lda, b, ldb, c, ldc);
+        }
+    };
+
+    template <typename T, int W>
+    struct SmallRows<T, W, 0> {
+        static void run(std::size_t, std::size_t, std::size_t, std::size_t, const T*, std::size_t,
+                        const T*, std::size_t, T*, std::size_t) {}
+    };
+
+    /**
+     * Computes C = A * B for small row-major operands with tiles of up to eight rows and W columns.
+     */
+    template <typename T, int W>
+    inline void smallGemm(std::size_t m, std::size_t n, std::size_t k, const T* a, std::size_t lda,
+                          const T* b, std::size_t ldb, T* c, std::size_t ldc) {
+        SmallRows<T, W, 8>::run(0, m, n, k, a, lda, b, ldb, c, ldc);
+    }
+
+    /**
+     * Instantiations of smallGemm for each instruction set. flatten inlines the whole tile template into the
+     * wrapper, so it is compiled for the wrapper's target.
+     */
+    template <typename T>
+    __attribute__((flatten))
+    void smallGemmGeneric(std::size_t m, std::size_t n, std::size_t k, const T* a, std::size_t lda,
+                          const T* b, std::size_t ldb, T* c, std::size_t ldc) {
+        smallGemm<T, (sizeof(T) <= 16 ? 16 / sizeof(T) : 1)>(m, n, k, a, lda, b, ldb, c, ldc);
+    }
+
+#ifdef MATRIX_X86
+    template <typename T>
+    MATRIX_TARGET_AVX2 __attribute__((flatten))
+    void smallGemmAvx2(std::size_t m, std::size_t n, std::size_t k, const T* a, std::size_t lda,
+                       const T* b, std::size_t ldb, T* c, std::size_t ldc) {
+        smallGemm<T, 32 / sizeof(T)>(m, n, k, a, lda, b, ldb, c, ldc);
+    }
+
+    template <typename T>
+    MATRIX_TARGET_AVX512 __attribute__((flatten))
+    void smallGemmAvx512(std::size_t m, std::size_t n, std::size_t k, const T* a, std::size_t lda,
+                         const T* b, std::size_t ldb, T* c, std::size_t ldc) {
+        smallGemm<T, 64 / sizeof(T)>(m, n, k, a, lda, b, ldb, c, ldc);
+    }
+#endif
+
+    /**
+     * Picks the small kernel for T. Types the vector extensions cannot hold (e.g. the half precision types) go
+     * through multiply() instead.
+     */
+    template <typename T, bool arithmetic = std::is_arithmetic<T>::value>
+    struct SmallKernel {
+        typedef void (*kernel_fn)(std::size_t m, std::size_t n, std::size_t k, const T* a, std::size_t lda,
+                                  const T* b, std::size_t ldb, T* c, std::size_t ldc);
+
+        static kernel_fn select() {
+#ifdef MATRIX_X86
+            if (std::is_floating_point<T>::value && cpuFeatures().avx512f)
+                return &smallGemmAvx512<T>;
+            if (cpuFeatures().avx2 && cpuFeatures().fma)
+                return &smallGemmAvx2<T>;
+#endif
+            return &smallGemmGeneric<T>;
+        }
+
+        static kernel_fn get() {
+            static const kernel_fn kernel = select();
+            return kernel;
+        }
+    };
+
+    template <typename T>
+    struct SmallKernel<T, false> {
+        typedef void (*kernel_fn)(std::size_t m, std::size_t n, std::size_t k, const T* a, std::size_t lda,
+                                  const T* b, std::size_t ldb, T* c, std::size_t ldc);
+
+        static void viaMultiply(std::size_t m, std::size_t n, std::size_t k, const T* a, std::size_t lda,
+                                const T* b, std::size_t ldb, T* c, std::size_t ldc) {
+            multiply<T>(m, n, k, a, static_cast<std::ptrdiff_t>(lda), 1, b, static_cast<std::ptrdiff_t>(ldb), 1,
+                        c, ldc);
+        }
+
+        static kernel_fn get() {
+            return &viaMultiply;
+        }
+    };
+
+    /**
+     * Runs product(i) for every i in [0, batch), in chunks spread across the thread pool. Batches of less than
+     * PARALLEL_MIN_FLOPS in total, at flops per product, run on the calling thread.
+     */
+    template <typename Fn>
+    void forEachInBatch(std::size_t batch, std::size_t flops, const Fn& product) {
+        ThreadPool& pool = ThreadPool::instance();
+        if (pool.size() == 1 || batch * flops < PARALLEL_MIN_FLOPS) {
+            for (std::size_t i = 0; i < batch; ++i)
+                product(i);
+            return;
+        }
+        const std::size_t nTasks = std::min(batch, 8 * pool.size());
+        pool.parallelFor(nTasks, [&product, batch, nTasks](std::size_t t) {
+            const std::size_t end = batch * (t + 1) / nTasks;
+            for (std::size_t i = batch * t / nTasks; i < end; ++i)
+                product(i);
+        });
+    }
+
+    /**
+     * Computes one product of a batch on the calling thread: with a small kernel if it is small, with the blocked
+     * engine otherwise.
+     */
+    template <typename T>
+    inline void batchProduct(std::size_t m, std::size_t n, std::size_t k, const T* a, std::size_t lda,
+                             const T* b, std::size_t ldb, T* c, std::size_t ldc) {
+        if (m <= BATCH_SMALL_MAX && n <= BATCH_SMALL_MAX && k <= BATCH_SMALL_MAX) {
+            SmallKernel<T>::get()(m, n, k, a, lda, b, ldb, c, ldc);
+        } else {
+            multiply<T>(m, n, k, a, static_cast<std::ptrdiff_t>(lda), 1, b, static_cast<std::ptrdiff_t>(ldb), 1,
+                        c, ldc);
+        }
+    }
+
+    /**
+     * Computes C[i] = A[i] * B[i] for batch independent products of row-major m x k matrices A[i] and k x n matrices
+     * B[i], given as arrays of pointers.
+     *
+     * @param lda Row stride of every A[i]
+     * @param ldb Row stride of every B[i]
+     * @param ldc Row stride of every C[i]
+     */
+    template <typename T>
+    void batchedMultiply(std::size_t batch, std::size_t m, std::size_t n, std::size_t k,
+                         const T* const* a, std::size_t lda, const T* const* b, std::size_t ldb,
+                         T* const* c, std::size_t ldc) {
+        forEachInBatch(batch, m * n * k, [=](std::size_t i) {
+            batchProduct(m, n, k, a[i], lda, b[i], ldb, c[i], ldc);
+        });
+    }
+
+    /**
+     * Same as above for operands stored back to back in strided 3D buffers: A[i] starts at a + i * strideA, and
+     * likewise for B and C. A stride of 0 reuses the same matrix for every product.
+     */
+    template <typename T>
+    void batchedMultiply(std::size_t batch, std::size_t m, std::size_t n, std::size_t k,
+                         const T* a, std::size_t lda, std::size_t strideA,
+                         const T* b, std::size_t ldb, std::size_t strideB,
+                         T* c, std::size_t ldc, std::size_t strideC) {
+        forEachInBatch(batch, m * n * k, [=](std::size_t i) {
+            batchProduct(m, n, k, a + i * strideA, lda, b + i * strideB, ldb, c + i * strideC, ldc);
+        });
+    }
+}
+
+/**
+ * Multiplies a[i] by b[i] for every i. Pairs may differ in shape from one another.
+ *
+ * @return The products, in order.
+ * @throws Matrix<T>::size_mismatch if the batches differ in length or a pair cannot be multiplied
+ * @throws Matrix<T>::empty_matrix if any operand is empty
+ */
+template <typename T>
+std::vector<Matrix<T> > batchedMultiply(const std::vector<Matrix<T> >& a, const std::vector<Matrix<T> >& b) {
+    if (a.size() != b.size())
+        throw typename Matrix<T>::size_mismatch();
+    std::vector<Matrix<T> > res;
+    res.reserve(a.size());
+    std::size_t maxFlops = 0;
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        if (a[i].shape(0) == 0 || a[i].shape(1) == 0 || b[i].shape(0) == 0 || b[i].shape(1) == 0)
+            throw typename Matrix<T>::empty_matrix();
+        if (a[i].shape(1) != b[i].shape(0))
+            throw typename Matrix<T>::size_mismatch();
+        res.push_back(Matrix<T>(std::make_pair(a[i].shape(0), b[i].shape(1))));
+        maxFlops = std::max<std::size_t>(maxFlops, std::size_t(a[i].shape(0)) * a[i].shape(1) * b[i].shape(1));
+    }
+
+    matmul::forEachInBatch(a.size(), maxFlops, [&a, &b, &res](std::size_t i) {
+        const mat_size_t m = a[i].shape(0), k = a[i].shape(1), n = b[i].shape(1);
+        matmul::batchProduct<T>(m, n, k, &a[i](0, 0), k, &b[i](0, 0), n, &res[i](0, 0), n);
+    });
+    return res;
+}
+
+#endif //MATRIX_BATCHED_H
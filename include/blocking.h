@@ -0,0 +1,67 @@
+#ifndef MATRIX_BLOCKING_H
+#define MATRIX_BLOCKING_H
+
+#include <cstdint>
+
+/**
+ * Compile-time blocking policies. A policy is any type that defines these enumerators:
+ *
+ *     MR, NR      Register tile of the portable micro-kernel: the MR x NR block of C kept in registers
+ *     MC, KC, NC  Row, depth and column cache blocks of the packed GEMM loop nest (see gemm.h)
+ *     XPOSE       Edge of the square tiles the cache-blocked transpose works through
+ *
+ * Matrix<T> uses DefaultBlocking<T>; pass another policy as the second template parameter of Matrix to override it.
+ * Hand-vectorized micro-kernels bring their own register tile, so MR and NR only affect the portable kernel. A
+ * tuning profile, when present, still takes precedence over the cache blocks (see tuning.h).
+ */
+
+/**
+ * Fallback for element types without their own defaults: a moderate tile that fits any register file.
+ */
+template <typename T>
+struct DefaultBlocking {
+    enum { MR = 4, NR = 4, MC = 128, KC = 256, NC = 2048, XPOSE = 32 };
+};
+
+/**
+ * Four 8-wide vectors of accumulators; an MC x KC block of A is 128 KB (L2), a KC x NR micro-panel of B is 8 KB
+ * (L1).
+ */
+template <>
+struct DefaultBlocking<float> {
+    enum { MR = 4, NR = 8, MC = 128, KC = 256, NC = 2048, XPOSE = 64 };
+};
+
+/**
+ * Four 4-wide vectors of accumulators; a KC x NR micro-panel of B is 8 KB (L1) and a KC x NC panel of B is 2 MB, as
+ * for float. An MC x KC block of A is 192 KB, larger than float's but still well within L2.
+ */
+template <>
+struct DefaultBlocking<double> {
+    enum { MR = 4, NR = 4, MC = 96, KC = 256, NC = 1024, XPOSE = 32 };
+};
+
+template <>
+struct DefaultBlocking<int32_t> {
+    enum { MR = 4, NR = 8, MC = 128, KC = 256, NC = 2048, XPOSE = 64 };
+};
+
+/**
+ * 64-bit integer multiplies do not vectorize without AVX-512, so the tile is sized for the general purpose
+ * registers.
+ */
+template <>
+struct DefaultBlocking<int64_t> {
+    enum { MR = 4, NR = 4, MC = 96, KC = 256, NC = 1024, XPOSE = 32 };
+};
+
+/**
+ * Blocking of the quantized int8 GEMM (see quantized.h), where k is counted in bytes: a KC x 32 micro-panel of B is
+ * 16 KB and an MC x KC block of A is 96 KB.
+ */
+template <>
+struct DefaultBlocking<int8_t> {
+    enum { MR = 4, NR = 8, MC = 192, KC = 512, NC = 4096, XPOSE = 64 };
+};
+
+#endif //MATRIX_BLOCKING_H
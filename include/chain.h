@@ -0,0 +1,221 @@
+#ifndef MATRIX_CHAIN_H
+#define MATRIX_CHAIN_H
+
+#include <vector>
+#include <string>
+#include <limits>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+
+#include "blocking.h"
+#include "gemv.h"
+#include "strassen.h"
+#include "matrix.h"
+
+/**
+ * Products of a chain of matrices A0 * A1 * ... * An-1. The flops depend heavily on the parenthesization when the
+ * shapes differ: (A * B) * x with a 1000 x 1000 A and B and a vector x takes a thousand times the work of
+ * A * (B * x). The classic O(n^3) dynamic program over the shapes picks the cheapest order, and the chain is then
+ * evaluated along it with the intermediate products kept in a pool of scratch buffers that is reused from step to
+ * step.
+ */
+namespace matmul {
+
+    /**
+     * Evaluation order of a chain of n matrices, Ai being dims[i] x dims[i + 1].
+     */
+    struct ChainOrder {
+        std::vector<std::size_t> dims;
+        /**
+         * Cheapest split of each sub-chain: Ai..Aj is computed as (Ai..As) * (As+1..Aj), s = splits[i * n + j].
+         */
+        std::vector<std::size_t> splits;
+        /**
+         * Estimated flops of the whole chain, counting a multiply-add as two.
+         */
+        std::uint64_t flops;
+
+        std::size_t size() const {
+            return dims.empty() ? 0 : dims.size() - 1;
+        }
+
+        std::size_t split(std::size_t i, std::size_t j) const {
+            return splits[i * size() + j];
+        }
+
+        /**
+         * @return The parenthesization, e.g. "(A0 * (A1 * A2))".
+         */
+        std::string to_string() const {
+            return size() == 0 ? std::string() : to_string(0, size() - 1);
+        }
+
+    private:
+        std::string to_string(std::size_t i, std::size_t j) const {
+            if (i == j)
+                return "A" + std::to_string(i);
+            const std::size_t s = split(i, j);
+            return "(" + to_string(i, s) + " * " + to_string(s + 1, j) + ")";
+        }
+    };
+
+    /**
+     * Flops of an m x k times k x n product.
+     */
+    inline std::uint64_t productFlops(std::size_t m, std::size_t n, std::size_t k) {
+        return 2 * static_cast<std::uint64_t>(m) * n * k;
+    }
+
+    /**
+     * Finds the cheapest order of a chain of dims.size() - 1 matrices, matrix i being dims[i] x dims[i + 1].
+     */
+    inline ChainOrder chainOrder(const std::vector<std::size_t>& dims) {
+        ChainOrder order;
+        order.dims = dims;
+        const std::size_t n = order.size();
+        order.splits.assign(n * n, 0);
+        order.flops = 0;
+        if (n == 0)
+            return order;
+
+        std::vector<std::uint64_t> cost(n * n, 0);
+        for (std::size_t len = 2; len <= n; ++len) {
+            for (std::size_t i = 0; i + len <= n; ++i) {
+                const std::size_t j = i + len - 1;
+                std::uint64_t best = std::numeric_limits<std::uint64_t>::max();
+                for (std::size_t s = i; s < j; ++s) {
+                    const std::uint64_t c = cost[i * n + s] + cost[(s + 1) * n + j] +
+                                            productFlops(dims[i], dims[j + 1], dims[s + 1]);
+                    if (c < best) {
+                        best = c;
+                        order.splits[i * n + j] = s;
+                    }
+                }  // s
+                cost[i * n + j] = best;
+            }  // i
+        }  // len
+        order.flops = cost[n - 1];
+        return order;
+    }
+
+    /**
+     * Computes the row-major m x n product C = A * B of row-major operands, routing matrix-vector shapes to the
+     * GEMV kernels like Matrix::operator* does.
+     */
+    template <typename T, typename Blocking>
+    void chainProduct(std::size_t m, std::size_t n, std::size_t k, const T* a, const T* b, T* c) {
+        if (n == 1)
+            gemv(m, k, a, k, b, c);
+        else if (m == 1)
+            gemvTransposed(k, n, b, n, a, c);
+        else
+            strassenMultiply<T, Blocking>(m, n, k, a, k, 1, b, n, 1, c, n);
+    }
+
+    /**
+     * Evaluates a chain along a ChainOrder. Intermediate products live in buffers taken from a free list and
+     * returned to it as soon as they have been consumed, so later steps reuse their storage.
+     */
+    template <typename T, typename Blocking>
+    class ChainEvaluator {
+    public:
+        ChainEvaluator(const std::vector<const T*>& operands, const ChainOrder& order) :
+                operands(operands), order(order) {}
+
+        /**
+         * Computes Ai..Aj into c, a row-major dims[i] x dims[j + 1] matrix.
+         */
+        void evaluate(std::size_t i, std::size_t j, T* c) {
+            const std::vector<std::size_t>& dims = order.dims;
+            const std::size_t s = order.split(i, j);
+            std::vector<T> left, right;
+            const T* a = operand(i, s, left);
+            const T* b = operand(s + 1, j, right);
+            chainProduct<T, Blocking>(dims[i], dims[j + 1], dims[s + 1], a, b, c);
+            release(left);
+            release(right);
+        }
+
+    private:
+        const std::vector<const T*>& operands;
+        const ChainOrder& order;
+        std::vector<std::vector<T> > pool;
+
+        /**
+         * @return The elements of Ai..Aj: the input itself for a single matrix, otherwise the product computed
+         * into buf, a buffer from the pool.
+         */
+        const T* operand(std::size_t i, std::size_t j, std::vector<T>& buf) {
+            if (i == j)
+                return operands[i];
+            buf = acquire(order.dims[i] * order.dims[j + 1]);
+            evaluate(i, j, buf.data());
+            return buf.data();
+        }
+
+        /**
+         * Takes the smallest pooled buffer that holds size elements, or else the largest one, grown.
+         */
+        std::vector<T> acquire(std::size_t size) {
+            std::vector<T> buf;
+            if (!pool.empty()) {
+                std::size_t pick = 0;
+                for (std::size_t p = 1; p < pool.size(); ++p) {
+                    const bool fits = pool[p].capacity() >= size, pickFits = pool[pick].capacity() >= size;
+                    if (fits ? !pickFits || pool[p].capacity() < pool[pick].capacity()
+                             : !pickFits && pool[p].capacity() > pool[pick].capacity())
+                        pick = p;
+                }  // p
+                buf.swap(pool[pick]);
+                pool.erase(pool.begin() + pick);
+            }
+            buf.resize(size);
+            return buf;
+        }
+
+        void release(std::vector<T>& buf) {
+            if (buf.capacity() > 0)
+                pool.push_back(std::move(buf));
+        }
+    };
+}
+
+/**
+ * Multiplies a chain of matrices in the order that takes the fewest flops rather than left to right.
+ *
+ * @param mats The factors, in order.
+ * @param order If not null, receives the chosen order and its estimated flops.
+ * @return A new Matrix instance holding mats[0] * ... * mats[n - 1].
+ * @throws Matrix<T>::empty_matrix if mats or any factor is empty
+ * @throws Matrix<T>::size_mismatch if adjacent factors do not conform
+ */
+template <typename T, typename Blocking>
+Matrix<T, Blocking> multiplyChain(const std::vector<Matrix<T, Blocking> >& mats,
+                                  matmul::ChainOrder* order = nullptr) {
+    if (mats.empty())
+        throw typename Matrix<T, Blocking>::empty_matrix();
+
+    std::vector<std::size_t> dims(1, mats[0].shape(0));
+    std::vector<const T*> operands;
+    for (std::size_t i = 0; i < mats.size(); ++i) {
+        if (mats[i].shape(0) == 0 || mats[i].shape(1) == 0)
+            throw typename Matrix<T, Blocking>::empty_matrix();
+        if (mats[i].shape(0) != dims.back())
+            throw typename Matrix<T, Blocking>::size_mismatch();
+        dims.push_back(mats[i].shape(1));
+        operands.push_back(&mats[i](0, 0));
+    }
+
+    const matmul::ChainOrder best = matmul::chainOrder(dims);
+    if (order)
+        *order = best;
+    if (mats.size() == 1)
+        return mats[0];
+
+    Matrix<T, Blocking> res = Matrix<T, Blocking>(std::make_pair(dims.front(), dims.back()));
+    matmul::ChainEvaluator<T, Blocking>(operands, best).evaluate(0, mats.size() - 1, &res(0, 0));
+    return res;
+}
+
+#endif //MATRIX_CHAIN_H
@@ -0,0 +1,278 @@
+#ifndef MATRIX_CHOLESKY_H
+#define MATRIX_CHOLESKY_H
+
+#include <cmath>
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+#include <type_traits>
+
+#include "blocking.h"
+#include "gemm.h"
+#include "syrk.h"
+#include "lu.h"
+#include "matrix.h"
+
+/**
+ * Cholesky factorization A = L * L^T of a symmetric positive definite matrix, and the solves built on it. The
+ * factorization is blocked and right-looking. Each step factors a CHOLESKY_BLOCK x CHOLESKY_BLOCK diagonal block,
+ * solves for the panel of L below it, recursively so that this too goes through the GEMM, and subtracts the
+ * panel's Gram matrix from the trailing matrix with the lower-triangle SYRK of syrk.h. That update does nearly all
+ * of the flops, half those of a GEMM, and runs on the thread pool. Only the lower triangle of A is read.
+ */
+namespace matmul {
+
+    /**
+     * Columns per panel of the factorization, and rows per block of the triangular solves.
+     */
+    const std::size_t CHOLESKY_BLOCK = 128;
+
+    /**
+     * Panels of at most this many columns are solved for without the GEMM.
+     */
+    const std::size_t CHOLESKY_LEAF = 16;
+
+    /**
+     * Factors the n x n diagonal block at a in place, reading its lower triangle.
+     *
+     * @return false if the block is not positive definite.
+     */
+    template <typename T>
+    bool choleskyDiagonal(std::size_t n, T* a, std::size_t lda) {
+        for (std::size_t j = 0; j < n; ++j) {
+            T* rowJ = a + j * lda;
+            T d = rowJ[j];
+            for (std::size_t p = 0; p < j; ++p)
+                d -= rowJ[p] * rowJ[p];
+            if (!(d > T(0)))
+                return false;
+            rowJ[j] = std::sqrt(d);
+            const T inv = T(1) / rowJ[j];
+            for (std::size_t i = j + 1; i < n; ++i) {
+                T* rowI = a + i * lda;
+                T s = rowI[j];
+                for (std::size_t p = 0; p < j; ++p)
+                    s -= rowI[p] * rowJ[p];
+                rowI[j] = s * inv;
+            }  // i
+        }  // j
+        return true;
+    }
+
+    /**
+     * Solves X * L^T = B in place for the lower triangle L of an n x n block and an m x n block B. Halves L down to
+     * CHOLESKY_LEAF columns, so most of the work is the GEMM update of the right half of B; the leaves go row by
+     * row on the thread pool.
+     */
+    template <typename T, typename Blocking>
+    void solveLowerTransposedRight(std::size_t m, std::size_t n, const T* l, std::size_t ldl,
+                                   T* b, std::size_t ldb) {
+        if (n > CHOLESKY_LEAF) {
+            const std::size_t n1 = n / 2, n2 = n - n1;
+            solveLowerTransposedRight<T, Blocking>(m, n1, l, ldl, b, ldb);
+            gemm<T, Blocking>(NO_TRANSPOSE, TRANSPOSE, m, n2, n1, T(-1), b, ldb, l + n1 * ldl, ldl,
+                              T(1), b + n1, ldb);
+            solveLowerTransposedRight<T, Blocking>(m, n2, l + n1 * ldl + n1, ldl, b + n1, ldb);
+            return;
+        }
+        forEachStrip(m, m * n * n, [=](std::size_t i0, std::size_t i1) {
+            for (std::size_t i = i0; i < i1; ++i) {
+                T* row = b + i * ldb;
+                for (std::size_t j = 0; j < n; ++j) {
+                    const T* lj = l + j * ldl;
+                    T s = row[j];
+                    for (std::size_t p = 0; p < j; ++p)
+                        s -= row[p] * lj[p];
+                    row[j] = s / lj[j];
+                }  // j
+            }  // i
+        });
+    }
+
+    /**
+     * Solves L * X = B in place for the lower triangle L of an n x n block and an n x cols block B.
+     */
+    template <typename T>
+    void solveLowerBlock(std::size_t n, std::size_t cols, const T* l, std::size_t ldl, T* b, std::size_t ldb) {
+        forEachStrip(cols, n * n * cols, [=](std::size_t j0, std::size_t j1) {
+            for (std::size_t i = 0; i < n; ++i) {
+                T* row = b + i * ldb;
+                for (std::size_t p = 0; p < i; ++p) {
+                    const T lip = l[i * ldl + p];
+                    const T* src = b + p * ldb;
+                    for (std::size_t j = j0; j < j1; ++j)
+                        row[j] -= lip * src[j];
+                }  // p
+                const T inv = T(1) / l[i * ldl + i];
+                for (std::size_t j = j0; j < j1; ++j)
+                    row[j] *= inv;
+            }  // i
+        });
+    }
+
+    /**
+     * Solves L^T * X = B in place for the lower triangle L of an n x n block and an n x cols block B.
+     */
+    template <typename T>
+    void solveLowerTransposedBlock(std::size_t n, std::size_t cols, const T* l, std::size_t ldl,
+                                   T* b, std::size_t ldb) {
+        forEachStrip(cols, n * n * cols, [=](std::size_t j0, std::size_t j1) {
+            for (std::size_t i = n; i-- > 0;) {
+                T* row = b + i * ldb;
+                for (std::size_t p = i + 1; p < n; ++p) {
+                    const T lpi = l[p * ldl + i];
+                    const T* src = b + p * ldb;
+                    for (std::size_t j = j0; j < j1; ++j)
+                        row[j] -= lpi * src[j];
+                }  // p
+                const T inv = T(1) / l[i * ldl + i];
+                for (std::size_t j = j0; j < j1; ++j)
+                    row[j] *= inv;
+            }  // i
+        });
+    }
+
+    /**
+     * Computes A = L * L^T in place for a row-major n x n symmetric positive definite matrix A, of which only the
+     * lower triangle is read. On return the lower triangle holds L and the strictly upper triangle is zero.
+     *
+     * @param lda Row stride of A
+     * @param block Columns per panel
+     * @return false if A is not positive definite, in which case A is left partially factored.
+     */
+    template <typename T, typename Blocking = DefaultBlocking<T> >
+    bool cholesky(std::size_t n, T* a, std::size_t lda, std::size_t block = CHOLESKY_BLOCK) {
+        static_assert(std::is_floating_point<T>::value, "Cholesky needs a floating point element type");
+        block = std::max<std::size_t>(block, 1);
+        for (std::size_t j = 0; j < n; j += block) {
+            const std::size_t nb = std::min(block, n - j);
+            T* a11 = a + j * lda + j;
+            if (!choleskyDiagonal(nb, a11, lda))
+                return false;
+            const std::size_t rest = n - j - nb;
+            if (rest == 0)
+                continue;
+            T* a21 = a11 + nb * lda;
+            solveLowerTransposedRight<T, Blocking>(rest, nb, a11, lda, a21, lda);
+            syrkLower<T, Blocking>(rest, nb, T(-1), a21, lda, 1, T(1), a21 + nb, lda);
+        }  // j
+        for (std::size_t i = 0; i < n; ++i)
+            std::fill(a + i * lda + i + 1, a + i * lda + n, T(0));
+        return true;
+    }
+
+    /**
+     * Solves A * X = B in place for the n x cols matrix B, given the factor L computed by cholesky(). The
+     * off-diagonal blocks of both triangular solves go through the GEMM, the second one reading L transposed.
+     */
+    template <typename T, typename Blocking = DefaultBlocking<T> >
+    void choleskySolve(std::size_t n, const T* l, std::size_t ldl, std::size_t cols, T* b, std::size_t ldb,
+                       std::size_t block = CHOLESKY_BLOCK) {
+        block = std::max<std::size_t>(block, 1);
+
+        // L * Y = B, top to bottom
+        for (std::size_t k = 0; k < n; k += block) {
+            const std::size_t nb = std::min(block, n - k);
+            if (k > 0)
+                gemm<T, Blocking>(NO_TRANSPOSE, NO_TRANSPOSE, nb, cols, k, T(-1), l + k * ldl, ldl,
+                                  b, ldb, T(1), b + k * ldb, ldb);
+            solveLowerBlock(nb, cols, l + k * ldl + k, ldl, b + k * ldb, ldb);
+        }  // k
+
+        // L^T * X = Y, bottom to top
+        for (std::size_t end = n; end > 0;) {
+            const std::size_t nb = std::min(block, end), k = end - nb;
+            if (end < n)
+                gemm<T, Blocking>(TRANSPOSE, NO_TRANSPOSE, nb, cols, n - end, T(-1), l + end * ldl + k, ldl,
+                                  b + end * ldb, ldb, T(1), b + k * ldb, ldb);
+            solveLowerTransposedBlock(nb, cols, l + k * ldl + k, ldl, b + k * ldb, ldb);
+            end = k;
+        }  // end
+    }
+}
+
+/**
+ * Cholesky factorization of a symmetric positive definite matrix, computed once on construction and reused by
+ * solve(), inverse() and determinant().
+ *
+ * @tparam T Floating point element type
+ * @tparam Blocking Cache blocking of the GEMM and SYRK calls (see blocking.h)
+ */
+template <typename T, typename Blocking = DefaultBlocking<T> >
+class Cholesky {
+public:
+    /**
+     * @param a A symmetric matrix; only its lower triangle is read.
+     * @throws Matrix<T>::empty_matrix if a is empty
+     * @throws Matrix<T>::size_mismatch if a is not square
+     */
+    explicit Cholesky(const Matrix<T, Blocking>& a) : l(a) {
+        if (a.shape(0) == 0 || a.shape(1) == 0)
+            throw typename Matrix<T, Blocking>::empty_matrix();
+        if (a.shape(0) != a.shape(1))
+            throw typename Matrix<T, Blocking>::size_mismatch();
+        definite = matmul::cholesky<T, Blocking>(a.shape(0), &l(0, 0), a.shape(0));
+    }
+
+    /**
+     * @return The lower triangular factor L, zero above the diagonal.
+     */
+    const Matrix<T, Blocking>& factor() const {
+        return l;
+    }
+
+    bool positiveDefinite() const {
+        return definite;
+    }
+
+    /**
+     * @return The determinant of A, or 0 if A is not positive definite.
+     */
+    T determinant() const {
+        T det = T(1);
+        for (mat_size_t i = 0; i < l.shape(0); ++i)
+            det *= l(i, i) * l(i, i);
+        return definite ? det : T(0);
+    }
+
+    /**
+     * @param b An n x k matrix of right-hand sides.
+     * @return The n x k solution X of A * X = B.
+     * @throws Matrix<T>::size_mismatch if b does not have n rows
+     * @throws Matrix<T>::singular_matrix if A is not positive definite
+     */
+    Matrix<T, Blocking> solve(const Matrix<T, Blocking>& b) const {
+        if (b.shape(0) == 0 || b.shape(1) == 0)
+            throw typename Matrix<T, Blocking>::empty_matrix();
+        if (b.shape(0) != l.shape(0))
+            throw typename Matrix<T, Blocking>::size_mismatch();
+        if (!definite)
+            throw typename Matrix<T, Blocking>::singular_matrix();
+
+        Matrix<T, Blocking> x = b;
+        matmul::choleskySolve<T, Blocking>(l.shape(0), &l(0, 0), l.shape(0), b.shape(1), &x(0, 0), b.shape(1));
+        return x;
+    }
+
+    std::vector<T> solve(const std::vector<T>& b) const {
+        const Matrix<T, Blocking> x = solve(Matrix<T, Blocking>(std::make_pair(b.size(), 1), b));
+        return std::vector<T>(x.cbegin(), x.cend());
+    }
+
+    /**
+     * @throws Matrix<T>::singular_matrix if A is not positive definite
+     */
+    Matrix<T, Blocking> inverse() const {
+        const mat_size_t n = l.shape(0);
+        Matrix<T, Blocking> id = Matrix<T, Blocking>(std::make_pair(n, n));
+        for (mat_size_t i = 0; i < n; ++i)
+            id(i, i) = T(1);
+        return solve(id);
+    }
+
+private:
+    Matrix<T, Blocking> l;
+    bool definite;
+};
+
+#endif //MATRIX_CHOLESKY_H
@@ -0,0 +1,79 @@
+#ifndef MATRIX_CPUFEATURES_H
+#define MATRIX_CPUFEATURES_H
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MATRIX_X86 1
+#include <cpuid.h>
+#endif
+
+/**
+ * Instruction set extensions of the host CPU that the kernels know how to use. A flag is only set when both the CPU
+ * reports the extension and the operating system saves the corresponding register state across context switches.
+ */
+struct CpuFeatures {
+    bool avx2;
+    bool fma;
+    bool f16c;  // Conversion between half and single precision
+    bool avx512f;
+    bool avx512bw;
+    bool avx512vnni;  // vpdpbusd: u8 x s8 dot products accumulated into int32
+
+    CpuFeatures() : avx2(false), fma(false), f16c(false), avx512f(false), avx512bw(false), avx512vnni(false) {}
+};
+
+#ifdef MATRIX_X86
+/**
+ * @return The extended control register XCR0, describing which register files the OS preserves.
+ */
+inline unsigned long long readXcr0() {
+    unsigned int eax, edx;
+    __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<unsigned long long>(edx) << 32) | eax;
+}
+#endif
+
+/**
+ * Queries cpuid for the supported extensions. Use cpuFeatures() instead, which only does this once.
+ */
+inline CpuFeatures detectCpuFeatures() {
+    CpuFeatures f;
+#ifdef MATRIX_X86
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        return f;
+    const bool osxsave = (ecx & (1u << 27)) != 0;
+    const bool avx = (ecx & (1u << 28)) != 0;
+    const bool fma = (ecx & (1u << 12)) != 0;
+    const bool f16c = (ecx & (1u << 29)) != 0;
+    if (!osxsave || !avx)
+        return f;
+
+    const unsigned long long xcr0 = readXcr0();
+    const bool ymmState = (xcr0 & 0x6) == 0x6;
+    if (!ymmState)
+        return f;
+    f.f16c = f16c;
+
+    // opmask, upper halves of zmm0-15 and zmm16-31
+    const bool zmmState = (xcr0 & 0xE0) == 0xE0;
+
+    if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        f.avx2 = (ebx & (1u << 5)) != 0;
+        f.fma = fma;
+        f.avx512f = zmmState && (ebx & (1u << 16)) != 0;
+        f.avx512bw = f.avx512f && (ebx & (1u << 30)) != 0;
+        f.avx512vnni = f.avx512f && (ecx & (1u << 11)) != 0;
+    }
+#endif
+    return f;
+}
+
+/**
+ * @return The extensions supported by the host, detected on first use.
+ */
+inline const CpuFeatures& cpuFeatures() {
+    static const CpuFeatures features = detectCpuFeatures();
+    return features;
+}
+
+#endif //MATRIX_CPUFEATURES_H
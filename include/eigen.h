@@ -0,0 +1,474 @@
+#ifndef MATRIX_EIGEN_H
+#define MATRIX_EIGEN_H
+
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+
+#include "blocking.h"
+#include "gemm.h"
+#include "gemv.h"
+#include "syrk.h"
+#include "qr.h"
+#include "matrix.h"
+
+/**
+ * Symmetric eigendecomposition and singular value decomposition. A symmetric matrix is first reduced to a tridiagonal
+ * one, T = Q^T * A * Q, with blocked Householder reflections: each panel of EIGEN_BLOCK reflectors only needs
+ * matrix-vector products with the trailing matrix, through the GEMV kernels, and the lower triangle of the trailing
+ * matrix is then updated once per panel by a rank-2k SYR2K. All eigenvalues of T follow from implicit QL iterations,
+ * which take O(n^2). Only the eigenvectors asked for are computed, by inverse iteration on T, reorthogonalized within
+ * clusters of close eigenvalues, and mapped back to A by applying Q in the compact WY form of qr.h, through the GEMM.
+ * The O(n^3) part of taking the top k eigenpairs is therefore the reduction alone.
+ *
+ * The SVD of an m x n matrix is taken from the eigendecomposition of its smaller Gram matrix, formed with the SYRK
+ * of syrk.h. This squares the condition number, so singular values much below sqrt(epsilon) times the largest one
+ * lose their relative accuracy. That suits truncated decompositions such as PCA.
+ */
+namespace matmul {
+
+    /**
+     * Reflectors per panel of the tridiagonal reduction.
+     */
+    const std::size_t EIGEN_BLOCK = 32;
+
+    /**
+     * Inverse iteration steps per eigenvector.
+     */
+    const int INVERSE_ITERATIONS = 3;
+
+    /**
+     * Reduces the row-major n x n symmetric matrix A to tridiagonal form T = Q^T * A * Q in place. Only the lower
+     * triangle and a band of GEMV_SYMMETRIC_TILE - 1 diagonals above it, which the symmetric GEMV reads with its
+     * diagonal tiles, are read and kept up to date; the rest of the upper triangle is left stale. On return d and e
+     * hold the diagonal and subdiagonal of T, and column i of A below its subdiagonal holds reflector i of
+     * Q = H_0 * H_1 * ... * H_n-2, whose first element, on the subdiagonal, is an implicit 1.
+     *
+     * @param d n elements
+     * @param e n - 1 elements
+     * @param tau n - 1 elements, receiving the reflector scalars
+     * @param block Reflectors per panel
+     */
+    template <typename T, typename Blocking = DefaultBlocking<T> >
+    void tridiagonalize(std::size_t n, T* a, std::size_t lda, T* d, T* e, T* tau, std::size_t block = EIGEN_BLOCK) {
+        static_assert(std::is_floating_point<T>::value, "Tridiagonalization needs a floating point element type");
+        block = std::max<std::size_t>(block, 1);
+        // Reflectors and their w vectors of the current panel, one per row, over the full length n
+        std::vector<T> vt, wt;
+        for (std::size_t j = 0; j + 1 < n; j += block) {
+            const std::size_t nb = std::min(block, n - 1 - j);
+            vt.assign(nb * n, T(0));
+            wt.assign(nb * n, T(0));
+            for (std::size_t c = 0; c < nb; ++c) {
+                const std::size_t i = j + c;
+                T* v = vt.data() + c * n;
+                T* w = wt.data() + c * n;
+
+                // Column i as updated by the previous reflectors of the panel: A - V * W^T - W * V^T
+                for (std::size_t r = i; r < n; ++r) {
+                    T s = a[r * lda + i];
+                    for (std::size_t p = 0; p < c; ++p)
+                        s -= vt[p * n + r] * wt[p * n + i] + wt[p * n + r] * vt[p * n + i];
+                    a[r * lda + i] = s;
+                }  // r
+                d[i] = a[i * lda + i];
+
+                // Reflector annihilating column i below the subdiagonal
+                const T alpha = a[(i + 1) * lda + i];
+                T norm2 = T(0);
+                for (std::size_t r = i + 2; r < n; ++r)
+                    norm2 += a[r * lda + i] * a[r * lda + i];
+                T beta = alpha, t = T(0);
+                if (norm2 != T(0)) {
+                    beta = alpha > T(0) ? -std::sqrt(alpha * alpha + norm2) : std::sqrt(alpha * alpha + norm2);
+                    t = (beta - alpha) / beta;
+                    const T scale = T(1) / (alpha - beta);
+                    for (std::size_t r = i + 2; r < n; ++r)
+                        a[r * lda + i] *= scale;
+                }
+                e[i] = beta;
+                tau[i] = t;
+                a[(i + 1) * lda + i] = beta;
+                if (t == T(0))
+                    continue;
+                v[i + 1] = T(1);
+                for (std::size_t r = i + 2; r < n; ++r)
+                    v[r] = a[r * lda + i];
+
+                // w = tau * (A - V * W^T - W * V^T) * v - tau / 2 * (w^T * v) * v over rows i + 1..
+                const std::size_t len = n - i - 1;
+                gemvSymmetric(len, a + (i + 1) * lda + i + 1, lda, v + i + 1, w + i + 1);
+                for (std::size_t p = 0; p < c; ++p) {
+                    const T* vp = vt.data() + p * n;
+                    const T* wp = wt.data() + p * n;
+                    T wv = T(0), vv = T(0);
+                    for (std::size_t r = i + 1; r < n; ++r) {
+                        wv += wp[r] * v[r];
+                        vv += vp[r] * v[r];
+                    }  // r
+                    for (std::size_t r = i + 1; r < n; ++r)
+                        w[r] -= vp[r] * wv + wp[r] * vv;
+                }  // p
+                T wv = T(0);
+                for (std::size_t r = i + 1; r < n; ++r) {
+                    w[r] *= t;
+                    wv += w[r] * v[r];
+                }  // r
+                const T half = T(-0.5) * t * wv;
+                for (std::size_t r = i + 1; r < n; ++r)
+                    w[r] += half * v[r];
+            }  // c
+
+            // Lower trailing matrix -= V * W^T + W * V^T, then the band above the diagonal mirrored from it
+            const std::size_t s = j + nb, rest = n - s;
+            if (rest > 0) {
+                T* trailing = a + s * lda + s;
+                syr2kLower<T, Blocking>(rest, nb, T(-1), vt.data() + s, 1, n, wt.data() + s, 1, n, T(1),
+                                        trailing, lda);
+                for (std::size_t r = 0; r < rest; ++r)
+                    for (std::size_t c = r + 1; c < rest && c < r + GEMV_SYMMETRIC_TILE; ++c)
+                        trailing[r * lda + c] = trailing[c * lda + r];
+            }
+        }  // j
+        d[n - 1] = a[(n - 1) * lda + n - 1];
+    }
+
+    /**
+     * Computes C = Q * C for the Q of tridiagonalize() and an n x cols matrix C, a panel of QR_BLOCK reflectors at
+     * a time through the GEMM.
+     */
+    template <typename T, typename Blocking = DefaultBlocking<T> >
+    void tridiagonalApply(std::size_t n, const T* a, std::size_t lda, const T* tau,
+                          std::size_t cols, T* c, std::size_t ldc) {
+        if (n < 2)
+            return;
+        // The reflectors lie below the diagonal of A shifted down a row, laid out like those of qr()
+        const std::size_t m = n - 1;
+        const T* v = a + lda;
+        std::vector<T> t(QR_BLOCK * m, T(0));
+        for (std::size_t j = 0; j < m; j += QR_BLOCK) {
+            const std::size_t nb = std::min(QR_BLOCK, m - j);
+            for (std::size_t i = 0; i < nb; ++i)
+                t[i * m + j + i] = tau[j + i];
+            reflectorFactor(m - j, nb, v + j * lda + j, lda, t.data() + j, m);
+        }  // j
+        qrApply<T, Blocking>(false, m, m, v, lda, t.data(), m, cols, c + ldc, ldc);
+    }
+
+    /**
+     * Computes all eigenvalues of the symmetric tridiagonal matrix with diagonal d and subdiagonal e by implicit QL
+     * iterations with Wilkinson shifts, in place in d, in ascending order.
+     *
+     * @throws std::runtime_error if an eigenvalue fails to converge
+     */
+    template <typename T>
+    void tridiagonalEigenvalues(std::size_t n, T* d, const T* e) {
+        const T eps = std::numeric_limits<T>::epsilon();
+        std::vector<T> off(e, e + (n > 0 ? n - 1 : 0));
+        off.push_back(T(0));
+        for (std::size_t l = 0; l < n; ++l) {
+            for (int iter = 0;; ++iter) {
+                std::size_t m = l;
+                for (; m + 1 < n; ++m)
+                    if (std::abs(off[m]) <= eps * (std::abs(d[m]) + std::abs(d[m + 1])))
+                        break;
+                if (m == l)
+                    break;
+                if (iter == 60)
+                    throw std::runtime_error("Tridiagonal QL iteration did not converge");
+
+                T g = (d[l + 1] - d[l]) / (T(2) * off[l]);
+                T r = std::hypot(g, T(1));
+                g = d[m] - d[l] + off[l] / (g + (g >= T(0) ? r : -r));
+                T s = T(1), c = T(1), p = T(0);
+                bool deflated = false;
+                for (std::size_t i = m; i-- > l;) {
+                    const T f = s * off[i], b = c * off[i];
+                    r = std::hypot(f, g);
+                    off[i + 1] = r;
+                    if (r == T(0)) {
+                        d[i + 1] -= p;
+                        off[m] = T(0);
+                        deflated = true;
+                        break;
+                    }
+                    s = f / r;
+                    c = g / r;
+                    g = d[i + 1] - p;
+                    r = (d[i] - g) * s + T(2) * c * b;
+                    p = s * r;
+                    d[i + 1] = g + p;
+                    g = c * r - b;
+                }  // i
+                if (deflated)
+                    continue;
+                d[l] -= p;
+                off[l] = g;
+                off[m] = T(0);
+            }  // iter
+        }  // l
+        std::sort(d, d + n);
+    }
+
+    /**
+     * Solves (T - lambda * I) * x = x in place by Gaussian elimination with partial pivoting, for the symmetric
+     * tridiagonal T with diagonal d and subdiagonal e. Zero pivots are replaced by tiny.
+     */
+    template <typename T>
+    void shiftedTridiagonalSolve(std::size_t n, const T* d, const T* e, T lambda, T tiny, T* x,
+                                 std::vector<T>& diag, std::vector<T>& lower, std::vector<T>& upper,
+                                 std::vector<T>& upper2, std::vector<char>& swapped) {
+        diag.resize(n);
+        lower.assign(e, e + n - 1);
+        upper.assign(e, e + n - 1);
+        upper2.assign(n, T(0));
+        swapped.assign(n, 0);
+        for (std::size_t i = 0; i < n; ++i)
+            diag[i] = d[i] - lambda;
+
+        for (std::size_t i = 0; i + 1 < n; ++i) {
+            if (std::abs(diag[i]) >= std::abs(lower[i])) {
+                if (diag[i] == T(0))
+                    diag[i] = tiny;
+                const T fact = lower[i] / diag[i];
+                lower[i] = fact;
+                diag[i + 1] -= fact * upper[i];
+            } else {
+                const T fact = diag[i] / lower[i];
+                diag[i] = lower[i];
+                lower[i] = fact;
+                const T temp = upper[i];
+                upper[i] = diag[i + 1];
+                diag[i + 1] = temp - fact * diag[i + 1];
+                if (i + 2 < n) {
+                    upper2[i] = upper[i + 1];
+                    upper[i + 1] = -fact * upper[i + 1];
+                }
+                swapped[i] = 1;
+            }
+        }  // i
+        if (diag[n - 1] == T(0))
+            diag[n - 1] = tiny;
+
+        for (std::size_t i = 0; i + 1 < n; ++i) {
+            if (swapped[i]) {
+                const T temp = x[i];
+                x[i] = x[i + 1];
+                x[i + 1] = temp - lower[i] * x[i];
+            } else {
+                x[i + 1] -= lower[i] * x[i];
+            }
+        }  // i
+        for (std::size_t i = n; i-- > 0;) {
+            T s = x[i];
+            if (i + 1 < n)
+                s -= upper[i] * x[i + 1];
+            if (i + 2 < n)
+                s -= upper2[i] * x[i + 2];
+            x[i] = s / diag[i];
+        }  // i
+    }
+
+    /**
+     * Computes eigenvectors of the symmetric tridiagonal matrix with diagonal d and subdiagonal e by inverse
+     * iteration, for k eigenvalues given in descending order. Vectors of eigenvalues closer than 1e-3 * ||T|| are
+     * orthogonalized against each other.
+     *
+     * @param z n x k row-major matrix receiving the eigenvectors as columns
+     * @param ldz Row stride of z
+     */
+    template <typename T>
+    void tridiagonalEigenvectors(std::size_t n, const T* d, const T* e, std::size_t k, const T* lambdas,
+                                 T* z, std::size_t ldz) {
+        T norm = T(0);
+        for (std::size_t i = 0; i < n; ++i)
+            norm = std::max(norm, std::abs(d[i]) + (i > 0 ? std::abs(e[i - 1]) : T(0)) +
+                                  (i + 1 < n ? std::abs(e[i]) : T(0)));
+        const T eps = std::numeric_limits<T>::epsilon();
+        const T tiny = std::max(eps * norm, std::numeric_limits<T>::min());
+        const T separation = T(1e-3) * norm, perturbation = T(10) * eps * norm;
+
+        std::vector<T> x(n), diag, lower, upper, upper2;
+        std::vector<char> swapped;
+        std::vector<std::vector<T> > vectors(k);
+        std::size_t clusterStart = 0;
+        T shift = T(0);
+        std::uint32_t seed = 12345;
+        for (std::size_t j = 0; j < k; ++j) {
+            // Equal eigenvalues are pulled apart slightly so the solves differ
+            T lambda = lambdas[j];
+            if (j > 0 && lambdas[j - 1] - lambda <= separation) {
+                if (shift - lambda < perturbation)
+                    lambda = shift - perturbation;
+            } else {
+                clusterStart = j;
+            }
+            shift = lambda;
+
+            for (std::size_t i = 0; i < n; ++i) {
+                seed = seed * 1664525u + 1013904223u;
+                x[i] = static_cast<T>(seed >> 8) / static_cast<T>(1u << 24) - T(0.5);
+            }  // i
+            for (int iter = 0; iter < INVERSE_ITERATIONS; ++iter) {
+                shiftedTridiagonalSolve(n, d, e, lambda, tiny, x.data(), diag, lower, upper, upper2, swapped);
+                for (std::size_t p = clusterStart; p < j; ++p) {
+                    const std::vector<T>& q = vectors[p];
+                    T dot = T(0);
+                    for (std::size_t i = 0; i < n; ++i)
+                        dot += q[i] * x[i];
+                    for (std::size_t i = 0; i < n; ++i)
+                        x[i] -= dot * q[i];
+                }  // p
+                T scale = T(0);
+                for (std::size_t i = 0; i < n; ++i)
+                    scale = std::max(scale, std::abs(x[i]));
+                for (std::size_t i = 0; i < n; ++i)
+                    x[i] /= scale;
+                T norm2 = T(0);
+                for (std::size_t i = 0; i < n; ++i)
+                    norm2 += x[i] * x[i];
+                const T inv = T(1) / std::sqrt(norm2);
+                for (std::size_t i = 0; i < n; ++i)
+                    x[i] *= inv;
+            }  // iter
+            vectors[j] = x;
+            for (std::size_t i = 0; i < n; ++i)
+                z[i * ldz + j] = x[i];
+        }  // j
+    }
+}
+
+/**
+ * Eigendecomposition A = V * diag(lambda) * V^T of a symmetric matrix, restricted to its k largest eigenvalues.
+ *
+ * @tparam T Floating point element type
+ * @tparam Blocking Cache blocking of the GEMV and GEMM calls (see blocking.h)
+ */
+template <typename T, typename Blocking = DefaultBlocking<T> >
+class SymmetricEigen {
+public:
+    /**
+     * @param a A symmetric matrix; both triangles are read.
+     * @param k Number of eigenpairs to compute, or 0 for all of them
+     * @throws Matrix<T>::empty_matrix if a is empty
+     * @throws Matrix<T>::size_mismatch if a is not square or k exceeds its size
+     * @throws std::runtime_error if the QL iteration fails to converge
+     */
+    explicit SymmetricEigen(const Matrix<T, Blocking>& a, mat_size_t k = 0) {
+        const mat_size_t n = a.shape(0);
+        if (n == 0 || a.shape(1) == 0)
+            throw typename Matrix<T, Blocking>::empty_matrix();
+        if (a.shape(1) != n || k > n)
+            throw typename Matrix<T, Blocking>::size_mismatch();
+        if (k == 0)
+            k = n;
+
+        Matrix<T, Blocking> reduced = a;
+        std::vector<T> d(n), e(n - 1), tau(n - 1);
+        matmul::tridiagonalize<T, Blocking>(n, &reduced(0, 0), n, d.data(), e.data(), tau.data());
+
+        std::vector<T> all = d;
+        matmul::tridiagonalEigenvalues(n, all.data(), e.data());
+        values.assign(all.rbegin(), all.rbegin() + k);
+
+        vectors = Matrix<T, Blocking>(std::make_pair(n, k));
+        matmul::tridiagonalEigenvectors(n, d.data(), e.data(), k, values.data(), &vectors(0, 0), k);
+        matmul::tridiagonalApply<T, Blocking>(n, &reduced(0, 0), n, tau.data(), k, &vectors(0, 0), k);
+    }
+
+    /**
+     * @return The k largest eigenvalues, in descending order.
+     */
+    const std::vector<T>& eigenvalues() const {
+        return values;
+    }
+
+    /**
+     * @return The n x k matrix of orthonormal eigenvectors, column j belonging to eigenvalues()[j].
+     */
+    const Matrix<T, Blocking>& eigenvectors() const {
+        return vectors;
+    }
+
+private:
+    std::vector<T> values;
+    Matrix<T, Blocking> vectors;
+};
+
+/**
+ * Singular value decomposition A = U * diag(sigma) * V^T restricted to the k largest singular values, computed
+ * from the eigendecomposition of the smaller of A^T * A and A * A^T.
+ *
+ * @tparam T Floating point element type
+ * @tparam Blocking Cache blocking of the SYRK and GEMM calls (see blocking.h)
+ */
+template <typename T, typename Blocking = DefaultBlocking<T> >
+class SVD {
+public:
+    /**
+     * @param a An m x n matrix.
+     * @param k Number of singular triplets to compute, or 0 for min(m, n)
+     * @throws Matrix<T>::empty_matrix if a is empty
+     * @throws Matrix<T>::size_mismatch if k exceeds min(m, n)
+     */
+    explicit SVD(const Matrix<T, Blocking>& a, mat_size_t k = 0) {
+        const mat_size_t m = a.shape(0), n = a.shape(1);
+        if (m == 0 || n == 0)
+            throw typename Matrix<T, Blocking>::empty_matrix();
+        if (k > std::min(m, n))
+            throw typename Matrix<T, Blocking>::size_mismatch();
+
+        // Eigenvectors of the smaller Gram matrix give one side, A or A^T times them the other
+        const bool tall = m >= n;
+        const SymmetricEigen<T, Blocking> eig(syrk(a, tall ? matmul::TRANSPOSE : matmul::NO_TRANSPOSE), k);
+        const mat_size_t rank = static_cast<mat_size_t>(eig.eigenvalues().size());
+        const Matrix<T, Blocking>& small = eig.eigenvectors();
+        Matrix<T, Blocking> other = Matrix<T, Blocking>(std::make_pair(tall ? m : n, rank));
+        matmul::gemm<T, Blocking>(tall ? matmul::NO_TRANSPOSE : matmul::TRANSPOSE, matmul::NO_TRANSPOSE,
+                                  tall ? m : n, rank, tall ? n : m, T(1), &a(0, 0), n, &small(0, 0), rank,
+                                  T(0), &other(0, 0), rank);
+
+        // Columns of the other side are scaled to unit length; those of zero singular values are left zero
+        values.resize(rank);
+        for (mat_size_t j = 0; j < rank; ++j) {
+            values[j] = std::sqrt(std::max(eig.eigenvalues()[j], T(0)));
+            const T inv = values[j] > T(0) ? T(1) / values[j] : T(0);
+            for (mat_size_t i = 0; i < other.shape(0); ++i)
+                other(i, j) *= inv;
+        }  // j
+        left = tall ? other : small;
+        right = tall ? small : other;
+    }
+
+    /**
+     * @return The k largest singular values, in descending order.
+     */
+    const std::vector<T>& singularValues() const {
+        return values;
+    }
+
+    /**
+     * @return The m x k matrix of left singular vectors.
+     */
+    const Matrix<T, Blocking>& u() const {
+        return left;
+    }
+
+    /**
+     * @return The n x k matrix of right singular vectors.
+     */
+    const Matrix<T, Blocking>& v() const {
+        return right;
+    }
+
+private:
+    std::vector<T> values;
+    Matrix<T, Blocking> left, right;
+};
+
+#endif //MATRIX_EIGEN_H
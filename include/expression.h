@@ -0,0 +1,369 @@
+#ifndef MATRIX_EXPRESSION_H
+#define MATRIX_EXPRESSION_H
+
+#include <cstddef>
+#include <algorithm>
+#include <type_traits>
+
+#include "gemm.h"
+#include "threadPool.h"
+#include "matrix.h"
+
+/**
+ * Expression templates for linear combinations of matrices and matrix products, such as A * B + 2 * C * D - E.
+ * Operators build a tree of lightweight nodes that only reference their operands; nothing is computed until the
+ * tree is assigned to a Matrix. Every supported expression is linear in its terms, so evaluation splits it into
+ * its elementwise part, computed in one fused pass over the output, and its product terms, each of which then goes
+ * through matmul::gemm with beta = 1 so that adding it to the output happens in the micro-kernel's store. No
+ * intermediate matrix is created unless a product has a compound operand, e.g. (A + B) * C, whose operand is
+ * evaluated first.
+ *
+ * Matrix * Matrix keeps its eager meaning; wrap either operand in lazy() to defer the product into an expression.
+ * Operands must stay alive until the expression is assigned.
+ */
+namespace matmul {
+
+    /**
+     * Base of every expression node, E being the node itself.
+     */
+    template <typename E>
+    struct MatrixExpression {
+        const E& self() const {
+            return static_cast<const E&>(*this);
+        }
+    };
+
+    /**
+     * A matrix referenced by an expression.
+     */
+    template <typename T, typename Blocking>
+    class MatrixLeaf : public MatrixExpression<MatrixLeaf<T, Blocking> > {
+    public:
+        typedef T value_type;
+        typedef Blocking blocking_type;
+        enum { HAS_ELEMENTWISE = 1, HAS_PRODUCTS = 0 };
+
+        /**
+         * @throws Matrix<T>::empty_matrix if mat is empty
+         */
+        explicit MatrixLeaf(const Matrix<T, Blocking>& mat) : mat(&mat) {
+            if (mat.shape(0) == 0 || mat.shape(1) == 0)
+                throw typename Matrix<T, Blocking>::empty_matrix();
+            data = &mat(0, 0);
+        }
+
+        mat_size_t rows() const { return mat->shape(0); }
+        mat_size_t cols() const { return mat->shape(1); }
+        const Matrix<T, Blocking>& matrix() const { return *mat; }
+
+        T elementwise(std::size_t idx) const {
+            return data[idx];
+        }
+
+        template <typename F>
+        void forEachProduct(T, F&) const {}
+
+        bool references(const void* m) const {
+            return mat == m;
+        }
+
+    private:
+        const Matrix<T, Blocking>* mat;
+        const T* data;
+    };
+
+    /**
+     * coef * E.
+     */
+    template <typename E>
+    class ScaledExpression : public MatrixExpression<ScaledExpression<E> > {
+    public:
+        typedef typename E::value_type value_type;
+        typedef typename E::blocking_type blocking_type;
+        enum { HAS_ELEMENTWISE = E::HAS_ELEMENTWISE, HAS_PRODUCTS = E::HAS_PRODUCTS };
+
+        ScaledExpression(value_type coef, const E& e) : coef(coef), e(e) {}
+
+        mat_size_t rows() const { return e.rows(); }
+        mat_size_t cols() const { return e.cols(); }
+
+        value_type elementwise(std::size_t idx) const {
+            return coef * e.elementwise(idx);
+        }
+
+        template <typename F>
+        void forEachProduct(value_type outer, F& f) const {
+            e.forEachProduct(outer * coef, f);
+        }
+
+        bool references(const void* m) const {
+            return e.references(m);
+        }
+
+    private:
+        value_type coef;
+        E e;
+    };
+
+    /**
+     * L + R, or L - R when SUBTRACT is set.
+     */
+    template <typename L, typename R, bool SUBTRACT>
+    class SumExpression : public MatrixExpression<SumExpression<L, R, SUBTRACT> > {
+    public:
+        typedef typename L::value_type value_type;
+        typedef typename L::blocking_type blocking_type;
+        enum {
+            HAS_ELEMENTWISE = L::HAS_ELEMENTWISE || R::HAS_ELEMENTWISE,
+            HAS_PRODUCTS = L::HAS_PRODUCTS || R::HAS_PRODUCTS
+        };
+
+        /**
+         * @throws Matrix<T>::size_mismatch if the operands differ in shape
+         */
+        SumExpression(const L& l, const R& r) : l(l), r(r) {
+            if (l.rows() != r.rows() || l.cols() != r.cols())
+                throw typename Matrix<value_type, blocking_type>::size_mismatch();
+        }
+
+        mat_size_t rows() const { return l.rows(); }
+        mat_size_t cols() const { return l.cols(); }
+
+        value_type elementwise(std::size_t idx) const {
+            return SUBTRACT ? l.elementwise(idx) - r.elementwise(idx) : l.elementwise(idx) + r.elementwise(idx);
+        }
+
+        template <typename F>
+        void forEachProduct(value_type outer, F& f) const {
+            l.forEachProduct(outer, f);
+            r.forEachProduct(SUBTRACT ? -outer : outer, f);
+        }
+
+        bool references(const void* m) const {
+            return l.references(m) || r.references(m);
+        }
+
+    private:
+        L l;
+        R r;
+    };
+
+    /**
+     * L * R, computed by the GEMM when the expression is evaluated. Contributes nothing to the elementwise pass.
+     */
+    template <typename L, typename R>
+    class ProductExpression : public MatrixExpression<ProductExpression<L, R> > {
+    public:
+        typedef typename L::value_type value_type;
+        typedef typename L::blocking_type blocking_type;
+        enum { HAS_ELEMENTWISE = 0, HAS_PRODUCTS = 1 };
+
+        /**
+         * @throws Matrix<T>::size_mismatch if the inner dimensions differ
+         */
+        ProductExpression(const L& l, const R& r) : l(l), r(r) {
+            if (l.cols() != r.rows())
+                throw typename Matrix<value_type, blocking_type>::size_mismatch();
+        }
+
+        mat_size_t rows() const { return l.rows(); }
+        mat_size_t cols() const { return r.cols(); }
+        const L& left() const { return l; }
+        const R& right() const { return r; }
+
+        value_type elementwise(std::size_t) const {
+            return value_type(0);
+        }
+
+        template <typename F>
+        void forEachProduct(value_type outer, F& f) const {
+            f(outer, *this);
+        }
+
+        bool references(const void* m) const {
+            return l.references(m) || r.references(m);
+        }
+
+    private:
+        L l;
+        R r;
+    };
+
+    /**
+     * The matrix behind a product operand: a leaf's own matrix, or a compound operand evaluated into tmp.
+     */
+    template <typename T, typename Blocking>
+    inline const Matrix<T, Blocking>& operandMatrix(const MatrixLeaf<T, Blocking>& leaf, Matrix<T, Blocking>&) {
+        return leaf.matrix();
+    }
+
+    template <typename T, typename Blocking, typename E>
+    inline const Matrix<T, Blocking>& operandMatrix(const E& e, Matrix<T, Blocking>& tmp) {
+        tmp = e;
+        return tmp;
+    }
+
+    /**
+     * Adds coef times each product term to the output with the GEMM. The first product overwrites the output if the
+     * expression has no elementwise part.
+     */
+    template <typename T, typename Blocking>
+    struct ProductAccumulator {
+        Matrix<T, Blocking>* dst;
+        bool overwrite;
+
+        template <typename L, typename R>
+        void operator()(T coef, const ProductExpression<L, R>& p) {
+            Matrix<T, Blocking> tmpA, tmpB;
+            const Matrix<T, Blocking>& a = operandMatrix(p.left(), tmpA);
+            const Matrix<T, Blocking>& b = operandMatrix(p.right(), tmpB);
+            const mat_size_t m = a.shape(0), k = a.shape(1), n = b.shape(1);
+            gemm<T, Blocking>(NO_TRANSPOSE, NO_TRANSPOSE, m, n, k, coef, &a(0, 0), k, &b(0, 0), n,
+                              overwrite ? T(0) : T(1), &(*dst)(0, 0), n);
+            overwrite = false;
+        }
+    };
+
+    /**
+     * Elements per task of the elementwise pass.
+     */
+    const std::size_t EXPRESSION_CHUNK = 1u << 14;
+
+    /**
+     * Evaluates expr into dst, which already has its shape. dst must not be an operand of any product in expr;
+     * elementwise operands may alias it, since each element is read before it is written.
+     */
+    template <typename T, typename Blocking, typename E>
+    void evaluateInto(Matrix<T, Blocking>& dst, const E& expr) {
+        if (E::HAS_ELEMENTWISE) {
+            T* out = &dst(0, 0);
+            const std::size_t size = static_cast<std::size_t>(expr.rows()) * expr.cols();
+            const std::size_t nTasks = (size + EXPRESSION_CHUNK - 1) / EXPRESSION_CHUNK;
+            ThreadPool::instance().parallelFor(nTasks, [out, size, &expr](std::size_t t) {
+                const std::size_t end = std::min(size, (t + 1) * EXPRESSION_CHUNK);
+                for (std::size_t idx = t * EXPRESSION_CHUNK; idx < end; ++idx)
+                    out[idx] = expr.elementwise(idx);
+            });
+        }
+        ProductAccumulator<T, Blocking> products = {&dst, !E::HAS_ELEMENTWISE};
+        expr.forEachProduct(T(1), products);
+    }
+
+    /**
+     * Assigns expr to dst, reshaping dst if needed. Evaluates through a temporary only when dst is an operand of a
+     * product in expr.
+     */
+    template <typename T, typename Blocking, typename E>
+    void assignExpression(Matrix<T, Blocking>& dst, const E& expr) {
+        static_assert(std::is_same<T, typename E::value_type>::value, "Expression element type must match");
+        if (E::HAS_PRODUCTS && expr.references(&dst)) {
+            Matrix<T, Blocking> tmp = Matrix<T, Blocking>(std::make_pair(expr.rows(), expr.cols()));
+            evaluateInto(tmp, expr);
+            dst = tmp;
+            return;
+        }
+        if (dst.shape(0) != expr.rows() || dst.shape(1) != expr.cols())
+            dst = Matrix<T, Blocking>(std::make_pair(expr.rows(), expr.cols()));
+        evaluateInto(dst, expr);
+    }
+
+    /**
+     * Maps the operands of the expression operators to expression nodes: a Matrix to a leaf referencing it, an
+     * expression to itself. VALUE is 0 for anything else, which disables the operators.
+     */
+    template <typename X, typename Enable = void>
+    struct ExpressionTraits {
+        enum { VALUE = 0, MATRIX = 0 };
+    };
+
+    template <typename T, typename Blocking>
+    struct ExpressionTraits<Matrix<T, Blocking> > {
+        enum { VALUE = 1, MATRIX = 1 };
+        typedef MatrixLeaf<T, Blocking> type;
+        typedef T value_type;
+
+        static type wrap(const Matrix<T, Blocking>& m) {
+            return type(m);
+        }
+    };
+
+    template <typename X>
+    struct ExpressionTraits<X, typename std::enable_if<std::is_base_of<MatrixExpression<X>, X>::value>::type> {
+        enum { VALUE = 1, MATRIX = 0 };
+        typedef X type;
+        typedef typename X::value_type value_type;
+
+        static const X& wrap(const X& x) {
+            return x;
+        }
+    };
+}
+
+/**
+ * Defers products of plain matrices: lazy(a) * b is a product node rather than an eagerly computed Matrix.
+ */
+template <typename T, typename Blocking>
+matmul::MatrixLeaf<T, Blocking> lazy(const Matrix<T, Blocking>& mat) {
+    return matmul::MatrixLeaf<T, Blocking>(mat);
+}
+
+template <typename L, typename R>
+typename std::enable_if<matmul::ExpressionTraits<L>::VALUE && matmul::ExpressionTraits<R>::VALUE,
+        matmul::SumExpression<typename matmul::ExpressionTraits<L>::type,
+                              typename matmul::ExpressionTraits<R>::type, false> >::type
+operator+(const L& l, const R& r) {
+    return matmul::SumExpression<typename matmul::ExpressionTraits<L>::type,
+                                 typename matmul::ExpressionTraits<R>::type, false>(
+            matmul::ExpressionTraits<L>::wrap(l), matmul::ExpressionTraits<R>::wrap(r));
+}
+
+template <typename L, typename R>
+typename std::enable_if<matmul::ExpressionTraits<L>::VALUE && matmul::ExpressionTraits<R>::VALUE,
+        matmul::SumExpression<typename matmul::ExpressionTraits<L>::type,
+                              typename matmul::ExpressionTraits<R>::type, true> >::type
+operator-(const L& l, const R& r) {
+    return matmul::SumExpression<typename matmul::ExpressionTraits<L>::type,
+                                 typename matmul::ExpressionTraits<R>::type, true>(
+            matmul::ExpressionTraits<L>::wrap(l), matmul::ExpressionTraits<R>::wrap(r));
+}
+
+template <typename X>
+typename std::enable_if<matmul::ExpressionTraits<X>::VALUE,
+        matmul::ScaledExpression<typename matmul::ExpressionTraits<X>::type> >::type
+operator-(const X& x) {
+    typedef typename matmul::ExpressionTraits<X>::value_type T;
+    return matmul::ScaledExpression<typename matmul::ExpressionTraits<X>::type>(
+            T(-1), matmul::ExpressionTraits<X>::wrap(x));
+}
+
+template <typename S, typename X>
+typename std::enable_if<std::is_arithmetic<S>::value && matmul::ExpressionTraits<X>::VALUE,
+        matmul::ScaledExpression<typename matmul::ExpressionTraits<X>::type> >::type
+operator*(S s, const X& x) {
+    typedef typename matmul::ExpressionTraits<X>::value_type T;
+    return matmul::ScaledExpression<typename matmul::ExpressionTraits<X>::type>(
+            static_cast<T>(s), matmul::ExpressionTraits<X>::wrap(x));
+}
+
+template <typename X, typename S>
+typename std::enable_if<std::is_arithmetic<S>::value && matmul::ExpressionTraits<X>::VALUE,
+        matmul::ScaledExpression<typename matmul::ExpressionTraits<X>::type> >::type
+operator*(const X& x, S s) {
+    return s * x;
+}
+
+/**
+ * Lazy product. At least one operand must already be an expression; Matrix * Matrix stays eager.
+ */
+template <typename L, typename R>
+typename std::enable_if<matmul::ExpressionTraits<L>::VALUE && matmul::ExpressionTraits<R>::VALUE &&
+                        !(matmul::ExpressionTraits<L>::MATRIX && matmul::ExpressionTraits<R>::MATRIX),
+        matmul::ProductExpression<typename matmul::ExpressionTraits<L>::type,
+                                  typename matmul::ExpressionTraits<R>::type> >::type
+operator*(const L& l, const R& r) {
+    return matmul::ProductExpression<typename matmul::ExpressionTraits<L>::type,
+                                     typename matmul::ExpressionTraits<R>::type>(
+            matmul::ExpressionTraits<L>::wrap(l), matmul::ExpressionTraits<R>::wrap(r));
+}
+
+#endif //MATRIX_EXPRESSION_H
@@ -0,0 +1,202 @@
+#ifndef MATRIX_FIXEDMATRIX_H
+#define MATRIX_FIXEDMATRIX_H
+
+#include <cstddef>
+#include <sstream>
+#include <initializer_list>
+
+#include "matrix.h"
+
+namespace matmul {
+
+    /**
+     * Calls fn(0), ..., fn(N - 1) through a chain of inlined calls, so loops over compile-time dimensions are
+     * unrolled regardless of the optimizer's unrolling heuristics.
+     */
+    template <mat_size_t N>
+    struct Unroll {
+        template <typename Fn>
+        static inline void run(const Fn& fn) {
+            Unroll<N - 1>::run(fn);
+            fn(N - 1);
+        }
+    };
+
+    template <>
+    struct Unroll<0> {
+        template <typename Fn>
+        static inline void run(const Fn&) {}
+    };
+}
+
+/**
+ * A matrix whose dimensions are template parameters. The elements live inside the object, so small matrices such as
+ * 3 x 3 and 4 x 4 transforms need no heap allocation, and transpose() and operator* are unrolled at compile time
+ * instead of going through the packed GEMM of Matrix. Converts to and from Matrix<T> for mixed expressions.
+ *
+ * @tparam T Element type
+ * @tparam R Number of rows
+ * @tparam C Number of columns
+ */
+template <typename T, mat_size_t R, mat_size_t C>
+class FixedMatrix {
+    static_assert(R > 0 && C > 0, "FixedMatrix dimensions must be positive");
+
+public:
+    enum { ROWS = R, COLS = C };
+
+    /**
+     * Instantiates a matrix of zeros.
+     */
+    FixedMatrix() : elements() {}
+
+    /**
+     * @param values The R x C elements of the matrix, row by row.
+     * @throws Matrix<T>::size_mismatch if there are not exactly R x C values
+     */
+    FixedMatrix(std::initializer_list<T> values) : elements() {
+        if (values.size() != R * C)
+            throw typename Matrix<T>::size_mismatch();
+        std::copy(values.begin(), values.end(), elements);
+    }
+
+    /**
+     * Copies a dynamic matrix of the same shape.
+     * @throws Matrix<T>::size_mismatch if mat is not R x C
+     */
+    template <typename Blocking>
+    explicit FixedMatrix(const Matrix<T, Blocking>& mat) : elements() {
+        if (mat.shape(0) != R || mat.shape(1) != C)
+            throw typename Matrix<T>::size_mismatch();
+        std::copy(mat.cbegin(), mat.cend(), elements);
+    }
+
+    /**
+     * @return A dynamic copy of this matrix.
+     */
+    Matrix<T> toMatrix() const {
+        return Matrix<T>(std::make_pair(R, C), std::vector<T>(elements, elements + R * C));
+    }
+
+    operator Matrix<T>() const {
+        return toMatrix();
+    }
+
+    /**
+     * @param i Selected row
+     * @param j Selected column
+     * @return The element at index [i, j]
+     */
+    inline T& operator()(mat_size_t i, mat_size_t j) {
+        return elements[i * C + j];
+    }
+    inline const T& operator()(mat_size_t i, mat_size_t j) const {
+        return elements[i * C + j];
+    }
+
+    const T* data() const {
+        return elements;
+    }
+
+    /**
+     * @return A new FixedMatrix instance, transposed.
+     */
+    FixedMatrix<T, C, R> transpose() const {
+        FixedMatrix<T, C, R> res;
+        const T* src = elements;
+        matmul::Unroll<R * C>::run([&res, src](mat_size_t idx) {
+            res(idx % C, idx / C) = src[idx];
+        });
+        return res;
+    }
+
+    /**
+     * Multiplication with every element of the result computed as an unrolled dot product.
+     *
+     * @param other An C x N matrix.
+     * @return The R x N product.
+     */
+    template <mat_size_t N>
+    FixedMatrix<T, R, N> operator*(const FixedMatrix<T, C, N>& other) const {
+        FixedMatrix<T, R, N> res;
+        const T* a = elements;
+        const T* b = other.data();
+        matmul::Unroll<R * N>::run([&res, a, b](mat_size_t idx) {
+            const mat_size_t i = idx / N, j = idx % N;
+            T sum = T();
+            matmul::Unroll<C>::run([&sum, a, b, i, j](mat_size_t p) {
+                sum += a[i * C + p] * b[p * N + j];
+            });
+            res(i, j) = sum;
+        });
+        return res;
+    }
+
+    bool operator==(const FixedMatrix& mat) const {
+        for (mat_size_t i = 0; i < R * C; ++i)
+            if (elements[i] != mat.elements[i])
+                return false;
+        return true;
+    }
+
+    bool operator!=(const FixedMatrix& mat) const {
+        return !(*this == mat);
+    }
+
+    /**
+     * @param n 0 for number of rows, 1 for number of columns
+     * @return The requested dimension
+     */
+    mat_size_t shape(mat_size_t n) const {
+        return (n == 0) ? R :
+               (n == 1) ? C :
+               throw typename Matrix<T>::bad_shape();
+    }
+
+    std::string to_string() const {
+        std::stringstream ss;
+        for (mat_size_t i = 0; i < R; ++i) {
+            for (mat_size_t j = 0; j < C; ++j)
+                ss << elements[i * C + j] << "\t";
+            ss << "\n";
+        }
+
+        return ss.str();
+    }
+
+private:
+    T elements[R * C];
+};
+
+/**
+ * Mixed products with a dynamic matrix go through the packed GEMM and return a dynamic matrix.
+ * @throws Matrix<T>::empty_matrix if the dynamic operand is empty
+ * @throws Matrix<T>::size_mismatch if the inner dimensions differ
+ */
+template <typename T, mat_size_t R, mat_size_t C, typename Blocking>
+Matrix<T, Blocking> operator*(const FixedMatrix<T, R, C>& a, const Matrix<T, Blocking>& b) {
+    if (b.shape(0) == 0 || b.shape(1) == 0)
+        throw typename Matrix<T, Blocking>::empty_matrix();
+    if (b.shape(0) != C)
+        throw typename Matrix<T, Blocking>::size_mismatch();
+
+    const mat_size_t n = b.shape(1);
+    Matrix<T, Blocking> res = Matrix<T, Blocking>(std::make_pair(R, n));
+    matmul::multiply<T, Blocking>(R, n, C, a.data(), C, 1, &b(0, 0), n, 1, &res(0, 0), n);
+    return res;
+}
+
+template <typename T, mat_size_t R, mat_size_t C, typename Blocking>
+Matrix<T, Blocking> operator*(const Matrix<T, Blocking>& a, const FixedMatrix<T, R, C>& b) {
+    if (a.shape(0) == 0 || a.shape(1) == 0)
+        throw typename Matrix<T, Blocking>::empty_matrix();
+    if (a.shape(1) != R)
+        throw typename Matrix<T, Blocking>::size_mismatch();
+
+    const mat_size_t m = a.shape(0);
+    Matrix<T, Blocking> res = Matrix<T, Blocking>(std::make_pair(m, C));
+    matmul::multiply<T, Blocking>(m, C, R, &a(0, 0), R, 1, b.data(), C, 1, &res(0, 0), C);
+    return res;
+}
+
+#endif //MATRIX_FIXEDMATRIX_H
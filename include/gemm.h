@@ -0,0 +1,603 @@
+#ifndef MATRIX_GEMM_H
+#define MATRIX_GEMM_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <type_traits>
+
+#include "blocking.h"
+#include "cpuFeatures.h"
+#include "halfFloat.h"
+#include "kernelsAvx2.h"
+#include "kernelsAvx512.h"
+#include "threadPool.h"
+#include "tuning.h"
+
+/**
+ * Packed-panel matrix multiplication in the style of Goto/BLIS. The operands are copied block by block into
+ * contiguous buffers (A into panels mr rows tall, B into panels nr columns wide, where mr x nr is the register tile of
+ * the micro-kernel) so that the micro-kernel only ever streams through unit-stride memory. Cache blocking follows
+ * the usual loop order: a KC x NC block of B lives in L3, an MC x KC block of A lives in L2, and a single KC x nr
+ * micro-panel of B lives in L1. The block sizes, and the register tile of the portable kernel, come from a blocking
+ * policy (see blocking.h); the host's tuning profile overrides the policy's cache blocks when it has an entry (see
+ * tuning.h).
+ *
+ * All routines take explicit row and column strides, so any of the operands may be a transposed view or a
+ * sub-block of a larger matrix. The operands may also be stored in a narrower type than the one the kernels compute
+ * in (see Accumulator in halfFloat.h): packing converts them on the way into the panels.
+ */
+namespace matmul {
+
+    /**
+     * Whether an operand is used as stored or transposed.
+     */
+    enum Transpose { NO_TRANSPOSE, TRANSPOSE };
+
+    /**
+     * A micro-kernel together with the register tile it computes. The kernel multiplies one packed mr x kc panel of
+     * A with one packed kc x nr panel of B and stores alpha times the valid rows x cols corner of the tile plus beta
+     * times C to C. C is not read when beta is zero.
+     */
+    template <typename T>
+    struct MicroKernel {
+        typedef void (*kernel_fn)(std::size_t kc, const T* a, const T* b, T* c, std::size_t ldc,
+                                  std::size_t rows, std::size_t cols, T alpha, T beta);
+
+        std::size_t mr, nr;
+        kernel_fn fn;
+        const char* name;
+    };
+
+    /**
+     * Returns a pointer into buf aligned to a 64 byte boundary, growing buf so that at least n elements fit
+     * past that boundary.
+     */
+    template <typename T>
+    inline T* alignedBuffer(std::vector<T>& buf, std::size_t n) {
+        const std::size_t pad = 64 / sizeof(T) + 1;
+        if (buf.size() < n + pad)
+            buf.resize(n + pad);
+        std::uintptr_t addr = reinterpret_cast<std::uintptr_t>(buf.data());
+        std::uintptr_t aligned = (addr + 63) & ~static_cast<std::uintptr_t>(63);
+        return buf.data() + (aligned - addr) / sizeof(T);
+    }
+
+    /**
+     * Copies an mc x kc block of A into consecutive mr-row panels. Within a panel the mr elements of each column are
+     * contiguous. Rows past mc in the final panel are zero-filled. Elements are converted from the storage type S to
+     * the compute type T.
+     *
+     * @param a Pointer to the top-left element of the block
+     * @param rs Distance between consecutive rows of A
+     * @param cs Distance between consecutive columns of A
+     * @param mr Height of a panel
+     * @param buf Destination buffer of at least roundUp(mc, mr) * kc elements
+     */
+    template <typename S, typename T>
+    inline void packA(std::size_t mc, std::size_t kc, const S* a, std::ptrdiff_t rs, std::ptrdiff_t cs,
+                      std::size_t mr, T* buf) {
+        for (std::size_t i = 0; i < mc; i += mr) {
+            const std::size_t rows = std::min(mr, mc - i);
+            const S* panel = a + rs * static_cast<std::ptrdiff_t>(i);
+            for (std::size_t k = 0; k < kc; ++k) {
+                const S* col = panel + cs * static_cast<std::ptrdiff_t>(k);
+                std::size_t r;
+                for (r = 0; r < rows; ++r)
+                    buf[r] = static_cast<T>(col[rs * static_cast<std::ptrdiff_t>(r)]);
+                for (; r < mr; ++r)
+                    buf[r] = T(0);
+                buf += mr;
+            }  // k
+        }  // i
+    }
+
+    /**
+     * Copies a kc x nc block of B into consecutive nr-column panels. Within a panel the nr elements of each row are
+     * contiguous. Columns past nc in the final panel are zero-filled. Elements are converted from the storage type S
+     * to the compute type T.
+     *
+     * @param b Pointer to the top-left element of the block
+     * @param rs Distance between consecutive rows of B
+     * @param cs Distance between consecutive columns of B
+     * @param nr Width of a panel
+     * @param buf Destination buffer of at least kc * roundUp(nc, nr) elements
+     */
+    template <typename S, typename T>
+    inline void packB(std::size_t kc, std::size_t nc, const S* b, std::ptrdiff_t rs, std::ptrdiff_t cs,
+                      std::size_t nr, T* buf) {
+        for (std::size_t j = 0; j < nc; j += nr) {
+            const std::size_t cols = std::min(nr, nc - j);
+            const S* panel = b + cs * static_cast<std::ptrdiff_t>(j);
+            for (std::size_t k = 0; k < kc; ++k) {
+                const S* row = panel + rs * static_cast<std::ptrdiff_t>(k);
+                std::size_t c;
+                for (c = 0; c < cols; ++c)
+                    buf[c] = static_cast<T>(row[cs * static_cast<std::ptrdiff_t>(c)]);
+                for (; c < nr; ++c)
+                    buf[c] = T(0);
+                buf += nr;
+            }  // k
+        }  // j
+    }
+
+    /**
+     * Portable micro-kernel used for any T without a hand-vectorized kernel. Keeps the whole MR x NR tile of partial
+     * sums in a local array and leaves vectorization to the compiler.
+     *
+     * @param kc Depth of the panels
+     * @param a Packed panel of A
+     * @param b Packed panel of B
+     * @param c Top-left element of the destination tile in row-major C
+     * @param ldc Row stride of C
+     * @param rows Number of valid rows in the tile (<= MR)
+     * @param cols Number of valid columns in the tile (<= NR)
+     * @param alpha Scale of the product
+     * @param beta Scale of the existing contents of C; zero overwrites C without reading it
+     */
+    template <typename T, int MR, int NR>
+    inline void genericKernel(std::size_t kc, const T* a, const T* b, T* c, std::size_t ldc,
+                              std::size_t rows, std::size_t cols, T alpha, T beta) {
+        T acc[MR][NR];
+        for (int r = 0; r < MR; ++r)
+            for (int s = 0; s < NR; ++s)
+                acc[r][s] = T(0);
+
+        for (std::size_t k = 0; k < kc; ++k) {
+            for (int r = 0; r < MR; ++r) {
+                const T ar = a[r];
+                for (int s = 0; s < NR; ++s)
+                    acc[r][s] += ar * b[s];
+            }  // r
+            a += MR;
+            b += NR;
+        }  // k
+
+        for (std::size_t r = 0; r < rows; ++r) {
+            T* row = c + r * ldc;
+            if (beta == T(0)) {
+                for (std::size_t s = 0; s < cols; ++s)
+                    row[s] = alpha * acc[r][s];
+            } else if (beta == T(1)) {
+                for (std::size_t s = 0; s < cols; ++s)
+                    row[s] += alpha * acc[r][s];
+            } else {
+                for (std::size_t s = 0; s < cols; ++s)
+                    row[s] = alpha * acc[r][s] + beta * row[s];
+            }
+        }  // r
+    }
+
+    /**
+     * @return The portable kernel for T, with the register tile of the blocking policy.
+     */
+    template <typename T, typename Blocking = DefaultBlocking<T> >
+    inline MicroKernel<T> genericMicroKernel() {
+        MicroKernel<T> k = {Blocking::MR, Blocking::NR, &genericKernel<T, Blocking::MR, Blocking::NR>, "generic"};
+        return k;
+    }
+
+    /**
+     * Lists the micro-kernels for T that can run on this host, fastest first. Specialized below for the types that
+     * have hand-vectorized kernels; everything else only has the portable kernel.
+     */
+    template <typename T, typename Blocking = DefaultBlocking<T> >
+    struct KernelSelector {
+        static std::vector<MicroKernel<T> > available() {
+            return std::vector<MicroKernel<T> >(1, genericMicroKernel<T, Blocking>());
+        }
+    };
+
+    template <typename Blocking>
+    struct KernelSelector<float, Blocking> {
+        static std::vector<MicroKernel<float> > available() {
+            std::vector<MicroKernel<float> > kernels;
+#ifdef MATRIX_X86
+            if (cpuFeatures().avx512f) {
+                MicroKernel<float> k = {12, 32, &avx512::sgemm12x32, "avx512"};
+                kernels.push_back(k);
+            }
+            if (cpuFeatures().avx2 && cpuFeatures().fma) {
+                MicroKernel<float> k = {6, 16, &avx2::sgemm6x16, "avx2"};
+                kernels.push_back(k);
+            }
+#endif
+            kernels.push_back(genericMicroKernel<float, Blocking>());
+            return kernels;
+        }
+    };
+
+    template <typename Blocking>
+    struct KernelSelector<double, Blocking> {
+        static std::vector<MicroKernel<double> > available() {
+            std::vector<MicroKernel<double> > kernels;
+#ifdef MATRIX_X86
+            if (cpuFeatures().avx512f) {
+                MicroKernel<double> k = {12, 16, &avx512::dgemm12x16, "avx512"};
+                kernels.push_back(k);
+            }
+            if (cpuFeatures().avx2 && cpuFeatures().fma) {
+                MicroKernel<double> k = {6, 8, &avx2::dgemm6x8, "avx2"};
+                kernels.push_back(k);
+            }
+#endif
+            kernels.push_back(genericMicroKernel<double, Blocking>());
+            return kernels;
+        }
+    };
+
+    /**
+     * @return The micro-kernels for T that can run on this host, fastest first. Computed once, on first use.
+     */
+    template <typename T, typename Blocking = DefaultBlocking<T> >
+    inline const std::vector<MicroKernel<T> >& availableKernels() {
+        static const std::vector<MicroKernel<T> > kernels = KernelSelector<T, Blocking>::available();
+        return kernels;
+    }
+
+    /**
+     * @return The micro-kernel chosen for T on this host.
+     */
+    template <typename T, typename Blocking = DefaultBlocking<T> >
+    inline const MicroKernel<T>& defaultKernel() {
+        return availableKernels<T, Blocking>().front();
+    }
+
+    /**
+     * @return The available kernel called name, or the default kernel if there is none (e.g. a profile written on
+     * a host with a wider instruction set).
+     */
+    template <typename T, typename Blocking = DefaultBlocking<T> >
+    inline const MicroKernel<T>& kernelByName(const std::string& name) {
+        const std::vector<MicroKernel<T> >& kernels = availableKernels<T, Blocking>();
+        for (std::size_t i = 0; i < kernels.size(); ++i)
+            if (name == kernels[i].name)
+                return kernels[i];
+        return kernels.front();
+    }
+
+    /**
+     * @return The compiled-in blocking of the policy, used when the tuning profile has no entry.
+     */
+    template <typename T, typename Blocking = DefaultBlocking<T> >
+    inline GemmBlocking defaultBlocking() {
+        GemmBlocking b;
+        b.kernel = defaultKernel<T, Blocking>().name;
+        b.mc = Blocking::MC;
+        b.kc = Blocking::KC;
+        b.nc = Blocking::NC;
+        return b;
+    }
+
+    /**
+     * @return The blocking for an m x k by k x n product of T, from the host's tuning profile if it has one.
+     */
+    template <typename T, typename Blocking = DefaultBlocking<T> >
+    inline GemmBlocking tunedBlocking(std::size_t m, std::size_t n, std::size_t k) {
+        GemmBlocking b;
+        if (TuningProfile::instance().findGemm(TypeName<T>::get(), classifyShape(m, n, k), b))
+            return b;
+        return defaultBlocking<T, Blocking>();
+    }
+
+    /**
+     * Runs the micro-kernel over every tile of an mc x nc block of C, given the packed A and B blocks that
+     * contribute to it.
+     */
+    template <typename T>
+    inline void macroKernel(const MicroKernel<T>& kernel, std::size_t mc, std::size_t nc, std::size_t kc,
+                            const T* packedA, const T* packedB, T* c, std::size_t ldc, T alpha, T beta) {
+        for (std::size_t j = 0; j < nc; j += kernel.nr) {
+            const std::size_t cols = std::min(kernel.nr, nc - j);
+            const T* b = packedB + j * kc;
+            for (std::size_t i = 0; i < mc; i += kernel.mr) {
+                const std::size_t rows = std::min(kernel.mr, mc - i);
+                kernel.fn(kc, packedA + i * kc, b, c + i * ldc + j, ldc, rows, cols, alpha, beta);
+            }  // i
+        }  // j
+    }
+
+    /**
+     * Packing buffers owned by the calling thread, kept between calls so steady-state multiplications do not
+     * allocate.
+     */
+    template <typename T>
+    struct PackBuffers {
+        std::vector<T> a, b;
+
+        static PackBuffers& local() {
+            static thread_local PackBuffers buffers;
+            return buffers;
+        }
+    };
+
+    /**
+     * Operands, scaling and blocking of one multiplication C = alpha * A * B + beta * C, shared by every tile of it.
+     * The operands are stored as S, the kernel computes in T.
+     */
+    template <typename T, typename S = T>
+    struct GemmProblem {
+        std::size_t m, n, k;
+        const S* a;
+        std::ptrdiff_t rsA, csA;
+        const S* b;
+        std::ptrdiff_t rsB, csB;
+        T* c;
+        std::size_t ldc;
+        T alpha, beta;
+        const MicroKernel<T>* kernel;
+        std::size_t mcBlock, kcBlock, ncBlock;
+    };
+
+    /**
+     * Computes rows [i0, i0 + mSub) and columns [j0, j0 + nSub) of C with the serial blocked loop nest, using the
+     * calling thread's packing buffers.
+     */
+    template <typename T, typename S>
+    void multiplyBlock(const GemmProblem<T, S>& p, std::size_t i0, std::size_t mSub, std::size_t j0,
+                       std::size_t nSub) {
+        const MicroKernel<T>& kernel = *p.kernel;
+        const std::size_t kcMax = std::min(p.kcBlock, p.k);
+        const std::size_t mcMax = std::min(p.mcBlock, mSub);
+        const std::size_t ncMax = std::min(p.ncBlock, nSub);
+        PackBuffers<T>& buffers = PackBuffers<T>::local();
+        T* packedA = alignedBuffer(buffers.a, kcMax * ((mcMax + kernel.mr - 1) / kernel.mr) * kernel.mr);
+        T* packedB = alignedBuffer(buffers.b, kcMax * ((ncMax + kernel.nr - 1) / kernel.nr) * kernel.nr);
+
+        for (std::size_t jc = j0; jc < j0 + nSub; jc += p.ncBlock) {
+            const std::size_t nc = std::min(p.ncBlock, j0 + nSub - jc);
+            for (std::size_t pc = 0; pc < p.k; pc += p.kcBlock) {
+                const std::size_t kc = std::min(p.kcBlock, p.k - pc);
+                packB(kc, nc, p.b + p.rsB * static_cast<std::ptrdiff_t>(pc) + p.csB * static_cast<std::ptrdiff_t>(jc),
+                      p.rsB, p.csB, kernel.nr, packedB);
+                for (std::size_t ic = i0; ic < i0 + mSub; ic += p.mcBlock) {
+                    const std::size_t mc = std::min(p.mcBlock, i0 + mSub - ic);
+                    packA(mc, kc,
+                          p.a + p.rsA * static_cast<std::ptrdiff_t>(ic) + p.csA * static_cast<std::ptrdiff_t>(pc),
+                          p.rsA, p.csA, kernel.mr, packedA);
+                    // Later depth blocks add to the partial sums of the first
+                    macroKernel(kernel, mc, nc, kc, packedA, packedB, p.c + ic * p.ldc + jc, p.ldc,
+                                p.alpha, pc != 0 ? T(1) : p.beta);
+                }  // ic
+            }  // pc
+        }  // jc
+    }
+
+    /**
+     * Below this many multiply-adds a product is not worth waking the thread pool for.
+     */
+    const std::size_t PARALLEL_MIN_FLOPS = 1u << 20;
+
+    /**
+     * Splits an m x n output into a grid of tiles, one row block tall and a multiple of the register tile wide, and
+     * calls block(i0, mSub, j0, nSub) for each of them on the thread pool. Products of fewer than PARALLEL_MIN_FLOPS
+     * multiply-adds are computed as a single tile on the calling thread.
+     *
+     * @param mcBlock Row block size, a multiple of the register tile height
+     * @param ncBlock Column block size, a multiple of nr
+     * @param nr Register tile width
+     */
+    template <typename Fn>
+    void forEachTile(std::size_t m, std::size_t n, std::size_t k, std::size_t mcBlock, std::size_t ncBlock,
+                     std::size_t nr, const Fn& block) {
+        ThreadPool& pool = ThreadPool::instance();
+        const std::size_t threads = pool.size();
+        if (threads == 1 || m * n * k < PARALLEL_MIN_FLOPS) {
+            block(0, m, 0, n);
+            return;
+        }
+
+        // Cut the columns into enough tiles that there are a few tiles per thread
+        const std::size_t rowTiles = (m + mcBlock - 1) / mcBlock;
+        const std::size_t colPanels = (n + nr - 1) / nr;
+        std::size_t colTiles = std::max((4 * threads + rowTiles - 1) / rowTiles, (n + ncBlock - 1) / ncBlock);
+        colTiles = std::min(colTiles, colPanels);
+        const std::size_t tileWidth = (colPanels + colTiles - 1) / colTiles * nr;
+        colTiles = (n + tileWidth - 1) / tileWidth;
+
+        pool.parallelFor(rowTiles * colTiles, [&block, m, n, mcBlock, colTiles, tileWidth](std::size_t t) {
+            const std::size_t i0 = (t / colTiles) * mcBlock;
+            const std::size_t j0 = (t % colTiles) * tileWidth;
+            block(i0, std::min(mcBlock, m - i0), j0, std::min(tileWidth, n - j0));
+        });
+    }
+
+    /**
+     * Computes C = alpha * A * B + beta * C for an m x k matrix A and a k x n matrix B, updating the row-major m x n
+     * matrix C in place. Strides describe how A and B are laid out, so transposed operands cost nothing extra. The
+     * scaling is fused into the micro-kernel's store, so C is never zero-filled or swept a second time, and with beta
+     * zero it is not read at all.
+     *
+     * Large products are split into a grid of output tiles, one row block tall and a multiple of the register tile
+     * wide, which the thread pool schedules by work stealing. Each tile packs its own panels, so threads share
+     * nothing but the read-only operands.
+     *
+     * @param rsA Distance between consecutive rows of A
+     * @param csA Distance between consecutive columns of A
+     * @param rsB Distance between consecutive rows of B
+     * @param csB Distance between consecutive columns of B
+     * @param ldc Row stride of C
+     * @param kernel Micro-kernel to use
+     * @param blocking Row, depth and column block sizes; the kernel name in it is ignored
+     */
+    template <typename T, typename S>
+    void gemm(std::size_t m, std::size_t n, std::size_t k, T alpha,
+              const S* a, std::ptrdiff_t rsA, std::ptrdiff_t csA,
+              const S* b, std::ptrdiff_t rsB, std::ptrdiff_t csB,
+              T beta, T* c, std::size_t ldc,
+              const MicroKernel<T>& kernel, const GemmBlocking& blocking) {
+        if (k == 0) {
+            // No depth block to fuse the scaling into
+            for (std::size_t i = 0; i < m; ++i)
+                for (std::size_t j = 0; j < n; ++j)
+                    c[i * ldc + j] = beta == T(0) ? T(0) : beta * c[i * ldc + j];
+            return;
+        }
+
+        GemmProblem<T, S> p;
+        p.m = m; p.n = n; p.k = k;
+        p.a = a; p.rsA = rsA; p.csA = csA;
+        p.b = b; p.rsB = rsB; p.csB = csB;
+        p.c = c; p.ldc = ldc;
+        p.alpha = alpha; p.beta = beta;
+        p.kernel = &kernel;
+        // Keep the blocks a whole number of register tiles so only the last one has a ragged panel
+        p.mcBlock = std::max<std::size_t>(blocking.mc / kernel.mr, 1) * kernel.mr;
+        p.kcBlock = std::max<std::size_t>(blocking.kc, 1);
+        p.ncBlock = std::max<std::size_t>(blocking.nc / kernel.nr, 1) * kernel.nr;
+
+        forEachTile(m, n, k, p.mcBlock, p.ncBlock, kernel.nr,
+                    [&p](std::size_t i0, std::size_t mSub, std::size_t j0, std::size_t nSub) {
+                        multiplyBlock(p, i0, mSub, j0, nSub);
+                    });
+    }
+
+    /**
+     * Computes C = A * B; the same as gemm() with alpha one and beta zero.
+     */
+    template <typename T, typename S>
+    void multiply(std::size_t m, std::size_t n, std::size_t k,
+                  const S* a, std::ptrdiff_t rsA, std::ptrdiff_t csA,
+                  const S* b, std::ptrdiff_t rsB, std::ptrdiff_t csB,
+                  T* c, std::size_t ldc,
+                  const MicroKernel<T>& kernel, const GemmBlocking& blocking) {
+        gemm(m, n, k, T(1), a, rsA, csA, b, rsB, csB, T(0), c, ldc, kernel, blocking);
+    }
+
+    /**
+     * Same as above with the given micro-kernel and the host's tuned cache blocking, falling back to the policy's.
+     */
+    template <typename T, typename Blocking = DefaultBlocking<T> >
+    void multiply(std::size_t m, std::size_t n, std::size_t k,
+                  const T* a, std::ptrdiff_t rsA, std::ptrdiff_t csA,
+                  const T* b, std::ptrdiff_t rsB, std::ptrdiff_t csB,
+                  T* c, std::size_t ldc,
+                  const MicroKernel<T>& kernel) {
+        multiply(m, n, k, a, rsA, csA, b, rsB, csB, c, ldc, kernel, tunedBlocking<T, Blocking>(m, n, k));
+    }
+
+    /**
+     * Stores a product computed in the accumulator type straight into C.
+     */
+    template <typename T>
+    void multiplyInto(std::size_t m, std::size_t n, std::size_t k,
+                      const T* a, std::ptrdiff_t rsA, std::ptrdiff_t csA,
+                      const T* b, std::ptrdiff_t rsB, std::ptrdiff_t csB,
+                      T* c, std::size_t ldc,
+                      const MicroKernel<T>& kernel, const GemmBlocking& blocking, std::true_type) {
+        multiply(m, n, k, a, rsA, csA, b, rsB, csB, c, ldc, kernel, blocking);
+    }
+
+    /**
+     * Computes the product of a storage-only type in its accumulator type Acc and converts it into C at the end, so
+     * the partial sums of successive depth blocks are never rounded to T.
+     */
+    template <typename T, typename Acc>
+    void multiplyInto(std::size_t m, std::size_t n, std::size_t k,
+                      const T* a, std::ptrdiff_t rsA, std::ptrdiff_t csA,
+                      const T* b, std::ptrdiff_t rsB, std::ptrdiff_t csB,
+                      T* c, std::size_t ldc,
+                      const MicroKernel<Acc>& kernel, const GemmBlocking& blocking, std::false_type) {
+        std::vector<Acc> acc(m * n);
+        multiply(m, n, k, a, rsA, csA, b, rsB, csB, acc.data(), n, kernel, blocking);
+        for (std::size_t i = 0; i < m; ++i)
+            convertArray(n, acc.data() + i * n, c + i * ldc);
+    }
+
+    /**
+     * Same as above with the host's tuned kernel and cache blocking, falling back to the policy's. Storage-only
+     * types are multiplied in their accumulator type (see Accumulator in halfFloat.h).
+     */
+    template <typename T, typename Blocking = DefaultBlocking<T> >
+    void multiply(std::size_t m, std::size_t n, std::size_t k,
+                  const T* a, std::ptrdiff_t rsA, std::ptrdiff_t csA,
+                  const T* b, std::ptrdiff_t rsB, std::ptrdiff_t csB,
+                  T* c, std::size_t ldc) {
+        typedef typename Accumulator<T>::type Acc;
+        const GemmBlocking blocking = tunedBlocking<Acc, Blocking>(m, n, k);
+        multiplyInto(m, n, k, a, rsA, csA, b, rsB, csB, c, ldc, kernelByName<Acc, Blocking>(blocking.kernel), blocking,
+                     typename std::is_same<T, Acc>::type());
+    }
+
+    /**
+     * Row and column strides of op(X) for a row-major matrix X with row stride ld. A transposed operand is read in
+     * place by swapping them.
+     */
+    inline void operandStrides(Transpose trans, std::size_t ld, std::ptrdiff_t& rs, std::ptrdiff_t& cs) {
+        rs = trans == TRANSPOSE ? 1 : static_cast<std::ptrdiff_t>(ld);
+        cs = trans == TRANSPOSE ? static_cast<std::ptrdiff_t>(ld) : 1;
+    }
+
+    /**
+     * Computes C = op(A) * op(B), where op(X) is X or X^T, for row-major A and B. op(A) is m x k and op(B) is k x n;
+     * packing reads transposed operands straight from their original layout.
+     *
+     * @param lda Row stride of A as stored
+     * @param ldb Row stride of B as stored
+     * @param ldc Row stride of C
+     */
+    template <typename T, typename Blocking = DefaultBlocking<T> >
+    void multiply(Transpose transA, Transpose transB, std::size_t m, std::size_t n, std::size_t k,
+                  const T* a, std::size_t lda, const T* b, std::size_t ldb, T* c, std::size_t ldc) {
+        std::ptrdiff_t rsA, csA, rsB, csB;
+        operandStrides(transA, lda, rsA, csA);
+        operandStrides(transB, ldb, rsB, csB);
+        multiply<T, Blocking>(m, n, k, a, rsA, csA, b, rsB, csB, c, ldc);
+    }
+
+    /**
+     * Updates C in place with the kernel computing in the accumulator type.
+     */
+    template <typename T>
+    void gemmInto(std::size_t m, std::size_t n, std::size_t k, T alpha,
+                  const T* a, std::ptrdiff_t rsA, std::ptrdiff_t csA,
+                  const T* b, std::ptrdiff_t rsB, std::ptrdiff_t csB,
+                  T beta, T* c, std::size_t ldc,
+                  const MicroKernel<T>& kernel, const GemmBlocking& blocking, std::true_type) {
+        gemm(m, n, k, alpha, a, rsA, csA, b, rsB, csB, beta, c, ldc, kernel, blocking);
+    }
+
+    /**
+     * Updates C of a storage-only type through a copy in its accumulator type Acc, converted back once at the end.
+     */
+    template <typename T, typename Acc>
+    void gemmInto(std::size_t m, std::size_t n, std::size_t k, T alpha,
+                  const T* a, std::ptrdiff_t rsA, std::ptrdiff_t csA,
+                  const T* b, std::ptrdiff_t rsB, std::ptrdiff_t csB,
+                  T beta, T* c, std::size_t ldc,
+                  const MicroKernel<Acc>& kernel, const GemmBlocking& blocking, std::false_type) {
+        std::vector<Acc> acc(m * n);
+        const Acc accBeta = static_cast<Acc>(beta);
+        if (accBeta != Acc(0))
+            for (std::size_t i = 0; i < m; ++i)
+                convertArray(n, c + i * ldc, acc.data() + i * n);
+        gemm(m, n, k, static_cast<Acc>(alpha), a, rsA, csA, b, rsB, csB, accBeta, acc.data(), n, kernel, blocking);
+        for (std::size_t i = 0; i < m; ++i)
+            convertArray(n, acc.data() + i * n, c + i * ldc);
+    }
+
+    /**
+     * Computes C = alpha * op(A) * op(B) + beta * C in place, BLAS style, for row-major A, B and C, with the host's
+     * tuned kernel and cache blocking. op(A) is m x k and op(B) is k x n. Does not allocate for types that are
+     * their own accumulator type, so it suits steady-state loops that reuse C.
+     *
+     * @param lda Row stride of A as stored
+     * @param ldb Row stride of B as stored
+     * @param ldc Row stride of C
+     */
+    template <typename T, typename Blocking = DefaultBlocking<T> >
+    void gemm(Transpose transA, Transpose transB, std::size_t m, std::size_t n, std::size_t k,
+              T alpha, const T* a, std::size_t lda, const T* b, std::size_t ldb,
+              T beta, T* c, std::size_t ldc) {
+        typedef typename Accumulator<T>::type Acc;
+        std::ptrdiff_t rsA, csA, rsB, csB;
+        operandStrides(transA, lda, rsA, csA);
+        operandStrides(transB, ldb, rsB, csB);
+        const GemmBlocking blocking = tunedBlocking<Acc, Blocking>(m, n, k);
+        gemmInto(m, n, k, alpha, a, rsA, csA, b, rsB, csB, beta, c, ldc, kernelByName<Acc, Blocking>(blocking.kernel),
+                 blocking, typename std::is_same<T, Acc>::type());
+    }
+}
+
+#endif //MATRIX_GEMM_H
@@ -0,0 +1,357 @@
+#ifndef MATRIX_GEMV_H
+#define MATRIX_GEMV_H
+
+#include <cstddef>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+
+#include "cpuFeatures.h"
+#include "kernelsAvx2.h"
+#include "kernelsAvx512.h"
+#include "simdVector.h"
+#include "halfFloat.h"
+#include "gemm.h"
+#include "threadPool.h"
+
+/**
+ * Matrix-vector products. A product with a single column reads every element of A exactly once and does two flops
+ * per element, so it is bound by memory bandwidth: packing A as the GEMM does would double the traffic for nothing.
+ * These kernels stream A in place instead. y = A * x runs GEMV_ROWS rows at a time, each a vectorized dot product
+ * with x; y = A^T * x runs strips of columns at a time, with the strip of y held in registers while the rows of A
+ * go by. Both are split across the thread pool, by rows and by columns respectively, so no two threads write the
+ * same part of y. gemvSymmetric() combines the two over the tiles of one triangle.
+ */
+namespace matmul {
+
+    /**
+     * Rows of A per dot product pass; x is loaded once for all of them.
+     */
+    const std::size_t GEMV_ROWS = 4;
+
+    /**
+     * Vectors of y per column strip of the transposed product.
+     */
+    const int GEMV_STRIP = 4;
+
+    /**
+     * Tile edge of the symmetric product. Both products of a tile read it while it is still in L2.
+     */
+    const std::size_t GEMV_SYMMETRIC_TILE = 64;
+
+    /**
+     * Computes y[r] = A[r, :] * x for MR rows of A.
+     */
+    template <typename T, int W, int MR>
+    inline void gemvRows(std::size_t n, const T* a, std::size_t lda, const T* x, T* y) {
+        T sum[MR];
+        std::size_t j = 0;
+#ifdef MATRIX_VECTOR_EXTENSIONS
+        typedef typename SimdVector<T, W>::type V;
+        V acc[MR];
+        for (int r = 0; r < MR; ++r)
+            acc[r] = V{};
+        for (; j + W <= n; j += W) {
+            V xv;
+            std::memcpy(&xv, x + j, sizeof(V));
+            for (int r = 0; r < MR; ++r) {
+                V av;
+                std::memcpy(&av, a + r * lda + j, sizeof(V));
+                acc[r] += av * xv;
+            }  // r
+        }  // j
+        for (int r = 0; r < MR; ++r) {
+            sum[r] = T();
+            for (int s = 0; s < W; ++s)
+                sum[r] += acc[r][s];
+        }  // r
+#else
+        for (int r = 0; r < MR; ++r)
+            sum[r] = T();
+#endif
+        for (; j < n; ++j)
+            for (int r = 0; r < MR; ++r)
+                sum[r] += a[r * lda + j] * x[j];
+        for (int r = 0; r < MR; ++r)
+            y[r] = sum[r];
+    }
+
+    /**
+     * Computes y = A * x for an m x n block of A.
+     */
+    template <typename T, int W>
+    inline void gemvBlock(std::size_t m, std::size_t n, const T* a, std::size_t lda, const T* x, T* y) {
+        std::size_t i = 0;
+        for (; i + GEMV_ROWS <= m; i += GEMV_ROWS)
+            gemvRows<T, W, GEMV_ROWS>(n, a + i * lda, lda, x, y + i);
+        for (; i < m; ++i)
+            gemvRows<T, W, 1>(n, a + i * lda, lda, x, y + i);
+    }
+
+    /**
+     * Computes y[j0, j0 + NV * W) = A[:, j0, j0 + NV * W)^T * x for the m rows of A.
+     */
+    template <typename T, int W, int NV>
+    inline void gemvTransposedStrip(std::size_t m, std::size_t j0, const T* a, std::size_t lda, const T* x, T* y) {
+#ifdef MATRIX_VECTOR_EXTENSIONS
+        typedef typename SimdVector<T, W>::type V;
+        V acc[NV];
+        for (int q = 0; q < NV; ++q)
+            acc[q] = V{};
+        for (std::size_t i = 0; i < m; ++i) {
+            const T xi = x[i];
+            for (int q = 0; q < NV; ++q) {
+                V av;
+                std::memcpy(&av, a + i * lda + j0 + q * W, sizeof(V));
+                acc[q] += xi * av;
+            }  // q
+        }  // i
+        std::memcpy(y + j0, acc, sizeof(acc));
+#else
+        for (int s = 0; s < NV * W; ++s)
+            y[j0 + s] = T();
+        for (std::size_t i = 0; i < m; ++i)
+            for (int s = 0; s < NV * W; ++s)
+                y[j0 + s] += x[i] * a[i * lda + j0 + s];
+#endif
+    }
+
+    /**
+     * Computes y[j0, j1) = A[:, j0, j1)^T * x for the m rows of A.
+     */
+    template <typename T, int W>
+    inline void gemvTransposedBlock(std::size_t m, std::size_t j0, std::size_t j1, const T* a, std::size_t lda,
+                                    const T* x, T* y) {
+        std::size_t j = j0;
+        for (; j + GEMV_STRIP * W <= j1; j += GEMV_STRIP * W)
+            gemvTransposedStrip<T, W, GEMV_STRIP>(m, j, a, lda, x, y);
+        for (; j + W <= j1; j += W)
+            gemvTransposedStrip<T, W, 1>(m, j, a, lda, x, y);
+        for (; j < j1; ++j)
+            gemvTransposedStrip<T, 1, 1>(m, j, a, lda, x, y);
+    }
+
+    /**
+     * Instantiations of the kernels for each instruction set; see smallGemmGeneric in batched.h.
+     */
+    template <typename T>
+    __attribute__((flatten))
+    void gemvGeneric(std::size_t m, std::size_t n, const T* a, std::size_t lda, const T* x, T* y) {
+        gemvBlock<T, (sizeof(T) <= 16 ? 16 / sizeof(T) : 1)>(m, n, a, lda, x, y);
+    }
+
+    template <typename T>
+    __attribute__((flatten))
+    void gemvTransposedGeneric(std::size_t m, std::size_t j0, std::size_t j1, const T* a, std::size_t lda,
+                               const T* x, T* y) {
+        gemvTransposedBlock<T, (sizeof(T) <= 16 ? 16 / sizeof(T) : 1)>(m, j0, j1, a, lda, x, y);
+    }
+
+#ifdef MATRIX_X86
+    template <typename T>
+    MATRIX_TARGET_AVX2 __attribute__((flatten))
+    void gemvAvx2(std::size_t m, std::size_t n, const T* a, std::size_t lda, const T* x, T* y) {
+        gemvBlock<T, 32 / sizeof(T)>(m, n, a, lda, x, y);
+    }
+
+    template <typename T>
+    MATRIX_TARGET_AVX2 __attribute__((flatten))
+    void gemvTransposedAvx2(std::size_t m, std::size_t j0, std::size_t j1, const T* a, std::size_t lda,
+                            const T* x, T* y) {
+        gemvTransposedBlock<T, 32 / sizeof(T)>(m, j0, j1, a, lda, x, y);
+    }
+
+    template <typename T>
+    MATRIX_TARGET_AVX512 __attribute__((flatten))
+    void gemvAvx512(std::size_t m, std::size_t n, const T* a, std::size_t lda, const T* x, T* y) {
+        gemvBlock<T, 64 / sizeof(T)>(m, n, a, lda, x, y);
+    }
+
+    template <typename T>
+    MATRIX_TARGET_AVX512 __attribute__((flatten))
+    void gemvTransposedAvx512(std::size_t m, std::size_t j0, std::size_t j1, const T* a, std::size_t lda,
+                              const T* x, T* y) {
+        gemvTransposedBlock<T, 64 / sizeof(T)>(m, j0, j1, a, lda, x, y);
+    }
+#endif
+
+    /**
+     * Scalar kernels for types the vector extensions cannot hold, summing in the accumulator type (see
+     * Accumulator in halfFloat.h).
+     */
+    template <typename T>
+    void gemvScalar(std::size_t m, std::size_t n, const T* a, std::size_t lda, const T* x, T* y) {
+        typedef typename Accumulator<T>::type Acc;
+        for (std::size_t i = 0; i < m; ++i) {
+            Acc sum = Acc();
+            for (std::size_t j = 0; j < n; ++j)
+                sum += static_cast<Acc>(a[i * lda + j]) * static_cast<Acc>(x[j]);
+            y[i] = static_cast<T>(sum);
+        }  // i
+    }
+
+    template <typename T>
+    void gemvTransposedScalar(std::size_t m, std::size_t j0, std::size_t j1, const T* a, std::size_t lda,
+                              const T* x, T* y) {
+        typedef typename Accumulator<T>::type Acc;
+        for (std::size_t j = j0; j < j1; ++j) {
+            Acc sum = Acc();
+            for (std::size_t i = 0; i < m; ++i)
+                sum += static_cast<Acc>(x[i]) * static_cast<Acc>(a[i * lda + j]);
+            y[j] = static_cast<T>(sum);
+        }  // j
+    }
+
+    /**
+     * Picks the GEMV kernels for T once, from the host's instruction sets.
+     */
+    template <typename T, bool arithmetic = std::is_arithmetic<T>::value>
+    struct GemvKernels {
+        typedef void (*gemv_fn)(std::size_t m, std::size_t n, const T* a, std::size_t lda, const T* x, T* y);
+        typedef void (*gemv_t_fn)(std::size_t m, std::size_t j0, std::size_t j1, const T* a, std::size_t lda,
+                                  const T* x, T* y);
+
+        gemv_fn gemv;
+        gemv_t_fn gemvTransposed;
+
+        GemvKernels() : gemv(&gemvGeneric<T>), gemvTransposed(&gemvTransposedGeneric<T>) {
+#ifdef MATRIX_X86
+            if (std::is_floating_point<T>::value && cpuFeatures().avx512f) {
+                gemv = &gemvAvx512<T>;
+                gemvTransposed = &gemvTransposedAvx512<T>;
+            } else if (cpuFeatures().avx2 && cpuFeatures().fma) {
+                gemv = &gemvAvx2<T>;
+                gemvTransposed = &gemvTransposedAvx2<T>;
+            }
+#endif
+        }
+
+        static const GemvKernels& get() {
+            static const GemvKernels kernels;
+            return kernels;
+        }
+    };
+
+    template <typename T>
+    struct GemvKernels<T, false> {
+        typedef void (*gemv_fn)(std::size_t m, std::size_t n, const T* a, std::size_t lda, const T* x, T* y);
+        typedef void (*gemv_t_fn)(std::size_t m, std::size_t j0, std::size_t j1, const T* a, std::size_t lda,
+                                  const T* x, T* y);
+
+        gemv_fn gemv;
+        gemv_t_fn gemvTransposed;
+
+        GemvKernels() : gemv(&gemvScalar<T>), gemvTransposed(&gemvTransposedScalar<T>) {}
+
+        static const GemvKernels& get() {
+            static const GemvKernels kernels;
+            return kernels;
+        }
+    };
+
+    /**
+     * Number of tasks to split a product of m x n elements of A into, along a dimension of length len handed out in
+     * multiples of unit. Products of fewer than PARALLEL_MIN_FLOPS / 2 elements run on one thread.
+     */
+    inline std::size_t gemvTasks(std::size_t m, std::size_t n, std::size_t len, std::size_t unit) {
+        const std::size_t threads = ThreadPool::instance().size();
+        if (threads == 1 || m * n < PARALLEL_MIN_FLOPS / 2)
+            return 1;
+        return std::max<std::size_t>(std::min((len + unit - 1) / unit, 4 * threads), 1);
+    }
+
+    /**
+     * Computes y = A * x for a row-major m x n matrix A.
+     *
+     * @param lda Row stride of A
+     * @param x Vector of n elements
+     * @param y Vector of m elements, overwritten
+     */
+    template <typename T>
+    void gemv(std::size_t m, std::size_t n, const T* a, std::size_t lda, const T* x, T* y) {
+        const typename GemvKernels<T>::gemv_fn kernel = GemvKernels<T>::get().gemv;
+        const std::size_t nTasks = gemvTasks(m, n, m, GEMV_ROWS);
+        if (nTasks == 1) {
+            kernel(m, n, a, lda, x, y);
+            return;
+        }
+        const std::size_t units = (m + GEMV_ROWS - 1) / GEMV_ROWS;
+        ThreadPool::instance().parallelFor(nTasks, [=](std::size_t t) {
+            const std::size_t i0 = std::min(m, units * t / nTasks * GEMV_ROWS);
+            const std::size_t i1 = std::min(m, units * (t + 1) / nTasks * GEMV_ROWS);
+            kernel(i1 - i0, n, a + i0 * lda, lda, x, y + i0);
+        });
+    }
+
+    /**
+     * Computes y = A^T * x for a row-major m x n matrix A, without forming the transpose.
+     *
+     * @param lda Row stride of A
+     * @param x Vector of m elements
+     * @param y Vector of n elements, overwritten
+     */
+    template <typename T>
+    void gemvTransposed(std::size_t m, std::size_t n, const T* a, std::size_t lda, const T* x, T* y) {
+        const typename GemvKernels<T>::gemv_t_fn kernel = GemvKernels<T>::get().gemvTransposed;
+        const std::size_t strip = 64;
+        const std::size_t nTasks = gemvTasks(m, n, n, strip);
+        if (nTasks == 1) {
+            kernel(m, 0, n, a, lda, x, y);
+            return;
+        }
+        const std::size_t units = (n + strip - 1) / strip;
+        ThreadPool::instance().parallelFor(nTasks, [=](std::size_t t) {
+            const std::size_t j0 = std::min(n, units * t / nTasks * strip);
+            const std::size_t j1 = std::min(n, units * (t + 1) / nTasks * strip);
+            kernel(m, j0, j1, a, lda, x, y);
+        });
+    }
+
+    /**
+     * Computes y = A * x for a row-major n x n symmetric matrix A, reading only the tiles on and below its diagonal,
+     * half the memory traffic of gemv(). Each tile below the diagonal adds its product and its transposed product in
+     * turn. Tasks take every nTasks-th row of tiles, each into its own copy of y.
+     *
+     * @param lda Row stride of A
+     * @param x Vector of n elements
+     * @param y Vector of n elements, overwritten
+     */
+    template <typename T>
+    void gemvSymmetric(std::size_t n, const T* a, std::size_t lda, const T* x, T* y) {
+        const GemvKernels<T>& kernels = GemvKernels<T>::get();
+        const std::size_t tile = GEMV_SYMMETRIC_TILE, tiles = (n + tile - 1) / tile;
+        const std::size_t nTasks = gemvTasks(n, n / 2, tiles, 1);
+        std::vector<T> partial((nTasks - 1) * n, T(0));
+        std::fill(y, y + n, T(0));
+        auto task = [&](std::size_t t) {
+            T* sum = t == 0 ? y : partial.data() + (t - 1) * n;
+            T tmp[GEMV_SYMMETRIC_TILE];
+            for (std::size_t q = t; q < tiles; q += nTasks) {
+                const std::size_t r0 = q * tile, rows = std::min(tile, n - r0);
+                const T* strip = a + r0 * lda;
+                for (std::size_t c0 = 0; c0 < r0; c0 += tile) {
+                    kernels.gemv(rows, tile, strip + c0, lda, x + c0, tmp);
+                    for (std::size_t i = 0; i < rows; ++i)
+                        sum[r0 + i] += tmp[i];
+                    kernels.gemvTransposed(rows, 0, tile, strip + c0, lda, x + r0, tmp);
+                    for (std::size_t j = 0; j < tile; ++j)
+                        sum[c0 + j] += tmp[j];
+                }  // c0
+                kernels.gemv(rows, rows, strip + r0, lda, x + r0, tmp);
+                for (std::size_t i = 0; i < rows; ++i)
+                    sum[r0 + i] += tmp[i];
+            }  // q
+        };
+        if (nTasks == 1) {
+            task(0);
+            return;
+        }
+        ThreadPool::instance().parallelFor(nTasks, task);
+        for (std::size_t t = 1; t < nTasks; ++t)
+            for (std::size_t i = 0; i < n; ++i)
+                y[i] += partial[(t - 1) * n + i];
+    }
+}
+
+#endif //MATRIX_GEMV_H
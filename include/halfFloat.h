@@ -0,0 +1,222 @@
+#ifndef MATRIX_HALFFLOAT_H
+#define MATRIX_HALFFLOAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "blocking.h"
+#include "cpuFeatures.h"
+#include "kernelsAvx2.h"
+
+/**
+ * 16-bit floating point storage types. They only store values: arithmetic converts to float, and a Matrix of
+ * either type is multiplied in single precision (see Accumulator below), so halving the memory footprint and
+ * bandwidth of the operands costs no accuracy in the sums.
+ */
+
+/**
+ * Converts a float to the bit pattern of the nearest bfloat16, ties to even.
+ */
+inline uint16_t floatToBfloat16Bits(float f) {
+    uint32_t bits;
+    std::memcpy(&bits, &f, sizeof(bits));
+    if ((bits & 0x7FFFFFFFu) > 0x7F800000u)
+        return static_cast<uint16_t>((bits | 0x400000u) >> 16);  // Keep NaNs quiet
+    bits += 0x7FFFu + ((bits >> 16) & 1u);
+    return static_cast<uint16_t>(bits >> 16);
+}
+
+inline float bfloat16BitsToFloat(uint16_t h) {
+    const uint32_t bits = static_cast<uint32_t>(h) << 16;
+    float f;
+    std::memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+/**
+ * Converts a float to the bit pattern of the nearest IEEE binary16 value, ties to even. Values beyond the half
+ * precision range become infinities, values below it subnormals or zeros.
+ */
+inline uint16_t floatToFloat16Bits(float f) {
+    uint32_t bits;
+    std::memcpy(&bits, &f, sizeof(bits));
+    const uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000u);
+    const uint32_t abs = bits & 0x7FFFFFFFu;
+
+    if (abs > 0x7F800000u)
+        return static_cast<uint16_t>(sign | 0x7E00u | ((abs >> 13) & 0x3FFu));  // Quiet NaN
+    if (abs >= 0x477FF000u)
+        return static_cast<uint16_t>(sign | 0x7C00u);  // Rounds to infinity
+    if (abs <= 0x33000000u)
+        return sign;  // Rounds to zero
+
+    const int exp = static_cast<int>(abs >> 23) - 127 + 15;
+    uint32_t mant = abs & 0x7FFFFFu;
+    uint32_t shift = 13;
+    uint32_t h;
+    if (exp > 0) {
+        h = (static_cast<uint32_t>(exp) << 10) | (mant >> 13);
+    } else {
+        // Subnormal: make the implicit bit explicit and shift it into place
+        mant |= 0x800000u;
+        shift = static_cast<uint32_t>(14 - exp);
+        h = mant >> shift;
+    }
+    const uint32_t rem = mant & ((1u << shift) - 1);
+    const uint32_t half = 1u << (shift - 1);
+    if (rem > half || (rem == half && (h & 1u)))
+        ++h;  // A carry out of the mantissa correctly bumps the exponent
+    return static_cast<uint16_t>(sign | h);
+}
+
+inline float float16BitsToFloat(uint16_t h) {
+    const uint32_t sign = static_cast<uint32_t>(h & 0x8000u) << 16;
+    uint32_t exp = (h >> 10) & 0x1Fu;
+    uint32_t mant = h & 0x3FFu;
+    uint32_t bits;
+    if (exp == 0x1Fu) {
+        bits = sign | 0x7F800000u | (mant << 13);
+    } else if (exp != 0) {
+        bits = sign | ((exp + 127 - 15) << 23) | (mant << 13);
+    } else if (mant == 0) {
+        bits = sign;
+    } else {
+        // Subnormal: normalize the mantissa
+        exp = 127 - 15 + 1;
+        while ((mant & 0x400u) == 0) {
+            mant <<= 1;
+            --exp;
+        }
+        bits = sign | (exp << 23) | ((mant & 0x3FFu) << 13);
+    }
+    float f;
+    std::memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+/**
+ * Brain floating point: the upper 16 bits of a float (8 exponent bits, 7 mantissa bits).
+ */
+struct bfloat16 {
+    uint16_t bits;
+
+    bfloat16() : bits(0) {}
+    bfloat16(float f) : bits(floatToBfloat16Bits(f)) {}
+
+    static bfloat16 fromBits(uint16_t bits) {
+        bfloat16 h;
+        h.bits = bits;
+        return h;
+    }
+
+    operator float() const {
+        return bfloat16BitsToFloat(bits);
+    }
+
+    bfloat16& operator+=(float x) { return *this = bfloat16(float(*this) + x); }
+    bfloat16& operator-=(float x) { return *this = bfloat16(float(*this) - x); }
+    bfloat16& operator*=(float x) { return *this = bfloat16(float(*this) * x); }
+    bfloat16& operator/=(float x) { return *this = bfloat16(float(*this) / x); }
+};
+
+/**
+ * IEEE 754 binary16 (5 exponent bits, 10 mantissa bits).
+ */
+struct float16 {
+    uint16_t bits;
+
+    float16() : bits(0) {}
+    float16(float f) : bits(floatToFloat16Bits(f)) {}
+
+    static float16 fromBits(uint16_t bits) {
+        float16 h;
+        h.bits = bits;
+        return h;
+    }
+
+    operator float() const {
+        return float16BitsToFloat(bits);
+    }
+
+    float16& operator+=(float x) { return *this = float16(float(*this) + x); }
+    float16& operator-=(float x) { return *this = float16(float(*this) - x); }
+    float16& operator*=(float x) { return *this = float16(float(*this) * x); }
+    float16& operator/=(float x) { return *this = float16(float(*this) / x); }
+};
+
+/**
+ * The packed panels of a half precision product hold floats, so the half types block like float.
+ */
+template <> struct DefaultBlocking<bfloat16> : DefaultBlocking<float> {};
+template <> struct DefaultBlocking<float16> : DefaultBlocking<float> {};
+
+namespace matmul {
+
+    /**
+     * Type in which products of T are packed, multiplied and summed. Storage-only types accumulate in a wider type,
+     * and are converted while packing and once more when the result is stored.
+     */
+    template <typename T> struct Accumulator { typedef T type; };
+    template <> struct Accumulator<bfloat16> { typedef float type; };
+    template <> struct Accumulator<float16> { typedef float type; };
+
+    /**
+     * Converts n values element by element. Overloaded below with vectorized versions for the half types.
+     */
+    template <typename From, typename To>
+    inline void convertArray(std::size_t n, const From* src, To* dst) {
+        for (std::size_t i = 0; i < n; ++i)
+            dst[i] = static_cast<To>(src[i]);
+    }
+
+    inline void convertArray(std::size_t n, const bfloat16* src, float* dst) {
+        const uint16_t* bits = reinterpret_cast<const uint16_t*>(src);
+#ifdef MATRIX_X86
+        if (cpuFeatures().avx2) {
+            avx2::bfloat16ToFloat(n, bits, dst);
+            return;
+        }
+#endif
+        for (std::size_t i = 0; i < n; ++i)
+            dst[i] = bfloat16BitsToFloat(bits[i]);
+    }
+
+    inline void convertArray(std::size_t n, const float* src, bfloat16* dst) {
+        uint16_t* bits = reinterpret_cast<uint16_t*>(dst);
+#ifdef MATRIX_X86
+        if (cpuFeatures().avx2) {
+            avx2::floatToBfloat16(n, src, bits);
+            return;
+        }
+#endif
+        for (std::size_t i = 0; i < n; ++i)
+            bits[i] = floatToBfloat16Bits(src[i]);
+    }
+
+    inline void convertArray(std::size_t n, const float16* src, float* dst) {
+        const uint16_t* bits = reinterpret_cast<const uint16_t*>(src);
+#ifdef MATRIX_X86
+        if (cpuFeatures().f16c && cpuFeatures().avx2) {
+            avx2::float16ToFloat(n, bits, dst);
+            return;
+        }
+#endif
+        for (std::size_t i = 0; i < n; ++i)
+            dst[i] = float16BitsToFloat(bits[i]);
+    }
+
+    inline void convertArray(std::size_t n, const float* src, float16* dst) {
+        uint16_t* bits = reinterpret_cast<uint16_t*>(dst);
+#ifdef MATRIX_X86
+        if (cpuFeatures().f16c && cpuFeatures().avx2) {
+            avx2::floatToFloat16(n, src, bits);
+            return;
+        }
+#endif
+        for (std::size_t i = 0; i < n; ++i)
+            bits[i] = floatToFloat16Bits(src[i]);
+    }
+}
+
+#endif //MATRIX_HALFFLOAT_H
@@ -0,0 +1,386 @@
+#ifndef MATRIX_KERNELSAVX2_H
+#define MATRIX_KERNELSAVX2_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "cpuFeatures.h"
+
+#ifdef MATRIX_X86
+#include <immintrin.h>
+
+#define MATRIX_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define MATRIX_TARGET_F16C __attribute__((target("avx2,f16c")))
+
+/**
+ * Hand-vectorized AVX2/FMA micro-kernels. They are compiled with a function-level target attribute rather than a
+ * global -mavx2, so the same binary still runs on hosts without AVX2; gemm.h only hands them out when cpuFeatures()
+ * says the host supports them. Signatures match matmul::genericKernel.
+ */
+namespace matmul {
+namespace avx2 {
+
+    /**
+     * Writes alpha times a full or partial tile held in a scratch buffer plus beta times C to C, without reading C
+     * when beta is zero.
+     */
+    template <typename T>
+    inline void storePartial(const T* tile, std::size_t tileCols, T* c, std::size_t ldc,
+                             std::size_t mr, std::size_t nr, T alpha, T beta) {
+        for (std::size_t r = 0; r < mr; ++r) {
+            T* row = c + r * ldc;
+            const T* src = tile + r * tileCols;
+            if (beta == T(0)) {
+                for (std::size_t s = 0; s < nr; ++s)
+                    row[s] = alpha * src[s];
+            } else {
+                for (std::size_t s = 0; s < nr; ++s)
+                    row[s] = alpha * src[s] + beta * row[s];
+            }
+        }  // r
+    }
+
+    /**
+     * Writes (or adds) a full or partial tile held in a scratch buffer to C.
+     */
+    template <typename T>
+    inline void storePartial(const T* tile, std::size_t tileCols, T* c, std::size_t ldc,
+                             std::size_t mr, std::size_t nr, bool accumulate) {
+        for (std::size_t r = 0; r < mr; ++r) {
+            T* row = c + r * ldc;
+            const T* src = tile + r * tileCols;
+            if (accumulate) {
+                for (std::size_t s = 0; s < nr; ++s)
+                    row[s] += src[s];
+            } else {
+                for (std::size_t s = 0; s < nr; ++s)
+                    row[s] = src[s];
+            }
+        }  // r
+    }
+
+    /**
+     * Stores alpha * v + beta * C to a row of C, without reading C when beta is zero.
+     */
+    MATRIX_TARGET_AVX2
+    inline void storeRow(float* c, __m256 v0, __m256 v1, float alpha, float beta) {
+        const __m256 va = _mm256_set1_ps(alpha);
+        if (beta == 0.0f) {
+            v0 = _mm256_mul_ps(va, v0);
+            v1 = _mm256_mul_ps(va, v1);
+        } else {
+            const __m256 vb = _mm256_set1_ps(beta);
+            v0 = _mm256_fmadd_ps(va, v0, _mm256_mul_ps(vb, _mm256_loadu_ps(c + 0)));
+            v1 = _mm256_fmadd_ps(va, v1, _mm256_mul_ps(vb, _mm256_loadu_ps(c + 8)));
+        }
+        _mm256_storeu_ps(c + 0, v0);
+        _mm256_storeu_ps(c + 8, v1);
+    }
+
+    MATRIX_TARGET_AVX2
+    inline void storeRow(double* c, __m256d v0, __m256d v1, double alpha, double beta) {
+        const __m256d va = _mm256_set1_pd(alpha);
+        if (beta == 0.0) {
+            v0 = _mm256_mul_pd(va, v0);
+            v1 = _mm256_mul_pd(va, v1);
+        } else {
+            const __m256d vb = _mm256_set1_pd(beta);
+            v0 = _mm256_fmadd_pd(va, v0, _mm256_mul_pd(vb, _mm256_loadu_pd(c + 0)));
+            v1 = _mm256_fmadd_pd(va, v1, _mm256_mul_pd(vb, _mm256_loadu_pd(c + 4)));
+        }
+        _mm256_storeu_pd(c + 0, v0);
+        _mm256_storeu_pd(c + 4, v1);
+    }
+
+    /**
+     * 6 x 16 single precision micro-kernel: twelve ymm accumulators, two ymm loads of B and six broadcasts of A per
+     * step of k.
+     */
+    MATRIX_TARGET_AVX2
+    inline void sgemm6x16(std::size_t kc, const float* a, const float* b, float* c, std::size_t ldc,
+                          std::size_t mr, std::size_t nr, float alpha, float beta) {
+        __m256 c00 = _mm256_setzero_ps(), c01 = _mm256_setzero_ps();
+        __m256 c10 = _mm256_setzero_ps(), c11 = _mm256_setzero_ps();
+        __m256 c20 = _mm256_setzero_ps(), c21 = _mm256_setzero_ps();
+        __m256 c30 = _mm256_setzero_ps(), c31 = _mm256_setzero_ps();
+        __m256 c40 = _mm256_setzero_ps(), c41 = _mm256_setzero_ps();
+        __m256 c50 = _mm256_setzero_ps(), c51 = _mm256_setzero_ps();
+
+        for (std::size_t k = 0; k < kc; ++k) {
+            const __m256 b0 = _mm256_loadu_ps(b + 0);
+            const __m256 b1 = _mm256_loadu_ps(b + 8);
+            __m256 ar;
+
+            ar = _mm256_broadcast_ss(a + 0);
+            c00 = _mm256_fmadd_ps(ar, b0, c00); c01 = _mm256_fmadd_ps(ar, b1, c01);
+            ar = _mm256_broadcast_ss(a + 1);
+            c10 = _mm256_fmadd_ps(ar, b0, c10); c11 = _mm256_fmadd_ps(ar, b1, c11);
+            ar = _mm256_broadcast_ss(a + 2);
+            c20 = _mm256_fmadd_ps(ar, b0, c20); c21 = _mm256_fmadd_ps(ar, b1, c21);
+            ar = _mm256_broadcast_ss(a + 3);
+            c30 = _mm256_fmadd_ps(ar, b0, c30); c31 = _mm256_fmadd_ps(ar, b1, c31);
+            ar = _mm256_broadcast_ss(a + 4);
+            c40 = _mm256_fmadd_ps(ar, b0, c40); c41 = _mm256_fmadd_ps(ar, b1, c41);
+            ar = _mm256_broadcast_ss(a + 5);
+            c50 = _mm256_fmadd_ps(ar, b0, c50); c51 = _mm256_fmadd_ps(ar, b1, c51);
+
+            a += 6;
+            b += 16;
+        }  // k
+
+        if (mr == 6 && nr == 16) {
+            storeRow(c + 0 * ldc, c00, c01, alpha, beta);
+            storeRow(c + 1 * ldc, c10, c11, alpha, beta);
+            storeRow(c + 2 * ldc, c20, c21, alpha, beta);
+            storeRow(c + 3 * ldc, c30, c31, alpha, beta);
+            storeRow(c + 4 * ldc, c40, c41, alpha, beta);
+            storeRow(c + 5 * ldc, c50, c51, alpha, beta);
+        } else {
+            float tile[6 * 16];
+            storeRow(tile + 0 * 16, c00, c01, 1.0f, 0.0f);
+            storeRow(tile + 1 * 16, c10, c11, 1.0f, 0.0f);
+            storeRow(tile + 2 * 16, c20, c21, 1.0f, 0.0f);
+            storeRow(tile + 3 * 16, c30, c31, 1.0f, 0.0f);
+            storeRow(tile + 4 * 16, c40, c41, 1.0f, 0.0f);
+            storeRow(tile + 5 * 16, c50, c51, 1.0f, 0.0f);
+            storePartial(tile, 16, c, ldc, mr, nr, alpha, beta);
+        }
+    }
+
+    /**
+     * 6 x 8 double precision micro-kernel, laid out like sgemm6x16 with four doubles per ymm register.
+     */
+    MATRIX_TARGET_AVX2
+    inline void dgemm6x8(std::size_t kc, const double* a, const double* b, double* c, std::size_t ldc,
+                         std::size_t mr, std::size_t nr, double alpha, double beta) {
+        __m256d c00 = _mm256_setzero_pd(), c01 = _mm256_setzero_pd();
+        __m256d c10 = _mm256_setzero_pd(), c11 = _mm256_setzero_pd();
+        __m256d c20 = _mm256_setzero_pd(), c21 = _mm256_setzero_pd();
+        __m256d c30 = _mm256_setzero_pd(), c31 = _mm256_setzero_pd();
+        __m256d c40 = _mm256_setzero_pd(), c41 = _mm256_setzero_pd();
+        __m256d c50 = _mm256_setzero_pd(), c51 = _mm256_setzero_pd();
+
+        for (std::size_t k = 0; k < kc; ++k) {
+            const __m256d b0 = _mm256_loadu_pd(b + 0);
+            const __m256d b1 = _mm256_loadu_pd(b + 4);
+            __m256d ar;
+
+            ar = _mm256_broadcast_sd(a + 0);
+            c00 = _mm256_fmadd_pd(ar, b0, c00); c01 = _mm256_fmadd_pd(ar, b1, c01);
+            ar = _mm256_broadcast_sd(a + 1);
+            c10 = _mm256_fmadd_pd(ar, b0, c10); c11 = _mm256_fmadd_pd(ar, b1, c11);
+            ar = _mm256_broadcast_sd(a + 2);
+            c20 = _mm256_fmadd_pd(ar, b0, c20); c21 = _mm256_fmadd_pd(ar, b1, c21);
+            ar = _mm256_broadcast_sd(a + 3);
+            c30 = _mm256_fmadd_pd(ar, b0, c30); c31 = _mm256_fmadd_pd(ar, b1, c31);
+            ar = _mm256_broadcast_sd(a + 4);
+            c40 = _mm256_fmadd_pd(ar, b0, c40); c41 = _mm256_fmadd_pd(ar, b1, c41);
+            ar = _mm256_broadcast_sd(a + 5);
+            c50 = _mm256_fmadd_pd(ar, b0, c50); c51 = _mm256_fmadd_pd(ar, b1, c51);
+
+            a += 6;
+            b += 8;
+        }  // k
+
+        if (mr == 6 && nr == 8) {
+            storeRow(c + 0 * ldc, c00, c01, alpha, beta);
+            storeRow(c + 1 * ldc, c10, c11, alpha, beta);
+            storeRow(c + 2 * ldc, c20, c21, alpha, beta);
+            storeRow(c + 3 * ldc, c30, c31, alpha, beta);
+            storeRow(c + 4 * ldc, c40, c41, alpha, beta);
+            storeRow(c + 5 * ldc, c50, c51, alpha, beta);
+        } else {
+            double tile[6 * 8];
+            storeRow(tile + 0 * 8, c00, c01, 1.0, 0.0);
+            storeRow(tile + 1 * 8, c10, c11, 1.0, 0.0);
+            storeRow(tile + 2 * 8, c20, c21, 1.0, 0.0);
+            storeRow(tile + 3 * 8, c30, c31, 1.0, 0.0);
+            storeRow(tile + 4 * 8, c40, c41, 1.0, 0.0);
+            storeRow(tile + 5 * 8, c50, c51, 1.0, 0.0);
+            storePartial(tile, 8, c, ldc, mr, nr, alpha, beta);
+        }
+    }
+
+    MATRIX_TARGET_AVX2
+    inline void storeRow(int32_t* c, __m256i v, bool accumulate) {
+        if (accumulate)
+            v = _mm256_add_epi32(v, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(c)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(c), v);
+    }
+
+    /**
+     * Widens the four unsigned bytes at a to 16 bits and broadcasts them to every 64-bit lane.
+     */
+    MATRIX_TARGET_AVX2
+    inline __m256i broadcastQuad(const uint8_t* a) {
+        int32_t quad;
+        std::memcpy(&quad, a, sizeof(quad));
+        return _mm256_broadcastq_epi64(_mm_cvtepu8_epi16(_mm_cvtsi32_si128(quad)));
+    }
+
+    /**
+     * Sums the two halves of every column: v0 holds columns 0-3 and v1 columns 4-7, each as two adjacent partial
+     * sums.
+     */
+    MATRIX_TARGET_AVX2
+    inline __m256i reducePairs(__m256i v0, __m256i v1) {
+        return _mm256_permute4x64_epi64(_mm256_hadd_epi32(v0, v1), _MM_SHUFFLE(3, 1, 2, 0));
+    }
+
+    /**
+     * 6 x 8 quantized micro-kernel: unsigned 8-bit A times signed 8-bit B, accumulated in 32 bits. The panels are
+     * packed in groups of four k (see quantized.h); kq is the number of groups. pmaddubsw would saturate the 16-bit
+     * pair sums, so both operands are widened to 16 bits and multiplied with pmaddwd, which is exact.
+     */
+    MATRIX_TARGET_AVX2
+    inline void qgemm6x8(std::size_t kq, const uint8_t* a, const int8_t* b, int32_t* c, std::size_t ldc,
+                         std::size_t mr, std::size_t nr, bool accumulate) {
+        __m256i c00 = _mm256_setzero_si256(), c01 = _mm256_setzero_si256();
+        __m256i c10 = _mm256_setzero_si256(), c11 = _mm256_setzero_si256();
+        __m256i c20 = _mm256_setzero_si256(), c21 = _mm256_setzero_si256();
+        __m256i c30 = _mm256_setzero_si256(), c31 = _mm256_setzero_si256();
+        __m256i c40 = _mm256_setzero_si256(), c41 = _mm256_setzero_si256();
+        __m256i c50 = _mm256_setzero_si256(), c51 = _mm256_setzero_si256();
+
+        for (std::size_t q = 0; q < kq; ++q) {
+            const __m256i bq = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b));
+            const __m256i b0 = _mm256_cvtepi8_epi16(_mm256_castsi256_si128(bq));
+            const __m256i b1 = _mm256_cvtepi8_epi16(_mm256_extracti128_si256(bq, 1));
+            __m256i ar;
+
+            ar = broadcastQuad(a + 0);
+            c00 = _mm256_add_epi32(c00, _mm256_madd_epi16(ar, b0));
+            c01 = _mm256_add_epi32(c01, _mm256_madd_epi16(ar, b1));
+            ar = broadcastQuad(a + 4);
+            c10 = _mm256_add_epi32(c10, _mm256_madd_epi16(ar, b0));
+            c11 = _mm256_add_epi32(c11, _mm256_madd_epi16(ar, b1));
+            ar = broadcastQuad(a + 8);
+            c20 = _mm256_add_epi32(c20, _mm256_madd_epi16(ar, b0));
+            c21 = _mm256_add_epi32(c21, _mm256_madd_epi16(ar, b1));
+            ar = broadcastQuad(a + 12);
+            c30 = _mm256_add_epi32(c30, _mm256_madd_epi16(ar, b0));
+            c31 = _mm256_add_epi32(c31, _mm256_madd_epi16(ar, b1));
+            ar = broadcastQuad(a + 16);
+            c40 = _mm256_add_epi32(c40, _mm256_madd_epi16(ar, b0));
+            c41 = _mm256_add_epi32(c41, _mm256_madd_epi16(ar, b1));
+            ar = broadcastQuad(a + 20);
+            c50 = _mm256_add_epi32(c50, _mm256_madd_epi16(ar, b0));
+            c51 = _mm256_add_epi32(c51, _mm256_madd_epi16(ar, b1));
+
+            a += 6 * 4;
+            b += 8 * 4;
+        }  // q
+
+        const __m256i r0 = reducePairs(c00, c01), r1 = reducePairs(c10, c11), r2 = reducePairs(c20, c21);
+        const __m256i r3 = reducePairs(c30, c31), r4 = reducePairs(c40, c41), r5 = reducePairs(c50, c51);
+        if (mr == 6 && nr == 8) {
+            storeRow(c + 0 * ldc, r0, accumulate);
+            storeRow(c + 1 * ldc, r1, accumulate);
+            storeRow(c + 2 * ldc, r2, accumulate);
+            storeRow(c + 3 * ldc, r3, accumulate);
+            storeRow(c + 4 * ldc, r4, accumulate);
+            storeRow(c + 5 * ldc, r5, accumulate);
+        } else {
+            int32_t tile[6 * 8];
+            storeRow(tile + 0 * 8, r0, false);
+            storeRow(tile + 1 * 8, r1, false);
+            storeRow(tile + 2 * 8, r2, false);
+            storeRow(tile + 3 * 8, r3, false);
+            storeRow(tile + 4 * 8, r4, false);
+            storeRow(tile + 5 * 8, r5, false);
+            storePartial(tile, 8, c, ldc, mr, nr, accumulate);
+        }
+    }
+
+    /**
+     * Widens n bfloat16 values (given as their bit patterns) to float: a bfloat16 is the upper half of a float.
+     */
+    MATRIX_TARGET_AVX2
+    inline void bfloat16ToFloat(std::size_t n, const uint16_t* src, float* dst) {
+        std::size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            const __m256i h = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+            _mm256_storeu_ps(dst + i, _mm256_castsi256_ps(_mm256_slli_epi32(h, 16)));
+        }  // i
+        for (; i < n; ++i) {
+            const uint32_t bits = static_cast<uint32_t>(src[i]) << 16;
+            std::memcpy(dst + i, &bits, sizeof(bits));
+        }  // i
+    }
+
+    /**
+     * Rounds n floats to the nearest bfloat16, ties to even, and stores their bit patterns. NaNs stay (quiet) NaNs.
+     */
+    MATRIX_TARGET_AVX2
+    inline void floatToBfloat16(std::size_t n, const float* src, uint16_t* dst) {
+        const __m256i one = _mm256_set1_epi32(1);
+        const __m256i bias = _mm256_set1_epi32(0x7FFF);
+        const __m256i quiet = _mm256_set1_epi32(0x400000);
+        std::size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            const __m256 v = _mm256_loadu_ps(src + i);
+            const __m256i bits = _mm256_castps_si256(v);
+            const __m256i lsb = _mm256_and_si256(_mm256_srli_epi32(bits, 16), one);
+            __m256i rounded = _mm256_add_epi32(bits, _mm256_add_epi32(bias, lsb));
+            const __m256i nan = _mm256_castps_si256(_mm256_cmp_ps(v, v, _CMP_UNORD_Q));
+            rounded = _mm256_blendv_epi8(rounded, _mm256_or_si256(bits, quiet), nan);
+            rounded = _mm256_srli_epi32(rounded, 16);
+            // packus interleaves the 128-bit lanes; put the four 64-bit groups back in order
+            const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(rounded, rounded),
+                                                            _MM_SHUFFLE(3, 1, 2, 0));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm256_castsi256_si128(packed));
+        }  // i
+        for (; i < n; ++i) {
+            uint32_t bits;
+            std::memcpy(&bits, src + i, sizeof(bits));
+            if ((bits & 0x7FFFFFFFu) > 0x7F800000u)
+                bits |= 0x400000u;
+            else
+                bits += 0x7FFFu + ((bits >> 16) & 1u);
+            dst[i] = static_cast<uint16_t>(bits >> 16);
+        }  // i
+    }
+
+    /**
+     * Widens n IEEE half precision values (given as their bit patterns) to float with F16C.
+     */
+    MATRIX_TARGET_F16C
+    inline void float16ToFloat(std::size_t n, const uint16_t* src, float* dst) {
+        std::size_t i = 0;
+        for (; i + 8 <= n; i += 8)
+            _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i))));
+        if (i < n) {
+            uint16_t in[8] = {0};
+            float out[8];
+            std::memcpy(in, src + i, (n - i) * sizeof(uint16_t));
+            _mm256_storeu_ps(out, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in))));
+            std::memcpy(dst + i, out, (n - i) * sizeof(float));
+        }
+    }
+
+    /**
+     * Rounds n floats to the nearest IEEE half precision value, ties to even, with F16C.
+     */
+    MATRIX_TARGET_F16C
+    inline void floatToFloat16(std::size_t n, const float* src, uint16_t* dst) {
+        std::size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                             _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT));
+        }  // i
+        if (i < n) {
+            float in[8] = {0};
+            uint16_t out[8];
+            std::memcpy(in, src + i, (n - i) * sizeof(float));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm256_cvtps_ph(_mm256_loadu_ps(in),
+                                                                              _MM_FROUND_TO_NEAREST_INT));
+            std::memcpy(dst + i, out, (n - i) * sizeof(uint16_t));
+        }
+    }
+}
+}
+
+#endif //MATRIX_X86
+
+#endif //MATRIX_KERNELSAVX2_H
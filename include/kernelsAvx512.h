@@ -0,0 +1,356 @@
+#ifndef MATRIX_KERNELSAVX512_H
+#define MATRIX_KERNELSAVX512_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "cpuFeatures.h"
+
+#ifdef MATRIX_X86
+#include <immintrin.h>
+
+#define MATRIX_TARGET_AVX512 __attribute__((target("avx512f,fma")))
+#define MATRIX_TARGET_AVX512VNNI __attribute__((target("avx512f,avx512bw,avx512vnni")))
+
+/**
+ * AVX-512F micro-kernels. Like the AVX2 kernels they carry their own target attribute and are only handed out when
+ * cpuFeatures() reports AVX-512F. Ragged tiles are written with masked loads and stores instead of going through a
+ * scratch tile.
+ */
+namespace matmul {
+namespace avx512 {
+
+    /**
+     * @return A mask with the lowest n of 16 lanes set.
+     */
+    inline __mmask16 mask16(std::size_t n) {
+        return n >= 16 ? static_cast<__mmask16>(0xFFFF) : static_cast<__mmask16>((1u << n) - 1);
+    }
+
+    /**
+     * @return A mask with the lowest n of 8 lanes set.
+     */
+    inline __mmask8 mask8(std::size_t n) {
+        return n >= 8 ? static_cast<__mmask8>(0xFF) : static_cast<__mmask8>((1u << n) - 1);
+    }
+
+    /**
+     * Stores alpha * v + beta * C to the masked lanes of a row of C, without reading C when beta is zero.
+     */
+    MATRIX_TARGET_AVX512
+    inline void storeRow(float* c, __m512 v0, __m512 v1, __mmask16 m0, __mmask16 m1, float alpha, float beta) {
+        const __m512 va = _mm512_set1_ps(alpha);
+        if (beta == 0.0f) {
+            v0 = _mm512_mul_ps(va, v0);
+            v1 = _mm512_mul_ps(va, v1);
+        } else {
+            const __m512 vb = _mm512_set1_ps(beta);
+            v0 = _mm512_fmadd_ps(va, v0, _mm512_mul_ps(vb, _mm512_maskz_loadu_ps(m0, c + 0)));
+            v1 = _mm512_fmadd_ps(va, v1, _mm512_mul_ps(vb, _mm512_maskz_loadu_ps(m1, c + 16)));
+        }
+        _mm512_mask_storeu_ps(c + 0, m0, v0);
+        _mm512_mask_storeu_ps(c + 16, m1, v1);
+    }
+
+    MATRIX_TARGET_AVX512
+    inline void storeRow(double* c, __m512d v0, __m512d v1, __mmask8 m0, __mmask8 m1, double alpha, double beta) {
+        const __m512d va = _mm512_set1_pd(alpha);
+        if (beta == 0.0) {
+            v0 = _mm512_mul_pd(va, v0);
+            v1 = _mm512_mul_pd(va, v1);
+        } else {
+            const __m512d vb = _mm512_set1_pd(beta);
+            v0 = _mm512_fmadd_pd(va, v0, _mm512_mul_pd(vb, _mm512_maskz_loadu_pd(m0, c + 0)));
+            v1 = _mm512_fmadd_pd(va, v1, _mm512_mul_pd(vb, _mm512_maskz_loadu_pd(m1, c + 8)));
+        }
+        _mm512_mask_storeu_pd(c + 0, m0, v0);
+        _mm512_mask_storeu_pd(c + 8, m1, v1);
+    }
+
+    /**
+     * 12 x 32 single precision micro-kernel: 24 zmm accumulators, two zmm loads of B and twelve broadcasts of A per
+     * step of k.
+     */
+    MATRIX_TARGET_AVX512
+    inline void sgemm12x32(std::size_t kc, const float* a, const float* b, float* c, std::size_t ldc,
+                           std::size_t mr, std::size_t nr, float alpha, float beta) {
+        __m512 c00 = _mm512_setzero_ps(), c01 = _mm512_setzero_ps();
+        __m512 c10 = _mm512_setzero_ps(), c11 = _mm512_setzero_ps();
+        __m512 c20 = _mm512_setzero_ps(), c21 = _mm512_setzero_ps();
+        __m512 c30 = _mm512_setzero_ps(), c31 = _mm512_setzero_ps();
+        __m512 c40 = _mm512_setzero_ps(), c41 = _mm512_setzero_ps();
+        __m512 c50 = _mm512_setzero_ps(), c51 = _mm512_setzero_ps();
+        __m512 c60 = _mm512_setzero_ps(), c61 = _mm512_setzero_ps();
+        __m512 c70 = _mm512_setzero_ps(), c71 = _mm512_setzero_ps();
+        __m512 c80 = _mm512_setzero_ps(), c81 = _mm512_setzero_ps();
+        __m512 c90 = _mm512_setzero_ps(), c91 = _mm512_setzero_ps();
+        __m512 cA0 = _mm512_setzero_ps(), cA1 = _mm512_setzero_ps();
+        __m512 cB0 = _mm512_setzero_ps(), cB1 = _mm512_setzero_ps();
+
+        for (std::size_t k = 0; k < kc; ++k) {
+            const __m512 b0 = _mm512_loadu_ps(b + 0);
+            const __m512 b1 = _mm512_loadu_ps(b + 16);
+            __m512 ar;
+
+            ar = _mm512_set1_ps(a[0]);
+            c00 = _mm512_fmadd_ps(ar, b0, c00); c01 = _mm512_fmadd_ps(ar, b1, c01);
+            ar = _mm512_set1_ps(a[1]);
+            c10 = _mm512_fmadd_ps(ar, b0, c10); c11 = _mm512_fmadd_ps(ar, b1, c11);
+            ar = _mm512_set1_ps(a[2]);
+            c20 = _mm512_fmadd_ps(ar, b0, c20); c21 = _mm512_fmadd_ps(ar, b1, c21);
+            ar = _mm512_set1_ps(a[3]);
+            c30 = _mm512_fmadd_ps(ar, b0, c30); c31 = _mm512_fmadd_ps(ar, b1, c31);
+            ar = _mm512_set1_ps(a[4]);
+            c40 = _mm512_fmadd_ps(ar, b0, c40); c41 = _mm512_fmadd_ps(ar, b1, c41);
+            ar = _mm512_set1_ps(a[5]);
+            c50 = _mm512_fmadd_ps(ar, b0, c50); c51 = _mm512_fmadd_ps(ar, b1, c51);
+            ar = _mm512_set1_ps(a[6]);
+            c60 = _mm512_fmadd_ps(ar, b0, c60); c61 = _mm512_fmadd_ps(ar, b1, c61);
+            ar = _mm512_set1_ps(a[7]);
+            c70 = _mm512_fmadd_ps(ar, b0, c70); c71 = _mm512_fmadd_ps(ar, b1, c71);
+            ar = _mm512_set1_ps(a[8]);
+            c80 = _mm512_fmadd_ps(ar, b0, c80); c81 = _mm512_fmadd_ps(ar, b1, c81);
+            ar = _mm512_set1_ps(a[9]);
+            c90 = _mm512_fmadd_ps(ar, b0, c90); c91 = _mm512_fmadd_ps(ar, b1, c91);
+            ar = _mm512_set1_ps(a[10]);
+            cA0 = _mm512_fmadd_ps(ar, b0, cA0); cA1 = _mm512_fmadd_ps(ar, b1, cA1);
+            ar = _mm512_set1_ps(a[11]);
+            cB0 = _mm512_fmadd_ps(ar, b0, cB0); cB1 = _mm512_fmadd_ps(ar, b1, cB1);
+
+            a += 12;
+            b += 32;
+        }  // k
+
+        const __mmask16 m0 = mask16(nr);
+        const __mmask16 m1 = nr > 16 ? mask16(nr - 16) : static_cast<__mmask16>(0);
+        storeRow(c + 0 * ldc, c00, c01, m0, m1, alpha, beta);
+        if (mr > 1) storeRow(c + 1 * ldc, c10, c11, m0, m1, alpha, beta);
+        if (mr > 2) storeRow(c + 2 * ldc, c20, c21, m0, m1, alpha, beta);
+        if (mr > 3) storeRow(c + 3 * ldc, c30, c31, m0, m1, alpha, beta);
+        if (mr > 4) storeRow(c + 4 * ldc, c40, c41, m0, m1, alpha, beta);
+        if (mr > 5) storeRow(c + 5 * ldc, c50, c51, m0, m1, alpha, beta);
+        if (mr > 6) storeRow(c + 6 * ldc, c60, c61, m0, m1, alpha, beta);
+        if (mr > 7) storeRow(c + 7 * ldc, c70, c71, m0, m1, alpha, beta);
+        if (mr > 8) storeRow(c + 8 * ldc, c80, c81, m0, m1, alpha, beta);
+        if (mr > 9) storeRow(c + 9 * ldc, c90, c91, m0, m1, alpha, beta);
+        if (mr > 10) storeRow(c + 10 * ldc, cA0, cA1, m0, m1, alpha, beta);
+        if (mr > 11) storeRow(c + 11 * ldc, cB0, cB1, m0, m1, alpha, beta);
+    }
+
+    /**
+     * 12 x 16 double precision micro-kernel, laid out like sgemm12x32 with eight doubles per zmm register.
+     */
+    MATRIX_TARGET_AVX512
+    inline void dgemm12x16(std::size_t kc, const double* a, const double* b, double* c, std::size_t ldc,
+                           std::size_t mr, std::size_t nr, double alpha, double beta) {
+        __m512d c00 = _mm512_setzero_pd(), c01 = _mm512_setzero_pd();
+        __m512d c10 = _mm512_setzero_pd(), c11 = _mm512_setzero_pd();
+        __m512d c20 = _mm512_setzero_pd(), c21 = _mm512_setzero_pd();
+        __m512d c30 = _mm512_setzero_pd(), c31 = _mm512_setzero_pd();
+        __m512d c40 = _mm512_setzero_pd(), c41 = _mm512_setzero_pd();
+        __m512d c50 = _mm512_setzero_pd(), c51 = _mm512_setzero_pd();
+        __m512d c60 = _mm512_setzero_pd(), c61 = _mm512_setzero_pd();
+        __m512d c70 = _mm512_setzero_pd(), c71 = _mm512_setzero_pd();
+        __m512d c80 = _mm512_setzero_pd(), c81 = _mm512_setzero_pd();
+        __m512d c90 = _mm512_setzero_pd(), c91 = _mm512_setzero_pd();
+        __m512d cA0 = _mm512_setzero_pd(), cA1 = _mm512_setzero_pd();
+        __m512d cB0 = _mm512_setzero_pd(), cB1 = _mm512_setzero_pd();
+
+        for (std::size_t k = 0; k < kc; ++k) {
+            const __m512d b0 = _mm512_loadu_pd(b + 0);
+            const __m512d b1 = _mm512_loadu_pd(b + 8);
+            __m512d ar;
+
+            ar = _mm512_set1_pd(a[0]);
+            c00 = _mm512_fmadd_pd(ar, b0, c00); c01 = _mm512_fmadd_pd(ar, b1, c01);
+            ar = _mm512_set1_pd(a[1]);
+            c10 = _mm512_fmadd_pd(ar, b0, c10); c11 = _mm512_fmadd_pd(ar, b1, c11);
+            ar = _mm512_set1_pd(a[2]);
+            c20 = _mm512_fmadd_pd(ar, b0, c20); c21 = _mm512_fmadd_pd(ar, b1, c21);
+            ar = _mm512_set1_pd(a[3]);
+            c30 = _mm512_fmadd_pd(ar, b0, c30); c31 = _mm512_fmadd_pd(ar, b1, c31);
+            ar = _mm512_set1_pd(a[4]);
+            c40 = _mm512_fmadd_pd(ar, b0, c40); c41 = _mm512_fmadd_pd(ar, b1, c41);
+            ar = _mm512_set1_pd(a[5]);
+            c50 = _mm512_fmadd_pd(ar, b0, c50); c51 = _mm512_fmadd_pd(ar, b1, c51);
+            ar = _mm512_set1_pd(a[6]);
+            c60 = _mm512_fmadd_pd(ar, b0, c60); c61 = _mm512_fmadd_pd(ar, b1, c61);
+            ar = _mm512_set1_pd(a[7]);
+            c70 = _mm512_fmadd_pd(ar, b0, c70); c71 = _mm512_fmadd_pd(ar, b1, c71);
+            ar = _mm512_set1_pd(a[8]);
+            c80 = _mm512_fmadd_pd(ar, b0, c80); c81 = _mm512_fmadd_pd(ar, b1, c81);
+            ar = _mm512_set1_pd(a[9]);
+            c90 = _mm512_fmadd_pd(ar, b0, c90); c91 = _mm512_fmadd_pd(ar, b1, c91);
+            ar = _mm512_set1_pd(a[10]);
+            cA0 = _mm512_fmadd_pd(ar, b0, cA0); cA1 = _mm512_fmadd_pd(ar, b1, cA1);
+            ar = _mm512_set1_pd(a[11]);
+            cB0 = _mm512_fmadd_pd(ar, b0, cB0); cB1 = _mm512_fmadd_pd(ar, b1, cB1);
+
+            a += 12;
+            b += 16;
+        }  // k
+
+        const __mmask8 m0 = mask8(nr);
+        const __mmask8 m1 = nr > 8 ? mask8(nr - 8) : static_cast<__mmask8>(0);
+        storeRow(c + 0 * ldc, c00, c01, m0, m1, alpha, beta);
+        if (mr > 1) storeRow(c + 1 * ldc, c10, c11, m0, m1, alpha, beta);
+        if (mr > 2) storeRow(c + 2 * ldc, c20, c21, m0, m1, alpha, beta);
+        if (mr > 3) storeRow(c + 3 * ldc, c30, c31, m0, m1, alpha, beta);
+        if (mr > 4) storeRow(c + 4 * ldc, c40, c41, m0, m1, alpha, beta);
+        if (mr > 5) storeRow(c + 5 * ldc, c50, c51, m0, m1, alpha, beta);
+        if (mr > 6) storeRow(c + 6 * ldc, c60, c61, m0, m1, alpha, beta);
+        if (mr > 7) storeRow(c + 7 * ldc, c70, c71, m0, m1, alpha, beta);
+        if (mr > 8) storeRow(c + 8 * ldc, c80, c81, m0, m1, alpha, beta);
+        if (mr > 9) storeRow(c + 9 * ldc, c90, c91, m0, m1, alpha, beta);
+        if (mr > 10) storeRow(c + 10 * ldc, cA0, cA1, m0, m1, alpha, beta);
+        if (mr > 11) storeRow(c + 11 * ldc, cB0, cB1, m0, m1, alpha, beta);
+    }
+
+    /**
+     * Transposes a block of up to 16 x 16 32-bit elements entirely in zmm registers. Rows and columns outside the
+     * block are neither read nor written, thanks to masked loads and stores.
+     *
+     * @param src Top-left element of the source block
+     * @param lds Row stride of the source
+     * @param dst Top-left element of the destination block
+     * @param ldd Row stride of the destination
+     * @param rows Number of valid source rows (<= 16)
+     * @param cols Number of valid source columns (<= 16)
+     */
+    MATRIX_TARGET_AVX512
+    inline void transpose16x16(const void* src, std::size_t lds, void* dst, std::size_t ldd,
+                               std::size_t rows, std::size_t cols) {
+        const float* s = static_cast<const float*>(src);
+        float* d = static_cast<float*>(dst);
+        __m512 r[16], t[16];
+
+        const __mmask16 loadMask = mask16(cols);
+        for (std::size_t i = 0; i < 16; ++i)
+            r[i] = i < rows ? _mm512_maskz_loadu_ps(loadMask, s + i * lds) : _mm512_setzero_ps();
+
+        // Interleave pairs of rows, then pairs of pairs within each 128-bit lane
+        for (int i = 0; i < 16; i += 2) {
+            t[i + 0] = _mm512_unpacklo_ps(r[i], r[i + 1]);
+            t[i + 1] = _mm512_unpackhi_ps(r[i], r[i + 1]);
+        }  // i
+        for (int i = 0; i < 16; i += 4) {
+            r[i + 0] = _mm512_shuffle_ps(t[i + 0], t[i + 2], _MM_SHUFFLE(1, 0, 1, 0));
+            r[i + 1] = _mm512_shuffle_ps(t[i + 0], t[i + 2], _MM_SHUFFLE(3, 2, 3, 2));
+            r[i + 2] = _mm512_shuffle_ps(t[i + 1], t[i + 3], _MM_SHUFFLE(1, 0, 1, 0));
+            r[i + 3] = _mm512_shuffle_ps(t[i + 1], t[i + 3], _MM_SHUFFLE(3, 2, 3, 2));
+        }  // i
+
+        // Then move whole 128-bit lanes between registers
+        for (int i = 0; i < 16; i += 8) {
+            for (int j = 0; j < 4; ++j) {
+                t[i + j + 0] = _mm512_shuffle_f32x4(r[i + j], r[i + j + 4], 0x88);
+                t[i + j + 4] = _mm512_shuffle_f32x4(r[i + j], r[i + j + 4], 0xdd);
+            }  // j
+        }  // i
+        for (int j = 0; j < 8; ++j) {
+            r[j + 0] = _mm512_shuffle_f32x4(t[j], t[j + 8], 0x88);
+            r[j + 8] = _mm512_shuffle_f32x4(t[j], t[j + 8], 0xdd);
+        }  // j
+
+        const __mmask16 storeMask = mask16(rows);
+        for (std::size_t j = 0; j < cols; ++j)
+            _mm512_mask_storeu_ps(d + j * ldd, storeMask, r[j]);
+    }
+
+    MATRIX_TARGET_AVX512VNNI
+    inline void storeRow(int32_t* c, __m512i v0, __m512i v1, __mmask16 m0, __mmask16 m1, bool accumulate) {
+        if (accumulate) {
+            v0 = _mm512_add_epi32(v0, _mm512_maskz_loadu_epi32(m0, c + 0));
+            v1 = _mm512_add_epi32(v1, _mm512_maskz_loadu_epi32(m1, c + 16));
+        }
+        _mm512_mask_storeu_epi32(c + 0, m0, v0);
+        _mm512_mask_storeu_epi32(c + 16, m1, v1);
+    }
+
+    /**
+     * Broadcasts the four bytes at a to every 32-bit lane.
+     */
+    MATRIX_TARGET_AVX512VNNI
+    inline __m512i broadcastQuad(const uint8_t* a) {
+        int32_t quad;
+        std::memcpy(&quad, a, sizeof(quad));
+        return _mm512_set1_epi32(quad);
+    }
+
+    /**
+     * 12 x 32 quantized micro-kernel: unsigned 8-bit A times signed 8-bit B, accumulated in 32 bits with
+     * vpdpbusd, which multiplies four byte pairs per lane and adds them to the accumulator without intermediate
+     * saturation. The panels are packed in groups of four k (see quantized.h); kq is the number of groups.
+     */
+    MATRIX_TARGET_AVX512VNNI
+    inline void qgemm12x32(std::size_t kq, const uint8_t* a, const int8_t* b, int32_t* c, std::size_t ldc,
+                           std::size_t mr, std::size_t nr, bool accumulate) {
+        __m512i c00 = _mm512_setzero_si512(), c01 = _mm512_setzero_si512();
+        __m512i c10 = _mm512_setzero_si512(), c11 = _mm512_setzero_si512();
+        __m512i c20 = _mm512_setzero_si512(), c21 = _mm512_setzero_si512();
+        __m512i c30 = _mm512_setzero_si512(), c31 = _mm512_setzero_si512();
+        __m512i c40 = _mm512_setzero_si512(), c41 = _mm512_setzero_si512();
+        __m512i c50 = _mm512_setzero_si512(), c51 = _mm512_setzero_si512();
+        __m512i c60 = _mm512_setzero_si512(), c61 = _mm512_setzero_si512();
+        __m512i c70 = _mm512_setzero_si512(), c71 = _mm512_setzero_si512();
+        __m512i c80 = _mm512_setzero_si512(), c81 = _mm512_setzero_si512();
+        __m512i c90 = _mm512_setzero_si512(), c91 = _mm512_setzero_si512();
+        __m512i cA0 = _mm512_setzero_si512(), cA1 = _mm512_setzero_si512();
+        __m512i cB0 = _mm512_setzero_si512(), cB1 = _mm512_setzero_si512();
+
+        for (std::size_t q = 0; q < kq; ++q) {
+            const __m512i b0 = _mm512_loadu_si512(b + 0);
+            const __m512i b1 = _mm512_loadu_si512(b + 64);
+            __m512i ar;
+
+            ar = broadcastQuad(a + 0);
+            c00 = _mm512_dpbusd_epi32(c00, ar, b0); c01 = _mm512_dpbusd_epi32(c01, ar, b1);
+            ar = broadcastQuad(a + 4);
+            c10 = _mm512_dpbusd_epi32(c10, ar, b0); c11 = _mm512_dpbusd_epi32(c11, ar, b1);
+            ar = broadcastQuad(a + 8);
+            c20 = _mm512_dpbusd_epi32(c20, ar, b0); c21 = _mm512_dpbusd_epi32(c21, ar, b1);
+            ar = broadcastQuad(a + 12);
+            c30 = _mm512_dpbusd_epi32(c30, ar, b0); c31 = _mm512_dpbusd_epi32(c31, ar, b1);
+            ar = broadcastQuad(a + 16);
+            c40 = _mm512_dpbusd_epi32(c40, ar, b0); c41 = _mm512_dpbusd_epi32(c41, ar, b1);
+            ar = broadcastQuad(a + 20);
+            c50 = _mm512_dpbusd_epi32(c50, ar, b0); c51 = _mm512_dpbusd_epi32(c51, ar, b1);
+            ar = broadcastQuad(a + 24);
+            c60 = _mm512_dpbusd_epi32(c60, ar, b0); c61 = _mm512_dpbusd_epi32(c61, ar, b1);
+            ar = broadcastQuad(a + 28);
+            c70 = _mm512_dpbusd_epi32(c70, ar, b0); c71 = _mm512_dpbusd_epi32(c71, ar, b1);
+            ar = broadcastQuad(a + 32);
+            c80 = _mm512_dpbusd_epi32(c80, ar, b0); c81 = _mm512_dpbusd_epi32(c81, ar, b1);
+            ar = broadcastQuad(a + 36);
+            c90 = _mm512_dpbusd_epi32(c90, ar, b0); c91 = _mm512_dpbusd_epi32(c91, ar, b1);
+            ar = broadcastQuad(a + 40);
+            cA0 = _mm512_dpbusd_epi32(cA0, ar, b0); cA1 = _mm512_dpbusd_epi32(cA1, ar, b1);
+            ar = broadcastQuad(a + 44);
+            cB0 = _mm512_dpbusd_epi32(cB0, ar, b0); cB1 = _mm512_dpbusd_epi32(cB1, ar, b1);
+
+            a += 12 * 4;
+            b += 32 * 4;
+        }  // q
+
+        const __mmask16 m0 = mask16(nr);
+        const __mmask16 m1 = nr > 16 ? mask16(nr - 16) : static_cast<__mmask16>(0);
+        storeRow(c + 0 * ldc, c00, c01, m0, m1, accumulate);
+        if (mr > 1) storeRow(c + 1 * ldc, c10, c11, m0, m1, accumulate);
+        if (mr > 2) storeRow(c + 2 * ldc, c20, c21, m0, m1, accumulate);
+        if (mr > 3) storeRow(c + 3 * ldc, c30, c31, m0, m1, accumulate);
+        if (mr > 4) storeRow(c + 4 * ldc, c40, c41, m0, m1, accumulate);
+        if (mr > 5) storeRow(c + 5 * ldc, c50, c51, m0, m1, accumulate);
+        if (mr > 6) storeRow(c + 6 * ldc, c60, c61, m0, m1, accumulate);
+        if (mr > 7) storeRow(c + 7 * ldc, c70, c71, m0, m1, accumulate);
+        if (mr > 8) storeRow(c + 8 * ldc, c80, c81, m0, m1, accumulate);
+        if (mr > 9) storeRow(c + 9 * ldc, c90, c91, m0, m1, accumulate);
+        if (mr > 10) storeRow(c + 10 * ldc, cA0, cA1, m0, m1, accumulate);
+        if (mr > 11) storeRow(c + 11 * ldc, cB0, cB1, m0, m1, accumulate);
+    }
+}
+}
+
+#endif //MATRIX_X86
+
+#endif //MATRIX_KERNELSAVX512_H
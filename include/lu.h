@@ -0,0 +1,325 @@
+#ifndef MATRIX_LU_H
+#define MATRIX_LU_H
+
+#include <cmath>
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+#include <type_traits>
+
+#include "blocking.h"
+#include "gemm.h"
+#include "threadPool.h"
+#include "matrix.h"
+
+/**
+ * LU factorization with partial pivoting, P * A = L * U, and the solves built on it. The factorization is blocked
+ * and right-looking: each step factors a panel of LU_BLOCK columns, solves for the matching block row of U and
+ * subtracts their product from the trailing matrix through the packed GEMM of gemm.h, which does nearly all of the
+ * flops and runs on the thread pool. The panel itself is factored recursively, halving its columns down to
+ * LU_LEAF, so it also goes through the GEMM instead of a long sequence of rank-1 updates. Storage is row-major, so
+ * a row interchange swaps two contiguous rows across the whole matrix at once, as soon as the pivot is found.
+ */
+namespace matmul {
+
+    /**
+     * Columns per panel of the blocked factorization, and rows per block of the blocked triangular solves.
+     */
+    const std::size_t LU_BLOCK = 128;
+
+    /**
+     * Panels of at most this many columns are factored column by column.
+     */
+    const std::size_t LU_LEAF = 16;
+
+    /**
+     * Columns per task of the triangular solves.
+     */
+    const std::size_t LU_STRIP = 256;
+
+    /**
+     * Calls strip(j0, j1) over [0, cols) in strips of LU_STRIP columns, on the thread pool once the work reaches
+     * PARALLEL_MIN_FLOPS.
+     */
+    template <typename Fn>
+    void forEachStrip(std::size_t cols, std::size_t flops, const Fn& strip) {
+        const std::size_t nTasks = (cols + LU_STRIP - 1) / LU_STRIP;
+        if (nTasks <= 1 || ThreadPool::instance().size() == 1 || flops < PARALLEL_MIN_FLOPS) {
+            strip(0, cols);
+            return;
+        }
+        ThreadPool::instance().parallelFor(nTasks, [&strip, cols](std::size_t t) {
+            strip(t * LU_STRIP, std::min(cols, (t + 1) * LU_STRIP));
+        });
+    }
+
+    /**
+     * Solves L * X = B in place for the unit lower triangle L of an n x n block and an n x cols block B.
+     */
+    template <typename T>
+    void solveUnitLowerBlock(std::size_t n, std::size_t cols, const T* l, std::size_t ldl, T* b, std::size_t ldb) {
+        forEachStrip(cols, n * n * cols, [=](std::size_t j0, std::size_t j1) {
+            for (std::size_t i = 1; i < n; ++i) {
+                T* row = b + i * ldb;
+                for (std::size_t p = 0; p < i; ++p) {
+                    const T lip = l[i * ldl + p];
+                    const T* src = b + p * ldb;
+                    for (std::size_t j = j0; j < j1; ++j)
+                        row[j] -= lip * src[j];
+                }  // p
+            }  // i
+        });
+    }
+
+    /**
+     * Solves U * X = B in place for the upper triangle U of an n x n block and an n x cols block B.
+     */
+    template <typename T>
+    void solveUpperBlock(std::size_t n, std::size_t cols, const T* u, std::size_t ldu, T* b, std::size_t ldb) {
+        forEachStrip(cols, n * n * cols, [=](std::size_t j0, std::size_t j1) {
+            for (std::size_t i = n; i-- > 0;) {
+                T* row = b + i * ldb;
+                for (std::size_t p = i + 1; p < n; ++p) {
+                    const T uip = u[i * ldu + p];
+                    const T* src = b + p * ldb;
+                    for (std::size_t j = j0; j < j1; ++j)
+                        row[j] -= uip * src[j];
+                }  // p
+                const T inv = T(1) / u[i * ldu + i];
+                for (std::size_t j = j0; j < j1; ++j)
+                    row[j] *= inv;
+            }  // i
+        });
+    }
+
+    /**
+     * Factors columns [j0, j0 + nb) of rows [j0, n) of the row-major n x n matrix A, column by column. Rows are
+     * swapped whole.
+     *
+     * @return false if a pivot is exactly zero; that column is left as is and the factorization goes on.
+     */
+    template <typename T>
+    bool luLeaf(std::size_t n, std::size_t j0, std::size_t nb, T* a, std::size_t lda, std::size_t* pivots) {
+        bool regular = true;
+        for (std::size_t c = j0; c < j0 + nb; ++c) {
+            std::size_t p = c;
+            T best = std::abs(a[c * lda + c]);
+            for (std::size_t r = c + 1; r < n; ++r) {
+                if (std::abs(a[r * lda + c]) > best) {
+                    best = std::abs(a[r * lda + c]);
+                    p = r;
+                }
+            }  // r
+            pivots[c] = p;
+            if (p != c)
+                std::swap_ranges(a + c * lda, a + c * lda + n, a + p * lda);
+
+            const T* pivotRow = a + c * lda;
+            if (pivotRow[c] == T(0)) {
+                regular = false;
+                continue;
+            }
+            const T inv = T(1) / pivotRow[c];
+            for (std::size_t r = c + 1; r < n; ++r) {
+                T* row = a + r * lda;
+                const T l = row[c] *= inv;
+                for (std::size_t q = c + 1; q < j0 + nb; ++q)
+                    row[q] -= l * pivotRow[q];
+            }  // r
+        }  // c
+        return regular;
+    }
+
+    /**
+     * Factors columns [j0, j0 + nb) of rows [j0, n) of A by halves: the left half recursively, then the block row
+     * of U next to it, then the GEMM update of the right half, then the right half recursively.
+     */
+    template <typename T, typename Blocking>
+    bool luPanel(std::size_t n, std::size_t j0, std::size_t nb, T* a, std::size_t lda, std::size_t* pivots) {
+        if (nb <= LU_LEAF)
+            return luLeaf(n, j0, nb, a, lda, pivots);
+
+        const std::size_t n1 = nb / 2, n2 = nb - n1;
+        bool regular = luPanel<T, Blocking>(n, j0, n1, a, lda, pivots);
+        T* a11 = a + j0 * lda + j0;
+        solveUnitLowerBlock(n1, n2, a11, lda, a11 + n1, lda);
+        gemm<T, Blocking>(NO_TRANSPOSE, NO_TRANSPOSE, n - j0 - n1, n2, n1, T(-1), a11 + n1 * lda, lda,
+                          a11 + n1, lda, T(1), a11 + n1 * lda + n1, lda);
+        regular = luPanel<T, Blocking>(n, j0 + n1, n2, a, lda, pivots) && regular;
+        return regular;
+    }
+
+    /**
+     * Computes P * A = L * U in place for a row-major n x n matrix A: on return, the strictly lower triangle of A
+     * holds L without its unit diagonal and the upper triangle holds U.
+     *
+     * @param lda Row stride of A
+     * @param pivots n elements, receiving the row that row i was swapped with at step i
+     * @param block Columns per panel
+     * @return false if A is singular, i.e. U has a zero on its diagonal.
+     */
+    template <typename T, typename Blocking = DefaultBlocking<T> >
+    bool lu(std::size_t n, T* a, std::size_t lda, std::size_t* pivots, std::size_t block = LU_BLOCK) {
+        static_assert(std::is_floating_point<T>::value, "LU needs a floating point element type");
+        block = std::max<std::size_t>(block, 1);
+        bool regular = true;
+        for (std::size_t j = 0; j < n; j += block) {
+            const std::size_t nb = std::min(block, n - j);
+            regular = luPanel<T, Blocking>(n, j, nb, a, lda, pivots) && regular;
+            const std::size_t rest = n - j - nb;
+            if (rest == 0)
+                continue;
+            T* a11 = a + j * lda + j;
+            solveUnitLowerBlock(nb, rest, a11, lda, a11 + nb, lda);
+            gemm<T, Blocking>(NO_TRANSPOSE, NO_TRANSPOSE, rest, rest, nb, T(-1), a11 + nb * lda, lda,
+                              a11 + nb, lda, T(1), a11 + nb * lda + nb, lda);
+        }  // j
+        return regular;
+    }
+
+    /**
+     * Solves A * X = B in place for the n x cols matrix B, given the factors and pivots computed by lu(). The
+     * off-diagonal blocks of both triangular solves go through the GEMM.
+     */
+    template <typename T, typename Blocking = DefaultBlocking<T> >
+    void luSolve(std::size_t n, const T* lu, std::size_t lda, const std::size_t* pivots,
+                 std::size_t cols, T* b, std::size_t ldb, std::size_t block = LU_BLOCK) {
+        block = std::max<std::size_t>(block, 1);
+        for (std::size_t i = 0; i < n; ++i)
+            if (pivots[i] != i)
+                std::swap_ranges(b + i * ldb, b + i * ldb + cols, b + pivots[i] * ldb);
+
+        // L * Y = P * B, top to bottom
+        for (std::size_t k = 0; k < n; k += block) {
+            const std::size_t nb = std::min(block, n - k);
+            if (k > 0)
+                gemm<T, Blocking>(NO_TRANSPOSE, NO_TRANSPOSE, nb, cols, k, T(-1), lu + k * lda, lda,
+                                  b, ldb, T(1), b + k * ldb, ldb);
+            solveUnitLowerBlock(nb, cols, lu + k * lda + k, lda, b + k * ldb, ldb);
+        }  // k
+
+        // U * X = Y, bottom to top
+        for (std::size_t end = n; end > 0;) {
+            const std::size_t nb = std::min(block, end), k = end - nb;
+            if (end < n)
+                gemm<T, Blocking>(NO_TRANSPOSE, NO_TRANSPOSE, nb, cols, n - end, T(-1), lu + k * lda + end, lda,
+                                  b + end * ldb, ldb, T(1), b + k * ldb, ldb);
+            solveUpperBlock(nb, cols, lu + k * lda + k, lda, b + k * ldb, ldb);
+            end = k;
+        }  // end
+    }
+}
+
+/**
+ * LU factorization of a square matrix, computed once on construction and reused by solve(), inverse() and
+ * determinant().
+ *
+ * @tparam T Floating point element type
+ * @tparam Blocking Cache blocking of the GEMM calls (see blocking.h)
+ */
+template <typename T, typename Blocking = DefaultBlocking<T> >
+class LU {
+public:
+    /**
+     * @throws Matrix<T>::empty_matrix if a is empty
+     * @throws Matrix<T>::size_mismatch if a is not square
+     */
+    explicit LU(const Matrix<T, Blocking>& a) : lu(a) {
+        if (a.shape(0) == 0 || a.shape(1) == 0)
+            throw typename Matrix<T, Blocking>::empty_matrix();
+        if (a.shape(0) != a.shape(1))
+            throw typename Matrix<T, Blocking>::size_mismatch();
+        pivotRows.resize(a.shape(0));
+        regular = matmul::lu<T, Blocking>(a.shape(0), &lu(0, 0), a.shape(0), pivotRows.data());
+    }
+
+    /**
+     * @return L below the diagonal, without its unit diagonal, and U on and above it.
+     */
+    const Matrix<T, Blocking>& factors() const {
+        return lu;
+    }
+
+    /**
+     * @return The row that row i was swapped with at step i of the elimination.
+     */
+    const std::vector<std::size_t>& pivots() const {
+        return pivotRows;
+    }
+
+    bool singular() const {
+        return !regular;
+    }
+
+    T determinant() const {
+        T det = T(1);
+        for (mat_size_t i = 0; i < lu.shape(0); ++i)
+            det *= pivotRows[i] != i ? -lu(i, i) : lu(i, i);
+        return det;
+    }
+
+    /**
+     * @param b An n x k matrix of right-hand sides.
+     * @return The n x k solution X of A * X = B.
+     * @throws Matrix<T>::size_mismatch if b does not have n rows
+     * @throws Matrix<T>::singular_matrix if A is singular
+     */
+    Matrix<T, Blocking> solve(const Matrix<T, Blocking>& b) const {
+        if (b.shape(0) == 0 || b.shape(1) == 0)
+            throw typename Matrix<T, Blocking>::empty_matrix();
+        if (b.shape(0) != lu.shape(0))
+            throw typename Matrix<T, Blocking>::size_mismatch();
+        if (!regular)
+            throw typename Matrix<T, Blocking>::singular_matrix();
+
+        Matrix<T, Blocking> x = b;
+        matmul::luSolve<T, Blocking>(lu.shape(0), &lu(0, 0), lu.shape(0), pivotRows.data(),
+                                     b.shape(1), &x(0, 0), b.shape(1));
+        return x;
+    }
+
+    std::vector<T> solve(const std::vector<T>& b) const {
+        const Matrix<T, Blocking> x = solve(Matrix<T, Blocking>(std::make_pair(b.size(), 1), b));
+        return std::vector<T>(x.cbegin(), x.cend());
+    }
+
+    /**
+     * @throws Matrix<T>::singular_matrix if A is singular
+     */
+    Matrix<T, Blocking> inverse() const {
+        const mat_size_t n = lu.shape(0);
+        Matrix<T, Blocking> id = Matrix<T, Blocking>(std::make_pair(n, n));
+        for (mat_size_t i = 0; i < n; ++i)
+            id(i, i) = T(1);
+        return solve(id);
+    }
+
+private:
+    Matrix<T, Blocking> lu;
+    std::vector<std::size_t> pivotRows;
+    bool regular;
+};
+
+/**
+ * @return The solution X of a * X = b.
+ * @throws Matrix<T>::singular_matrix if a is singular
+ */
+template <typename T, typename Blocking>
+Matrix<T, Blocking> solve(const Matrix<T, Blocking>& a, const Matrix<T, Blocking>& b) {
+    return LU<T, Blocking>(a).solve(b);
+}
+
+/**
+ * @throws Matrix<T>::singular_matrix if a is singular
+ */
+template <typename T, typename Blocking>
+Matrix<T, Blocking> inverse(const Matrix<T, Blocking>& a) {
+    return LU<T, Blocking>(a).inverse();
+}
+
+template <typename T, typename Blocking>
+T determinant(const Matrix<T, Blocking>& a) {
+    return LU<T, Blocking>(a).determinant();
+}
+
+#endif //MATRIX_LU_H
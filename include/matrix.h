@@ -6,16 +6,26 @@
 #include <sstream>
 #include <tuple>
 #include <iostream>
+#include <algorithm>
 
-#define XPOSE_STEP 2
-#define MATMUL_STEP 8
-#define I_BLOCK_SZ 64
-#define K_BLOCK_SZ 32
+#include "blocking.h"
+#include "gemm.h"
+#include "gemv.h"
+#include "strassen.h"
 
 typedef uint32_t mat_size_t;
 typedef std::tuple<mat_size_t, mat_size_t> shape_t;
 
-template <typename T>
+namespace matmul {
+    template <typename E>
+    struct MatrixExpression;
+}
+
+/**
+ * @tparam T Element type
+ * @tparam Blocking Register tile and cache block sizes used by transpose() and operator* (see blocking.h)
+ */
+template <typename T, typename Blocking = DefaultBlocking<T> >
 class Matrix {
 public:
     /**
@@ -37,6 +47,20 @@ public:
             n_rows(std::get<0>(shape)),
             n_cols(std::get<1>(shape)),
             elements(elements) {}
+    /**
+     * Evaluates a lazy matrix expression (see expression.h) in a single pass.
+     * @param expr Expression built from Matrix operands, e.g. lazy(a) * b + c
+     */
+    template <typename E>
+    Matrix(const matmul::MatrixExpression<E>& expr) : n_rows(0), n_cols(0) {
+        assignExpression(*this, expr.self());
+    }
+
+    template <typename E>
+    Matrix& operator=(const matmul::MatrixExpression<E>& expr) {
+        assignExpression(*this, expr.self());
+        return *this;
+    }
 
     /**
      * @param i Selected row
@@ -46,7 +70,7 @@ public:
     inline T& operator()(mat_size_t i, mat_size_t j) {
         return elements[i * n_cols + j];
     }
-    inline T& operator()(mat_size_t i, mat_size_t j) const {
+    inline const T& operator()(mat_size_t i, mat_size_t j) const {
         return elements[i * n_cols + j];
     }
 
@@ -63,146 +87,100 @@ public:
     }
 
     /**
-     * Return a copy of this matrix instance, transposed. Uses loop unrolling to gain a little bit of a performance
-     * boost
+     * Return a copy of this matrix instance, transposed. Works through square tiles of Blocking::XPOSE elements (or
+     * the size from the host's tuning profile) so both the reads and the strided writes stay in cache. 32-bit
+     * element types are transposed 16 x 16 blocks at a time in AVX-512 registers when the host supports it.
      * @return A new Matrix instance.
      */
-    virtual Matrix<T> transpose() {
+    virtual Matrix transpose() {
         if (this->empty())
             throw empty_matrix();
 
-        Matrix<T> res = Matrix<T>(std::make_pair(n_cols, n_rows));
-        mat_size_t i;
-        for (i = 0; i + XPOSE_STEP < n_rows; i += XPOSE_STEP) {
-            mat_size_t j;
-            for (j = 0; j + XPOSE_STEP < n_cols; j += XPOSE_STEP) {
-                res(j + 0, i + 0) = elements[n_cols * (i + 0) + (j + 0)];
-                res(j + 1, i + 0) = elements[n_cols * (i + 0) + (j + 1)];
-                res(j + 0, i + 1) = elements[n_cols * (i + 1) + (j + 0)];
-                res(j + 1, i + 1) = elements[n_cols * (i + 1) + (j + 1)];
-            }  // j
-            for (; j < n_cols; ++j) {
-                res(j + 0, i + 0) = elements[n_cols * (i + 0) + (j + 0)];
-                res(j + 0, i + 1) = elements[n_cols * (i + 1) + (j + 0)];
-            }  // j
-        }  // i
-        for (; i < n_rows; ++i) {
-            mat_size_t j;
-            for (j = 0; j + XPOSE_STEP < n_cols; j += XPOSE_STEP) {
-                res(j + 0, i + 0) = elements[n_cols * (i + 0) + (j + 0)];
-                res(j + 1, i + 0) = elements[n_cols * (i + 0) + (j + 1)];
-            }  // j
-            for (; j < n_cols; ++j) {
-                res(j + 0, i + 0) = elements[n_cols * (i + 0) + (j + 0)];
-            }  // j
-        }  // i
+        Matrix res = Matrix(std::make_pair(n_cols, n_rows));
+        std::size_t block = Blocking::XPOSE;
+        TuningProfile::instance().findTranspose(TypeName<T>::get(), block);
+#ifdef MATRIX_X86
+        const bool avx512 = sizeof(T) == 4 && cpuFeatures().avx512f;
+        if (avx512)
+            block = std::max<std::size_t>(block / 16, 1) * 16;
+#endif
+        for (mat_size_t ii = 0; ii < n_rows; ii += block) {
+            const mat_size_t iEnd = static_cast<mat_size_t>(std::min<std::size_t>(n_rows, ii + block));
+            for (mat_size_t jj = 0; jj < n_cols; jj += block) {
+                const mat_size_t jEnd = static_cast<mat_size_t>(std::min<std::size_t>(n_cols, jj + block));
+#ifdef MATRIX_X86
+                if (avx512) {
+                    for (mat_size_t i = ii; i < iEnd; i += 16) {
+                        for (mat_size_t j = jj; j < jEnd; j += 16) {
+                            matmul::avx512::transpose16x16(&elements[n_cols * i + j], n_cols, &res(j, i), n_rows,
+                                                           std::min<mat_size_t>(16, iEnd - i),
+                                                           std::min<mat_size_t>(16, jEnd - j));
+                        }  // j
+                    }  // i
+                    continue;
+                }
+#endif
+                for (mat_size_t i = ii; i < iEnd; ++i) {
+                    for (mat_size_t j = jj; j < jEnd; ++j) {
+                        res(j, i) = elements[n_cols * i + j];
+                    }  // j
+                }  // i
+            }  // jj
+        }  // ii
         return res;
     }
 
     /**
-     * Optimized matrix multiplication mostly drawn from Wikipedia: https://goo.gl/JRWcsB, and some conversations on
-     * StackOverflow. Uses loop tiling and unrolling to perform matrix multiplication.
+     * Optimized matrix multiplication. Both operands are packed into contiguous, cache-sized panels and multiplied
+     * with a register-blocked micro-kernel; see gemm.h for the details of the blocking. Large floating point products
+     * go through Strassen-Winograd first (see strassen.h and setStrassenEnabled()). Products with a single row or
+     * column are matrix-vector products and go through the GEMV kernels of gemv.h instead.
      *
      * @param other Another matrix instance.
      * @return A Matrix instance resulting from the multiplication of this and other.
      */
-    virtual Matrix<T> operator*(Matrix<T>& other) {
+    virtual Matrix operator*(Matrix& other) {
         if (this->empty() || other.empty())
             throw empty_matrix();
         if (this->n_cols != other.shape(0)) {
             throw size_mismatch();
         }
 
-        Matrix<T> res = Matrix<T>(std::make_pair(this->n_rows, other.shape(1)));
-        mat_size_t ii;
-        for (ii = 0; ii + I_BLOCK_SZ < this->n_rows; ii += I_BLOCK_SZ) {
-            mat_size_t kk;
-            for (kk = 0; kk + K_BLOCK_SZ < this->n_cols; kk += K_BLOCK_SZ) {
-                mat_size_t j;
-                for (j = 0; j + MATMUL_STEP < other.shape(1); j += MATMUL_STEP) {
-                    mat_size_t i;
-                    for (i = ii; i < ii + I_BLOCK_SZ; i += MATMUL_STEP) {
-                        this->blockDotNxN(i, j, kk, other, res);
-                    }  // i
-                    for (; i < ii + I_BLOCK_SZ; ++i) {  // Clean up the last few rows that didn't align with MATMUL_STEP
-                        this->blockDot1xN(i, j, kk, other, res);
-                    }  // i
-                }  // j
-                for (; j < other.shape(1); ++j) {  // Clean up the last few columns that didn't align with MATMUL_STEP
-                    mat_size_t i;
-                    for (i = ii; i < ii + I_BLOCK_SZ; i += MATMUL_STEP) {
-                        this->blockDotNx1(i, j, kk, other, res);
-                    }  // i
-                    for (; i < ii + I_BLOCK_SZ; ++i) {  // Clean up the last few rows that didn't align with MATMUL_STEP
-                        this->dot(i, j, kk, other, res);
-                    }  // i
-                }  // j
-            }  // kk
-            mat_size_t j;  // Clean up columns and row that didn't align with K_BLOCK_SZ
-            for (j = 0; j + MATMUL_STEP < other.shape(1); j += MATMUL_STEP) {
-                mat_size_t i;
-                for (i = ii; i < ii + I_BLOCK_SZ; i += MATMUL_STEP) {
-                    this->blockDotNxN(i, j, kk, other, res);
-                }  // i
-                for (; i < ii + I_BLOCK_SZ; ++i) {  // Clean up the last few rows that didn't align with MATMUL_STEP
-                    this->blockDot1xN(i, j, kk, other, res);
-                }  // i
-            }  // j
-            for (; j < other.shape(1); ++j) {  // Clean up the last few columns that didn't align with MATMUL_STEP
-                mat_size_t i;
-                for (i = ii; i < ii + I_BLOCK_SZ; i += MATMUL_STEP) {
-                    this->blockDotNx1(i, j, kk, other, res);
-                }  // i
-                for (; i < ii + I_BLOCK_SZ; ++i) {  // Clean up the last few rows that didn't align with MATMUL_STEP
-                    this->dot(i, j, kk, other, res);
-                }  // i
-            }  // j
-        }  // ii
-        mat_size_t kk;  // Clean up columns and row that didn't align with I_BLOCK_SZ
-        for (kk = 0; kk + K_BLOCK_SZ < this->n_cols; kk += K_BLOCK_SZ) {
-            mat_size_t j;
-            for (j = 0; j + MATMUL_STEP < other.shape(1); j += MATMUL_STEP) {
-                mat_size_t i;
-                for (i = ii; i + MATMUL_STEP < this->n_rows; i += MATMUL_STEP) {
-                    this->blockDotNxN(i, j, kk, other, res);
-                }  // i
-                for (; i < this->n_rows; ++i) {  // Clean up the last few rows that didn't align with MATMUL_STEP
-                    this->blockDot1xN(i, j, kk, other, res);
-                }  // i
-            }  // j
-            for (; j < other.shape(1); ++j) {  // Clean up the last few columns that didn't align with MATMUL_STEP
-                mat_size_t i;
-                for (i = ii; i + MATMUL_STEP < this->n_rows; i += MATMUL_STEP) {
-                    this->blockDotNx1(i, j, kk, other, res);
-                }  // i
-                for (; i < this->n_rows; ++i) {  // Clean up the last few rows that didn't align with MATMUL_STEP
-                    this->dot(i, j, kk, other, res);
-                }  // i
-            }  // j
-        }  // kk
-        mat_size_t j;  // Clean up columns and row that didn't align with K_BLOCK_SZ
-        for (j = 0; j + MATMUL_STEP < other.shape(1); j += MATMUL_STEP) {
-            mat_size_t i;
-            for (i = ii; i + MATMUL_STEP < this->n_rows; i += MATMUL_STEP) {
-                this->blockDotNxN(i, j, kk, other, res);
-            }  // i
-            for (; i < this->n_rows; ++i) {  // Clean up the last few rows
-                this->blockDot1xN(i, j, kk, other, res);
-            }  // i
-        }  // j
-        for (; j < other.shape(1); ++j) {  // Clean up the remaining last few columns
-            mat_size_t i;
-            for (i = ii; i + MATMUL_STEP < this->n_rows; i += MATMUL_STEP) {
-                this->blockDotNx1(i, j, kk,  other, res);
-            }  // i
-            for (; i < this->n_rows; ++i) {  // Clean up the last few rows
-                this->dot(i, j, kk, other, res);
-            }  // i
-        }  // j
+        Matrix res = Matrix(std::make_pair(this->n_rows, other.shape(1)));
+        if (other.n_cols == 1) {
+            matmul::gemv(n_rows, n_cols, elements.data(), n_cols, other.elements.data(), res.elements.data());
+            return res;
+        }
+        if (n_rows == 1) {
+            matmul::gemvTransposed(other.n_rows, other.n_cols, other.elements.data(), other.n_cols,
+                                   elements.data(), res.elements.data());
+            return res;
+        }
+        matmul::strassenMultiply<T, Blocking>(n_rows, other.n_cols, n_cols,
+                                              elements.data(), n_cols, 1,
+                                              other.elements.data(), other.n_cols, 1,
+                                              res.elements.data(), res.n_cols);
         return res;
     }
 
-    bool operator==(const Matrix<T>& mat) const {
+    /**
+     * Matrix-vector multiplication, for callers that keep vectors in plain containers rather than n x 1 matrices.
+     *
+     * @param x A vector of shape(1) elements.
+     * @return The shape(0) elements of this * x.
+     */
+    std::vector<T> operator*(const std::vector<T>& x) const {
+        if (elements.empty() || x.empty())
+            throw empty_matrix();
+        if (x.size() != n_cols)
+            throw size_mismatch();
+
+        std::vector<T> y(n_rows);
+        matmul::gemv(n_rows, n_cols, elements.data(), n_cols, x.data(), y.data());
+        return y;
+    }
+
+    bool operator==(const Matrix& mat) const {
         if (n_rows != mat.shape(0) || n_cols != mat.shape(1))
             return false;
 
@@ -255,6 +233,15 @@ public:
         }
     };
 
+    /**
+     * Thrown when solving a system or inverting a matrix that is singular
+     */
+    struct singular_matrix : public std::exception {
+        const char* what() const throw() final {
+            return "Matrix is singular";
+        }
+    };
+
     /**
      * Thrown when requesting an invalid shape parameter (i.e. anything other than 0 or 1)
      */
@@ -267,331 +254,106 @@ public:
 protected:
     mat_size_t n_rows, n_cols;
     std::vector<T> elements;
+};
 
-    /**
-     * Computes the dot product over NxN blocks of elements of two matrices
-     *
-     * @param i Current index of i in the matrix multiplication operation
-     * @param j Current index of j in the matrix multiplication operation
-     * @param kk Current index of kk in the matrix multiplication operation
-     * @param other An instance of the multiplicand(?) Matrix
-     * @param res The result which into which the dot product will be stored
-     */
-    inline void blockDotNxN(mat_size_t i, mat_size_t j, mat_size_t kk, Matrix<T> &other, Matrix<T> &res) {
-        register T acc00, acc10, acc20, acc30, acc40, acc50, acc60, acc70;
-        register T acc01, acc11, acc21, acc31, acc41, acc51, acc61, acc71;
-        register T acc02, acc12, acc22, acc32, acc42, acc52, acc62, acc72;
-        register T acc03, acc13, acc23, acc33, acc43, acc53, acc63, acc73;
-        register T acc04, acc14, acc24, acc34, acc44, acc54, acc64, acc74;
-        register T acc05, acc15, acc25, acc35, acc45, acc55, acc65, acc75;
-        register T acc06, acc16, acc26, acc36, acc46, acc56, acc66, acc76;
-        register T acc07, acc17, acc27, acc37, acc47, acc57, acc67, acc77;
-
-        if (kk == 0) {
-            acc00 = 0, acc10 = 0, acc20 = 0, acc30 = 0, acc40 = 0, acc50 = 0, acc60 = 0, acc70 = 0;
-            acc01 = 0, acc11 = 0, acc21 = 0, acc31 = 0, acc41 = 0, acc51 = 0, acc61 = 0, acc71 = 0;
-            acc02 = 0, acc12 = 0, acc22 = 0, acc32 = 0, acc42 = 0, acc52 = 0, acc62 = 0, acc72 = 0;
-            acc03 = 0, acc13 = 0, acc23 = 0, acc33 = 0, acc43 = 0, acc53 = 0, acc63 = 0, acc73 = 0;
-            acc04 = 0, acc14 = 0, acc24 = 0, acc34 = 0, acc44 = 0, acc54 = 0, acc64 = 0, acc74 = 0;
-            acc05 = 0, acc15 = 0, acc25 = 0, acc35 = 0, acc45 = 0, acc55 = 0, acc65 = 0, acc75 = 0;
-            acc06 = 0, acc16 = 0, acc26 = 0, acc36 = 0, acc46 = 0, acc56 = 0, acc66 = 0, acc76 = 0;
-            acc07 = 0, acc17 = 0, acc27 = 0, acc37 = 0, acc47 = 0, acc57 = 0, acc67 = 0, acc77 = 0;
-        } else {
-            acc00 = res(i + 0, j + 0); acc04 = res(i + 0, j + 4);
-            acc01 = res(i + 0, j + 1); acc05 = res(i + 0, j + 5);
-            acc02 = res(i + 0, j + 2); acc06 = res(i + 0, j + 6);
-            acc03 = res(i + 0, j + 3); acc07 = res(i + 0, j + 7);
-
-            acc10 = res(i + 1, j + 0); acc14 = res(i + 1, j + 4);
-            acc11 = res(i + 1, j + 1); acc15 = res(i + 1, j + 5);
-            acc12 = res(i + 1, j + 2); acc16 = res(i + 1, j + 6);
-            acc13 = res(i + 1, j + 3); acc17 = res(i + 1, j + 7);
-
-            acc20 = res(i + 2, j + 0); acc24 = res(i + 2, j + 4);
-            acc21 = res(i + 2, j + 1); acc25 = res(i + 2, j + 5);
-            acc22 = res(i + 2, j + 2); acc26 = res(i + 2, j + 6);
-            acc23 = res(i + 2, j + 3); acc27 = res(i + 2, j + 7);
-
-            acc30 = res(i + 3, j + 0); acc34 = res(i + 3, j + 4);
-            acc31 = res(i + 3, j + 1); acc35 = res(i + 3, j + 5);
-            acc32 = res(i + 3, j + 2); acc36 = res(i + 3, j + 6);
-            acc33 = res(i + 3, j + 3); acc37 = res(i + 3, j + 7);
-
-            acc40 = res(i + 4, j + 0); acc44 = res(i + 4, j + 4);
-            acc41 = res(i + 4, j + 1); acc45 = res(i + 4, j + 5);
-            acc42 = res(i + 4, j + 2); acc46 = res(i + 4, j + 6);
-            acc43 = res(i + 4, j + 3); acc47 = res(i + 4, j + 7);
-
-            acc50 = res(i + 5, j + 0); acc54 = res(i + 5, j + 4);
-            acc51 = res(i + 5, j + 1); acc55 = res(i + 5, j + 5);
-            acc52 = res(i + 5, j + 2); acc56 = res(i + 5, j + 6);
-            acc53 = res(i + 5, j + 3); acc57 = res(i + 5, j + 7);
-
-            acc60 = res(i + 6, j + 0); acc64 = res(i + 6, j + 4);
-            acc61 = res(i + 6, j + 1); acc65 = res(i + 6, j + 5);
-            acc62 = res(i + 6, j + 2); acc66 = res(i + 6, j + 6);
-            acc63 = res(i + 6, j + 3); acc67 = res(i + 6, j + 7);
-
-            acc70 = res(i + 7, j + 0); acc74 = res(i + 7, j + 4);
-            acc71 = res(i + 7, j + 1); acc75 = res(i + 7, j + 5);
-            acc72 = res(i + 7, j + 2); acc76 = res(i + 7, j + 6);
-            acc73 = res(i + 7, j + 3); acc77 = res(i + 7, j + 7);
-        }
-
-        for (mat_size_t k = kk; k < kk + K_BLOCK_SZ && k < this->n_cols; ++k) {
-            acc00 += elements[n_cols * (i + 0) + k] * other(k, j + 0);
-            acc01 += elements[n_cols * (i + 0) + k] * other(k, j + 1);
-            acc02 += elements[n_cols * (i + 0) + k] * other(k, j + 2);
-            acc03 += elements[n_cols * (i + 0) + k] * other(k, j + 3);
-            acc04 += elements[n_cols * (i + 0) + k] * other(k, j + 4);
-            acc05 += elements[n_cols * (i + 0) + k] * other(k, j + 5);
-            acc06 += elements[n_cols * (i + 0) + k] * other(k, j + 6);
-            acc07 += elements[n_cols * (i + 0) + k] * other(k, j + 7);
-
-            acc10 += elements[n_cols * (i + 1) + k] * other(k, j + 0);
-            acc11 += elements[n_cols * (i + 1) + k] * other(k, j + 1);
-            acc12 += elements[n_cols * (i + 1) + k] * other(k, j + 2);
-            acc13 += elements[n_cols * (i + 1) + k] * other(k, j + 3);
-            acc14 += elements[n_cols * (i + 1) + k] * other(k, j + 4);
-            acc15 += elements[n_cols * (i + 1) + k] * other(k, j + 5);
-            acc16 += elements[n_cols * (i + 1) + k] * other(k, j + 6);
-            acc17 += elements[n_cols * (i + 1) + k] * other(k, j + 7);
-
-            acc20 += elements[n_cols * (i + 2) + k] * other(k, j + 0);
-            acc21 += elements[n_cols * (i + 2) + k] * other(k, j + 1);
-            acc22 += elements[n_cols * (i + 2) + k] * other(k, j + 2);
-            acc23 += elements[n_cols * (i + 2) + k] * other(k, j + 3);
-            acc24 += elements[n_cols * (i + 2) + k] * other(k, j + 4);
-            acc25 += elements[n_cols * (i + 2) + k] * other(k, j + 5);
-            acc26 += elements[n_cols * (i + 2) + k] * other(k, j + 6);
-            acc27 += elements[n_cols * (i + 2) + k] * other(k, j + 7);
-
-            acc30 += elements[n_cols * (i + 3) + k] * other(k, j + 0);
-            acc31 += elements[n_cols * (i + 3) + k] * other(k, j + 1);
-            acc32 += elements[n_cols * (i + 3) + k] * other(k, j + 2);
-            acc33 += elements[n_cols * (i + 3) + k] * other(k, j + 3);
-            acc34 += elements[n_cols * (i + 3) + k] * other(k, j + 4);
-            acc35 += elements[n_cols * (i + 3) + k] * other(k, j + 5);
-            acc36 += elements[n_cols * (i + 3) + k] * other(k, j + 6);
-            acc37 += elements[n_cols * (i + 3) + k] * other(k, j + 7);
-
-            acc40 += elements[n_cols * (i + 4) + k] * other(k, j + 0);
-            acc41 += elements[n_cols * (i + 4) + k] * other(k, j + 1);
-            acc42 += elements[n_cols * (i + 4) + k] * other(k, j + 2);
-            acc43 += elements[n_cols * (i + 4) + k] * other(k, j + 3);
-            acc44 += elements[n_cols * (i + 4) + k] * other(k, j + 4);
-            acc45 += elements[n_cols * (i + 4) + k] * other(k, j + 5);
-            acc46 += elements[n_cols * (i + 4) + k] * other(k, j + 6);
-            acc47 += elements[n_cols * (i + 4) + k] * other(k, j + 7);
-
-            acc50 += elements[n_cols * (i + 5) + k] * other(k, j + 0);
-            acc51 += elements[n_cols * (i + 5) + k] * other(k, j + 1);
-            acc52 += elements[n_cols * (i + 5) + k] * other(k, j + 2);
-            acc53 += elements[n_cols * (i + 5) + k] * other(k, j + 3);
-            acc54 += elements[n_cols * (i + 5) + k] * other(k, j + 4);
-            acc55 += elements[n_cols * (i + 5) + k] * other(k, j + 5);
-            acc56 += elements[n_cols * (i + 5) + k] * other(k, j + 6);
-            acc57 += elements[n_cols * (i + 5) + k] * other(k, j + 7);
-
-            acc60 += elements[n_cols * (i + 6) + k] * other(k, j + 0);
-            acc61 += elements[n_cols * (i + 6) + k] * other(k, j + 1);
-            acc62 += elements[n_cols * (i + 6) + k] * other(k, j + 2);
-            acc63 += elements[n_cols * (i + 6) + k] * other(k, j + 3);
-            acc64 += elements[n_cols * (i + 6) + k] * other(k, j + 4);
-            acc65 += elements[n_cols * (i + 6) + k] * other(k, j + 5);
-            acc66 += elements[n_cols * (i + 6) + k] * other(k, j + 6);
-            acc67 += elements[n_cols * (i + 6) + k] * other(k, j + 7);
-
-            acc70 += elements[n_cols * (i + 7) + k] * other(k, j + 0);
-            acc71 += elements[n_cols * (i + 7) + k] * other(k, j + 1);
-            acc72 += elements[n_cols * (i + 7) + k] * other(k, j + 2);
-            acc73 += elements[n_cols * (i + 7) + k] * other(k, j + 3);
-            acc74 += elements[n_cols * (i + 7) + k] * other(k, j + 4);
-            acc75 += elements[n_cols * (i + 7) + k] * other(k, j + 5);
-            acc76 += elements[n_cols * (i + 7) + k] * other(k, j + 6);
-            acc77 += elements[n_cols * (i + 7) + k] * other(k, j + 7);
-        }  // k
-
-        res(i + 0, j + 0) = acc00;
-        res(i + 0, j + 1) = acc01;
-        res(i + 0, j + 2) = acc02;
-        res(i + 0, j + 3) = acc03;
-        res(i + 0, j + 4) = acc04;
-        res(i + 0, j + 5) = acc05;
-        res(i + 0, j + 6) = acc06;
-        res(i + 0, j + 7) = acc07;
-
-        res(i + 1, j + 0) = acc10;
-        res(i + 1, j + 1) = acc11;
-        res(i + 1, j + 2) = acc12;
-        res(i + 1, j + 3) = acc13;
-        res(i + 1, j + 4) = acc14;
-        res(i + 1, j + 5) = acc15;
-        res(i + 1, j + 6) = acc16;
-        res(i + 1, j + 7) = acc17;
-
-        res(i + 2, j + 0) = acc20;
-        res(i + 2, j + 1) = acc21;
-        res(i + 2, j + 2) = acc22;
-        res(i + 2, j + 3) = acc23;
-        res(i + 2, j + 4) = acc24;
-        res(i + 2, j + 5) = acc25;
-        res(i + 2, j + 6) = acc26;
-        res(i + 2, j + 7) = acc27;
-
-        res(i + 3, j + 0) = acc30;
-        res(i + 3, j + 1) = acc31;
-        res(i + 3, j + 2) = acc32;
-        res(i + 3, j + 3) = acc33;
-        res(i + 3, j + 4) = acc34;
-        res(i + 3, j + 5) = acc35;
-        res(i + 3, j + 6) = acc36;
-        res(i + 3, j + 7) = acc37;
-
-        res(i + 4, j + 0) = acc40;
-        res(i + 4, j + 1) = acc41;
-        res(i + 4, j + 2) = acc42;
-        res(i + 4, j + 3) = acc43;
-        res(i + 4, j + 4) = acc44;
-        res(i + 4, j + 5) = acc45;
-        res(i + 4, j + 6) = acc46;
-        res(i + 4, j + 7) = acc47;
-
-        res(i + 5, j + 0) = acc50;
-        res(i + 5, j + 1) = acc51;
-        res(i + 5, j + 2) = acc52;
-        res(i + 5, j + 3) = acc53;
-        res(i + 5, j + 4) = acc54;
-        res(i + 5, j + 5) = acc55;
-        res(i + 5, j + 6) = acc56;
-        res(i + 5, j + 7) = acc57;
-
-        res(i + 6, j + 0) = acc60;
-        res(i + 6, j + 1) = acc61;
-        res(i + 6, j + 2) = acc62;
-        res(i + 6, j + 3) = acc63;
-        res(i + 6, j + 4) = acc64;
-        res(i + 6, j + 5) = acc65;
-        res(i + 6, j + 6) = acc66;
-        res(i + 6, j + 7) = acc67;
-
-        res(i + 7, j + 0) = acc70;
-        res(i + 7, j + 1) = acc71;
-        res(i + 7, j + 2) = acc72;
-        res(i + 7, j + 3) = acc73;
-        res(i + 7, j + 4) = acc74;
-        res(i + 7, j + 5) = acc75;
-        res(i + 7, j + 6) = acc76;
-        res(i + 7, j + 7) = acc77;
-    }
-
-    /**
-     * Computes the dot product over Nx1 blocks of elements of two matrices. Mainly used to clean up the last few
-     * columns along a block of multilpications that don't align with the block.
-     *
-     * @param i Current index of i in the matrix multiplcation operation
-     * @param j Current index of j in the matrix multiplcation operation
-     * @param kk Current index of kk in the matrix multiplcation operation
-     * @param other An instance of the multiplicand(?) Matrix
-     * @param res The result which into which the dot product will be stored
-     */
-    inline void blockDotNx1(mat_size_t i, mat_size_t j, mat_size_t kk, Matrix<T> &other, Matrix<T> &res) {
-        register T acc00, acc10, acc20, acc30, acc40, acc50, acc60, acc70;
-
-        if (kk == 0) {
-            acc00 = 0, acc10 = 0, acc20 = 0, acc30 = 0, acc40 = 0, acc50 = 0, acc60 = 0, acc70 = 0;
-        } else {
-            acc00 = res(i + 0, j + 0); acc40 = res(i + 4, j + 0);
-            acc10 = res(i + 1, j + 0); acc50 = res(i + 5, j + 0);
-            acc20 = res(i + 2, j + 0); acc60 = res(i + 6, j + 0);
-            acc30 = res(i + 3, j + 0); acc70 = res(i + 7, j + 0);
-        }
-
-        for (mat_size_t k = kk; k < kk + K_BLOCK_SZ && k < this->n_cols; ++k) {
-            acc00 += elements[n_cols * (i + 0) + k] * other(k, j + 0);
-            acc10 += elements[n_cols * (i + 1) + k] * other(k, j + 0);
-            acc20 += elements[n_cols * (i + 2) + k] * other(k, j + 0);
-            acc30 += elements[n_cols * (i + 3) + k] * other(k, j + 0);
-            acc40 += elements[n_cols * (i + 4) + k] * other(k, j + 0);
-            acc50 += elements[n_cols * (i + 5) + k] * other(k, j + 0);
-            acc60 += elements[n_cols * (i + 6) + k] * other(k, j + 0);
-            acc70 += elements[n_cols * (i + 7) + k] * other(k, j + 0);
-        }  // k
-
-        res(i + 0, j + 0) = acc00;
-        res(i + 1, j + 0) = acc10;
-        res(i + 2, j + 0) = acc20;
-        res(i + 3, j + 0) = acc30;
-        res(i + 4, j + 0) = acc40;
-        res(i + 5, j + 0) = acc50;
-        res(i + 6, j + 0) = acc60;
-        res(i + 7, j + 0) = acc70;
+/**
+ * Multiplication of op(a) by op(b), where op(x) is x or its transpose, without forming the transposes: the packing
+ * stage of the GEMM reads transposed operands in their original layout. Otherwise the same as operator*.
+ *
+ * @return A Matrix instance holding op(a) * op(b).
+ */
+template <typename T, typename Blocking>
+Matrix<T, Blocking> multiply(const Matrix<T, Blocking>& a, matmul::Transpose transA,
+                             const Matrix<T, Blocking>& b, matmul::Transpose transB) {
+    if (a.shape(0) == 0 || a.shape(1) == 0 || b.shape(0) == 0 || b.shape(1) == 0)
+        throw typename Matrix<T, Blocking>::empty_matrix();
+    const bool ta = transA == matmul::TRANSPOSE, tb = transB == matmul::TRANSPOSE;
+    const mat_size_t m = a.shape(ta ? 1 : 0), k = a.shape(ta ? 0 : 1);
+    const mat_size_t n = b.shape(tb ? 0 : 1);
+    if (k != b.shape(tb ? 1 : 0))
+        throw typename Matrix<T, Blocking>::size_mismatch();
+
+    Matrix<T, Blocking> res = Matrix<T, Blocking>(std::make_pair(m, n));
+    const T* pa = &a(0, 0);
+    const T* pb = &b(0, 0);
+    T* pc = &res(0, 0);
+    // A single row or column is contiguous either way round, so these are plain matrix-vector products
+    if (n == 1) {
+        if (ta)
+            matmul::gemvTransposed(k, m, pa, m, pb, pc);
+        else
+            matmul::gemv(m, k, pa, k, pb, pc);
+        return res;
     }
-
-    /**
-     * Computes the dot product over Nx1 blocks of elements of two matrices. Mainly used to clean up the last few
-     * rows along a block of multiplications that don't align with the block.
-     *
-     * @param i Current index of i in the matrix multiplication operation
-     * @param j Current index of j in the matrix multiplication operation
-     * @param kk Current index of kk in the matrix multiplication operation
-     * @param other An instance of the multiplicand(?) Matrix
-     * @param res The result which into which the dot product will be stored
-     */
-    inline void blockDot1xN(mat_size_t i, mat_size_t j, mat_size_t kk, Matrix<T> &other, Matrix<T> &res) {
-        register T acc00, acc01, acc02, acc03, acc04, acc05, acc06, acc07;
-
-        if (kk == 0) {
-            acc00 = 0;  acc01 = 0; acc02 = 0; acc03 = 0; acc04 = 0; acc05 = 0; acc06 = 0; acc07 = 0;
-        } else {
-            acc00 = res(i + 0, j + 0); acc04 = res(i + 0, j + 4);
-            acc01 = res(i + 0, j + 1); acc05 = res(i + 0, j + 5);
-            acc02 = res(i + 0, j + 2); acc06 = res(i + 0, j + 6);
-            acc03 = res(i + 0, j + 3); acc07 = res(i + 0, j + 7);
-        }
-
-        for (mat_size_t k = kk; k < kk + K_BLOCK_SZ && k < this->n_cols; ++k) {
-            acc00 += elements[n_cols * (i + 0) + k] * other(k, j + 0);
-            acc01 += elements[n_cols * (i + 0) + k] * other(k, j + 1);
-            acc02 += elements[n_cols * (i + 0) + k] * other(k, j + 2);
-            acc03 += elements[n_cols * (i + 0) + k] * other(k, j + 3);
-            acc04 += elements[n_cols * (i + 0) + k] * other(k, j + 4);
-            acc05 += elements[n_cols * (i + 0) + k] * other(k, j + 5);
-            acc06 += elements[n_cols * (i + 0) + k] * other(k, j + 6);
-            acc07 += elements[n_cols * (i + 0) + k] * other(k, j + 7);
-        }  // k
-
-        res(i + 0, j + 0) = acc00;
-        res(i + 0, j + 1) = acc01;
-        res(i + 0, j + 2) = acc02;
-        res(i + 0, j + 3) = acc03;
-        res(i + 0, j + 4) = acc04;
-        res(i + 0, j + 5) = acc05;
-        res(i + 0, j + 6) = acc06;
-        res(i + 0, j + 7) = acc07;
+    if (m == 1) {
+        if (tb)
+            matmul::gemv(n, k, pb, k, pa, pc);
+        else
+            matmul::gemvTransposed(k, n, pb, n, pa, pc);
+        return res;
     }
 
-    /**
-     * Computes just the ordinary dot product. Used to clean up the last few elements that well outside the row and cell
-     * blocks.
-     *
-     * @param i Current index of i in the matrix multiplication operation
-     * @param j Current index of j in the matrix multiplication operation
-     * @param kk Current index of kk in the matrix multiplication operation
-     * @param other An instance of the multiplicand(?) Matrix
-     * @param res The result which into which the dot product will be stored
-     */
-    inline void dot(mat_size_t i, mat_size_t j, mat_size_t kk, Matrix<T>& other, Matrix<T>& res) {
-        register T acc00 = 0;
-
-        acc00 = (kk == 0) ? 0 : res(i + 0, j + 0);
-
-        for (mat_size_t k = kk; k < kk + K_BLOCK_SZ && k < this->n_cols; ++k) {
-            acc00 += elements[n_cols*(i + 0) + k] * other(k, j + 0);
-        }  // k
-        res(i + 0, j + 0) = acc00;
-    }
-};
+    std::ptrdiff_t rsA, csA, rsB, csB;
+    matmul::operandStrides(transA, a.shape(1), rsA, csA);
+    matmul::operandStrides(transB, b.shape(1), rsB, csB);
+    matmul::strassenMultiply<T, Blocking>(m, n, k, pa, rsA, csA, pb, rsB, csB, pc, n);
+    return res;
+}
+
+/**
+ * BLAS-style in-place update c = alpha * op(a) * op(b) + beta * c, where op(x) is x or its transpose. Writes into
+ * the caller's matrix with the scaling fused into the GEMM's stores, so loops that reuse c run without allocating.
+ * Always uses the blocked GEMM, never Strassen-Winograd.
+ *
+ * @throws Matrix<T>::empty_matrix if a or b is empty
+ * @throws Matrix<T>::size_mismatch if op(a) and op(b) cannot be multiplied or c is not the shape of the product
+ */
+template <typename T, typename Blocking>
+void gemm(T alpha, const Matrix<T, Blocking>& a, matmul::Transpose transA,
+          const Matrix<T, Blocking>& b, matmul::Transpose transB, T beta, Matrix<T, Blocking>& c) {
+    if (a.shape(0) == 0 || a.shape(1) == 0 || b.shape(0) == 0 || b.shape(1) == 0)
+        throw typename Matrix<T, Blocking>::empty_matrix();
+    const bool ta = transA == matmul::TRANSPOSE, tb = transB == matmul::TRANSPOSE;
+    const mat_size_t m = a.shape(ta ? 1 : 0), k = a.shape(ta ? 0 : 1);
+    const mat_size_t n = b.shape(tb ? 0 : 1);
+    if (k != b.shape(tb ? 1 : 0) || c.shape(0) != m || c.shape(1) != n)
+        throw typename Matrix<T, Blocking>::size_mismatch();
+
+    matmul::gemm<T, Blocking>(transA, transB, m, n, k, alpha, &a(0, 0), a.shape(1), &b(0, 0), b.shape(1),
+                              beta, &c(0, 0), n);
+}
+
+/**
+ * Vector-matrix multiplication, computed as A^T * x without forming the transpose.
+ *
+ * @param x A vector of mat.shape(0) elements.
+ * @return The mat.shape(1) elements of x^T * mat.
+ */
+template <typename T, typename Blocking>
+std::vector<T> operator*(const std::vector<T>& x, const Matrix<T, Blocking>& mat) {
+    if (mat.shape(0) == 0 || mat.shape(1) == 0 || x.empty())
+        throw typename Matrix<T, Blocking>::empty_matrix();
+    if (x.size() != mat.shape(0))
+        throw typename Matrix<T, Blocking>::size_mismatch();
+
+    std::vector<T> y(mat.shape(1));
+    matmul::gemvTransposed(mat.shape(0), mat.shape(1), &mat(0, 0), mat.shape(1), x.data(), y.data());
+    return y;
+}
+
+/**
+ * Converts every element of a matrix to another type, e.g. between Matrix<float> and the half precision types of
+ * halfFloat.h, which have vectorized conversions.
+ * @return A new Matrix instance of the same shape.
+ */
+template <typename To, typename From, typename Blocking>
+Matrix<To> convert(const Matrix<From, Blocking>& mat) {
+    const mat_size_t rows = mat.shape(0), cols = mat.shape(1);
+    Matrix<To> res = Matrix<To>(std::make_pair(rows, cols));
+    if (rows > 0 && cols > 0)
+        matmul::convertArray(static_cast<std::size_t>(rows) * cols, &mat(0, 0), &res(0, 0));
+    return res;
+}
 
 
 
@@ -0,0 +1,488 @@
+#ifndef MATRIX_QR_H
+#define MATRIX_QR_H
+
+#include <cmath>
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+#include <type_traits>
+
+#include "blocking.h"
+#include "gemm.h"
+#include "threadPool.h"
+#include "lu.h"
+#include "matrix.h"
+
+/**
+ * Householder QR factorization A = Q * R of tall matrices, and least squares on top of it. Each panel of QR_BLOCK
+ * reflectors is kept in the compact WY form I - V * T * V^T, T being upper triangular, so applying the panel to the
+ * trailing columns, or to a right-hand side, is two GEMMs with V and a small triangular product with T. The panel
+ * itself is factored recursively by halves down to QR_LEAF columns, merging the T factors of the halves, so it also
+ * goes through the GEMM. V is read where it is stored, below the diagonal of A: the unit triangle at its top, which
+ * shares its place with R, is handled apart.
+ *
+ * The tall-skinny mode (TSQR) factors blocks of rows independently on the thread pool, then factors their stacked
+ * R factors, so the long dimension is split across threads rather than only the GEMM tiles of each update.
+ */
+namespace matmul {
+
+    /**
+     * Reflectors per panel of the blocked factorization.
+     */
+    const std::size_t QR_BLOCK = 64;
+
+    /**
+     * Panels of at most this many columns are factored column by column.
+     */
+    const std::size_t QR_LEAF = 16;
+
+    enum QrMode { BLOCKED_QR, TALL_SKINNY_QR };
+
+    /**
+     * Computes W = V^T * C for the r x k unit lower trapezoidal matrix V stored below the diagonal of v, r >= k,
+     * and an r x cols matrix C. W is k x cols.
+     */
+    template <typename T, typename Blocking>
+    void reflectorsTransposedTimes(std::size_t r, std::size_t k, const T* v, std::size_t ldv,
+                                   std::size_t cols, const T* c, std::size_t ldc, T* w, std::size_t ldw) {
+        if (r > k) {
+            gemm<T, Blocking>(TRANSPOSE, NO_TRANSPOSE, k, cols, r - k, T(1), v + k * ldv, ldv, c + k * ldc, ldc,
+                              T(0), w, ldw);
+        } else {
+            for (std::size_t i = 0; i < k; ++i)
+                std::fill(w + i * ldw, w + i * ldw + cols, T(0));
+        }
+        for (std::size_t i = 0; i < k; ++i) {
+            const T* ci = c + i * ldc;
+            for (std::size_t p = 0; p <= i; ++p) {
+                const T vip = p == i ? T(1) : v[i * ldv + p];
+                T* wp = w + p * ldw;
+                for (std::size_t j = 0; j < cols; ++j)
+                    wp[j] += vip * ci[j];
+            }  // p
+        }  // i
+    }
+
+    /**
+     * Computes C -= V * W for V as in reflectorsTransposedTimes() and a k x cols matrix W.
+     */
+    template <typename T, typename Blocking>
+    void reflectorsTimesSubtract(std::size_t r, std::size_t k, const T* v, std::size_t ldv,
+                                 std::size_t cols, const T* w, std::size_t ldw, T* c, std::size_t ldc) {
+        if (r > k)
+            gemm<T, Blocking>(NO_TRANSPOSE, NO_TRANSPOSE, r - k, cols, k, T(-1), v + k * ldv, ldv, w, ldw,
+                              T(1), c + k * ldc, ldc);
+        for (std::size_t i = 0; i < k; ++i) {
+            T* ci = c + i * ldc;
+            for (std::size_t p = 0; p <= i; ++p) {
+                const T vip = p == i ? T(1) : v[i * ldv + p];
+                const T* wp = w + p * ldw;
+                for (std::size_t j = 0; j < cols; ++j)
+                    ci[j] -= vip * wp[j];
+            }  // p
+        }  // i
+    }
+
+    /**
+     * Computes W = T * W, or W = T^T * W when transposed is set, in place for the k x k upper triangular T.
+     */
+    template <typename T>
+    void triangularTimes(std::size_t k, const T* t, std::size_t ldt, bool transposed,
+                         std::size_t cols, T* w, std::size_t ldw) {
+        if (transposed) {
+            // Row i needs rows p <= i, so go bottom up
+            for (std::size_t i = k; i-- > 0;) {
+                T* wi = w + i * ldw;
+                const T tii = t[i * ldt + i];
+                for (std::size_t j = 0; j < cols; ++j)
+                    wi[j] *= tii;
+                for (std::size_t p = 0; p < i; ++p) {
+                    const T tpi = t[p * ldt + i];
+                    const T* wp = w + p * ldw;
+                    for (std::size_t j = 0; j < cols; ++j)
+                        wi[j] += tpi * wp[j];
+                }  // p
+            }  // i
+        } else {
+            for (std::size_t i = 0; i < k; ++i) {
+                T* wi = w + i * ldw;
+                const T tii = t[i * ldt + i];
+                for (std::size_t j = 0; j < cols; ++j)
+                    wi[j] *= tii;
+                for (std::size_t p = i + 1; p < k; ++p) {
+                    const T tip = t[i * ldt + p];
+                    const T* wp = w + p * ldw;
+                    for (std::size_t j = 0; j < cols; ++j)
+                        wi[j] += tip * wp[j];
+                }  // p
+            }  // i
+        }
+    }
+
+    /**
+     * Applies the block reflector H = I - V * T * V^T of k reflectors to the r x cols matrix C: C = H^T * C when
+     * transposed is set, C = H * C otherwise.
+     *
+     * @param w Scratch space of k x cols elements
+     */
+    template <typename T, typename Blocking>
+    void applyBlockReflector(bool transposed, std::size_t r, std::size_t k, const T* v, std::size_t ldv,
+                             const T* t, std::size_t ldt, std::size_t cols, T* c, std::size_t ldc, T* w) {
+        reflectorsTransposedTimes<T, Blocking>(r, k, v, ldv, cols, c, ldc, w, cols);
+        triangularTimes(k, t, ldt, transposed, cols, w, cols);
+        reflectorsTimesSubtract<T, Blocking>(r, k, v, ldv, cols, w, cols, c, ldc);
+    }
+
+    /**
+     * Forms the strict upper triangle of the T factor of the block reflector I - V * T * V^T, for the m x nb unit
+     * lower trapezoidal V stored below the diagonal of v and the reflector scalars already on the diagonal of t.
+     */
+    template <typename T>
+    void reflectorFactor(std::size_t m, std::size_t nb, const T* v, std::size_t ldv, T* t, std::size_t ldt) {
+        // T[0:c, c] = -tau_c * T[0:c, 0:c] * V[:, 0:c]^T * v_c, with the dot products g of the reflectors in one pass
+        std::vector<T> g(nb * nb, T(0));
+        for (std::size_t r = 1; r < m; ++r) {
+            const T* row = v + r * ldv;
+            for (std::size_t c = 1; c < nb && c <= r; ++c) {
+                const T vc = r == c ? T(1) : row[c];
+                for (std::size_t p = 0; p < c; ++p)
+                    g[p * nb + c] += row[p] * vc;
+            }  // c
+        }  // r
+        for (std::size_t c = 1; c < nb; ++c) {
+            const T tau = t[c * ldt + c];
+            for (std::size_t i = 0; i < c; ++i) {
+                T s = T(0);
+                for (std::size_t p = i; p < c; ++p)
+                    s += t[i * ldt + p] * g[p * nb + c];
+                t[i * ldt + c] = -tau * s;
+            }  // i
+        }  // c
+    }
+
+    /**
+     * Factors the m x nb panel at a column by column, m >= nb, and forms the upper triangle of its T factor. Each
+     * reflector takes two passes over the rows: one scaling v while it computes v^T times the remaining columns, one
+     * updating them while it computes the norm of the next column.
+     */
+    template <typename T>
+    void qrColumns(std::size_t m, std::size_t nb, T* a, std::size_t lda, T* t, std::size_t ldt) {
+        std::vector<T> w(nb);
+        T norm2 = T(0);
+        for (std::size_t r = 1; r < m; ++r)
+            norm2 += a[r * lda] * a[r * lda];
+
+        for (std::size_t c = 0; c < nb; ++c) {
+            T tau = T(0);
+            T next = T(0);
+            T* top = a + c * lda;
+            if (norm2 != T(0)) {
+                const T alpha = top[c];
+                const T beta = alpha > T(0) ? -std::sqrt(alpha * alpha + norm2) : std::sqrt(alpha * alpha + norm2);
+                tau = (beta - alpha) / beta;
+                const T scale = T(1) / (alpha - beta);
+                top[c] = beta;
+
+                // v = x / (alpha - beta) and w = v^T * columns c + 1..
+                std::copy(top + c + 1, top + nb, w.begin() + c + 1);
+                for (std::size_t r = c + 1; r < m; ++r) {
+                    T* row = a + r * lda;
+                    const T vr = row[c] *= scale;
+                    for (std::size_t q = c + 1; q < nb; ++q)
+                        w[q] += vr * row[q];
+                }  // r
+                for (std::size_t q = c + 1; q < nb; ++q) {
+                    w[q] *= tau;
+                    top[q] -= w[q];
+                }  // q
+
+                // Columns c + 1.. -= v * w
+                for (std::size_t r = c + 1; r < m; ++r) {
+                    T* row = a + r * lda;
+                    const T vr = row[c];
+                    for (std::size_t q = c + 1; q < nb; ++q)
+                        row[q] -= vr * w[q];
+                    if (c + 1 < nb && r > c + 1)
+                        next += row[c + 1] * row[c + 1];
+                }  // r
+            } else if (c + 1 < nb) {
+                for (std::size_t r = c + 2; r < m; ++r)
+                    next += a[r * lda + c + 1] * a[r * lda + c + 1];
+            }
+            t[c * ldt + c] = tau;
+            norm2 = next;
+        }  // c
+
+        reflectorFactor(m, nb, a, lda, t, ldt);
+    }
+
+    /**
+     * Runs qrColumns() on a contiguous copy of the panel. Rows of A can be far apart, so the passes over them would
+     * otherwise miss the TLB and the prefetchers at every row.
+     */
+    template <typename T>
+    void qrLeaf(std::size_t m, std::size_t nb, T* a, std::size_t lda, T* t, std::size_t ldt) {
+        static thread_local std::vector<T> packed;
+        packed.resize(m * nb);
+        for (std::size_t r = 0; r < m; ++r)
+            std::copy(a + r * lda, a + r * lda + nb, packed.data() + r * nb);
+        qrColumns(m, nb, packed.data(), nb, t, ldt);
+        for (std::size_t r = 0; r < m; ++r)
+            std::copy(packed.data() + r * nb, packed.data() + r * nb + nb, a + r * lda);
+    }
+
+    /**
+     * Factors the m x nb panel at a, m >= nb, and forms its T factor: the left half recursively, then its
+     * reflectors applied to the right half, then the right half recursively, then the block of T coupling the
+     * halves, -T1 * V1^T * V2 * T2.
+     */
+    template <typename T, typename Blocking>
+    void qrPanel(std::size_t m, std::size_t nb, T* a, std::size_t lda, T* t, std::size_t ldt) {
+        if (nb <= QR_LEAF) {
+            qrLeaf(m, nb, a, lda, t, ldt);
+            return;
+        }
+
+        const std::size_t n1 = nb / 2, n2 = nb - n1;
+        qrPanel<T, Blocking>(m, n1, a, lda, t, ldt);
+        std::vector<T> w(n1 * n2);
+        applyBlockReflector<T, Blocking>(true, m, n1, a, lda, t, ldt, n2, a + n1, lda, w.data());
+        T* a22 = a + n1 * lda + n1;
+        T* t22 = t + n1 * ldt + n1;
+        qrPanel<T, Blocking>(m - n1, n2, a22, lda, t22, ldt);
+
+        // V1 is zero-free below row n1 where V2 starts, so V1^T * V2 = (V2^T * V1[n1:])^T
+        std::vector<T> st(n2 * n1);
+        reflectorsTransposedTimes<T, Blocking>(m - n1, n2, a22, lda, n1, a + n1 * lda, lda, st.data(), n1);
+        std::vector<T> s2(n1 * n2, T(0));
+        for (std::size_t i = 0; i < n1; ++i)
+            for (std::size_t c = 0; c < n2; ++c)
+                for (std::size_t p = 0; p <= c; ++p)
+                    s2[i * n2 + c] += st[p * n1 + i] * t22[p * ldt + c];
+        for (std::size_t i = 0; i < n1; ++i) {
+            for (std::size_t c = 0; c < n2; ++c) {
+                T s = T(0);
+                for (std::size_t q = i; q < n1; ++q)
+                    s += t[i * ldt + q] * s2[q * n2 + c];
+                t[i * ldt + n1 + c] = -s;
+            }  // c
+        }  // i
+    }
+
+    /**
+     * Computes A = Q * R in place for a row-major m x n matrix A, m >= n. On return, the upper triangle of A holds
+     * R and the reflectors lie below the diagonal, each with an implicit unit first element. Panel p, of columns
+     * [p * block, p * block + nb), leaves its nb x nb T factor in the same columns of the first nb rows of t.
+     *
+     * @param lda Row stride of A
+     * @param t block x n matrix receiving the T factors
+     * @param ldt Row stride of t
+     * @param block Reflectors per panel
+     */
+    template <typename T, typename Blocking = DefaultBlocking<T> >
+    void qr(std::size_t m, std::size_t n, T* a, std::size_t lda, T* t, std::size_t ldt,
+            std::size_t block = QR_BLOCK) {
+        static_assert(std::is_floating_point<T>::value, "QR needs a floating point element type");
+        block = std::max<std::size_t>(block, 1);
+        std::vector<T> w;
+        for (std::size_t j = 0; j < n; j += block) {
+            const std::size_t nb = std::min(block, n - j);
+            T* ajj = a + j * lda + j;
+            qrPanel<T, Blocking>(m - j, nb, ajj, lda, t + j, ldt);
+            const std::size_t rest = n - j - nb;
+            if (rest == 0)
+                continue;
+            w.resize(nb * rest);
+            applyBlockReflector<T, Blocking>(true, m - j, nb, ajj, lda, t + j, ldt, rest, ajj + nb, lda, w.data());
+        }  // j
+    }
+
+    /**
+     * Computes C = Q^T * C, or C = Q * C when transposed is not set, for the Q factored by qr() into a, t and an
+     * m x cols matrix C.
+     */
+    template <typename T, typename Blocking = DefaultBlocking<T> >
+    void qrApply(bool transposed, std::size_t m, std::size_t n, const T* a, std::size_t lda,
+                 const T* t, std::size_t ldt, std::size_t cols, T* c, std::size_t ldc,
+                 std::size_t block = QR_BLOCK) {
+        block = std::max<std::size_t>(block, 1);
+        std::vector<T> w(std::min(block, n) * cols);
+        const std::size_t panels = (n + block - 1) / block;
+        for (std::size_t q = 0; q < panels; ++q) {
+            // Q = Q_0 * Q_1 * ..., so Q^T applies the panels first to last
+            const std::size_t j = (transposed ? q : panels - 1 - q) * block;
+            const std::size_t nb = std::min(block, n - j);
+            applyBlockReflector<T, Blocking>(transposed, m - j, nb, a + j * lda + j, lda, t + j, ldt,
+                                             cols, c + j * ldc, ldc, w.data());
+        }  // q
+    }
+
+    /**
+     * Number of row blocks TSQR splits an m x n matrix into: a few per thread, each of at least 2 * n rows.
+     */
+    inline std::size_t tsqrBlocks(std::size_t m, std::size_t n) {
+        const std::size_t threads = ThreadPool::instance().size();
+        return std::max<std::size_t>(std::min(4 * threads, m / (2 * n)), 1);
+    }
+}
+
+/**
+ * QR factorization of an m x n matrix with m >= n, computed once on construction and reused by solve(), q() and
+ * r().
+ *
+ * @tparam T Floating point element type
+ * @tparam Blocking Cache blocking of the GEMM calls (see blocking.h)
+ */
+template <typename T, typename Blocking = DefaultBlocking<T> >
+class QR {
+public:
+    /**
+     * @param a An m x n matrix, m >= n.
+     * @param mode BLOCKED_QR, or TALL_SKINNY_QR to factor blocks of rows in parallel and combine their R factors
+     * @throws Matrix<T>::empty_matrix if a is empty
+     * @throws Matrix<T>::size_mismatch if a has fewer rows than columns
+     */
+    explicit QR(const Matrix<T, Blocking>& a, matmul::QrMode mode = matmul::BLOCKED_QR) : factors(a) {
+        if (a.shape(0) == 0 || a.shape(1) == 0)
+            throw typename Matrix<T, Blocking>::empty_matrix();
+        if (a.shape(0) < a.shape(1))
+            throw typename Matrix<T, Blocking>::size_mismatch();
+
+        const std::size_t m = a.shape(0), n = a.shape(1);
+        const std::size_t blocks = mode == matmul::TALL_SKINNY_QR ? matmul::tsqrBlocks(m, n) : 1;
+        for (std::size_t i = 0; i <= blocks; ++i)
+            rowStarts.push_back(m * i / blocks);
+        localT.resize(blocks * matmul::QR_BLOCK * n);
+        ThreadPool::instance().parallelFor(blocks, [this, n](std::size_t i) {
+            matmul::qr<T, Blocking>(rows(i), n, &factors(rowStarts[i], 0), n, localTFactor(i), n);
+        });
+
+        const Matrix<T, Blocking>* top = &factors;
+        if (blocks > 1) {
+            // Stack the R factors of the row blocks and factor them again
+            stacked = Matrix<T, Blocking>(std::make_pair(blocks * n, n));
+            for (std::size_t i = 0; i < blocks; ++i)
+                for (std::size_t r = 0; r < n; ++r)
+                    std::copy(&factors(rowStarts[i] + r, r), &factors(rowStarts[i] + r, 0) + n,
+                              &stacked(i * n + r, r));
+            stackedT.resize(matmul::QR_BLOCK * n);
+            matmul::qr<T, Blocking>(blocks * n, n, &stacked(0, 0), n, stackedT.data(), n);
+            top = &stacked;
+        }
+        rFactor = Matrix<T, Blocking>(std::make_pair(n, n));
+        for (std::size_t r = 0; r < n; ++r)
+            std::copy(&(*top)(r, r), &(*top)(r, 0) + n, &rFactor(r, r));
+    }
+
+    /**
+     * @return The n x n upper triangular factor R.
+     */
+    const Matrix<T, Blocking>& r() const {
+        return rFactor;
+    }
+
+    /**
+     * @return The m x n factor Q with orthonormal columns, such that A = Q * R.
+     */
+    Matrix<T, Blocking> q() const {
+        const std::size_t m = factors.shape(0), n = factors.shape(1);
+        Matrix<T, Blocking> res = Matrix<T, Blocking>(std::make_pair(m, n));
+        if (blocks() == 1) {
+            for (std::size_t i = 0; i < n; ++i)
+                res(i, i) = T(1);
+        } else {
+            Matrix<T, Blocking> y = Matrix<T, Blocking>(std::make_pair(blocks() * n, n));
+            for (std::size_t i = 0; i < n; ++i)
+                y(i, i) = T(1);
+            matmul::qrApply<T, Blocking>(false, blocks() * n, n, &stacked(0, 0), n, stackedT.data(), n,
+                                         n, &y(0, 0), n);
+            for (std::size_t i = 0; i < blocks(); ++i)
+                std::copy(&y(i * n, 0), &y(i * n, 0) + n * n, &res(rowStarts[i], 0));
+        }
+        applyLocal(false, n, res);
+        return res;
+    }
+
+    /**
+     * Least squares solution of A * X = B.
+     *
+     * @param b An m x k matrix of right-hand sides.
+     * @return The n x k matrix X minimizing the Frobenius norm of A * X - B.
+     * @throws Matrix<T>::size_mismatch if b does not have m rows
+     * @throws Matrix<T>::singular_matrix if A does not have full column rank
+     */
+    Matrix<T, Blocking> solve(const Matrix<T, Blocking>& b) const {
+        if (b.shape(0) == 0 || b.shape(1) == 0)
+            throw typename Matrix<T, Blocking>::empty_matrix();
+        if (b.shape(0) != factors.shape(0))
+            throw typename Matrix<T, Blocking>::size_mismatch();
+        const std::size_t n = factors.shape(1), cols = b.shape(1);
+        for (std::size_t i = 0; i < n; ++i)
+            if (rFactor(i, i) == T(0))
+                throw typename Matrix<T, Blocking>::singular_matrix();
+
+        // The first n rows of Q^T * B
+        Matrix<T, Blocking> c = b;
+        applyLocal(true, cols, c);
+        Matrix<T, Blocking> x = Matrix<T, Blocking>(std::make_pair(n, cols));
+        if (blocks() == 1) {
+            std::copy(&c(0, 0), &c(0, 0) + n * cols, &x(0, 0));
+        } else {
+            Matrix<T, Blocking> y = Matrix<T, Blocking>(std::make_pair(blocks() * n, cols));
+            for (std::size_t i = 0; i < blocks(); ++i)
+                std::copy(&c(rowStarts[i], 0), &c(rowStarts[i], 0) + n * cols, &y(i * n, 0));
+            matmul::qrApply<T, Blocking>(true, blocks() * n, n, &stacked(0, 0), n, stackedT.data(), n,
+                                         cols, &y(0, 0), cols);
+            std::copy(&y(0, 0), &y(0, 0) + n * cols, &x(0, 0));
+        }
+        matmul::solveUpperBlock(n, cols, &rFactor(0, 0), n, &x(0, 0), cols);
+        return x;
+    }
+
+    std::vector<T> solve(const std::vector<T>& b) const {
+        const Matrix<T, Blocking> x = solve(Matrix<T, Blocking>(std::make_pair(b.size(), 1), b));
+        return std::vector<T>(x.cbegin(), x.cend());
+    }
+
+private:
+    Matrix<T, Blocking> factors, stacked, rFactor;
+    std::vector<std::size_t> rowStarts;
+    std::vector<T> localT, stackedT;
+
+    std::size_t blocks() const {
+        return rowStarts.size() - 1;
+    }
+
+    std::size_t rows(std::size_t i) const {
+        return rowStarts[i + 1] - rowStarts[i];
+    }
+
+    T* localTFactor(std::size_t i) {
+        return localT.data() + i * matmul::QR_BLOCK * factors.shape(1);
+    }
+
+    const T* localTFactor(std::size_t i) const {
+        return localT.data() + i * matmul::QR_BLOCK * factors.shape(1);
+    }
+
+    /**
+     * Applies the Q factor of each row block, or its transpose, to the matching rows of the m x cols matrix c.
+     */
+    void applyLocal(bool transposed, std::size_t cols, Matrix<T, Blocking>& c) const {
+        const std::size_t n = factors.shape(1);
+        ThreadPool::instance().parallelFor(blocks(), [this, transposed, cols, n, &c](std::size_t i) {
+            matmul::qrApply<T, Blocking>(transposed, rows(i), n, &factors(rowStarts[i], 0), n, localTFactor(i), n,
+                                         cols, &c(rowStarts[i], 0), cols);
+        });
+    }
+};
+
+/**
+ * @return The n x k least squares solution of a * X = b for an m x n matrix a of full column rank, m >= n.
+ */
+template <typename T, typename Blocking>
+Matrix<T, Blocking> leastSquares(const Matrix<T, Blocking>& a, const Matrix<T, Blocking>& b) {
+    return QR<T, Blocking>(a).solve(b);
+}
+
+#endif //MATRIX_QR_H
@@ -0,0 +1,371 @@
+#ifndef MATRIX_QUANTIZED_H
+#define MATRIX_QUANTIZED_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+
+#include "blocking.h"
+#include "cpuFeatures.h"
+#include "kernelsAvx2.h"
+#include "kernelsAvx512.h"
+#include "gemm.h"
+#include "matrix.h"
+
+/**
+ * Quantized matrix multiplication: 8-bit operands, 32-bit accumulation. A holds int8_t or uint8_t, B holds int8_t,
+ * and every element stands for the real value scale * (q - zeroPoint), with one scale and zero point per row of A
+ * and per column of B.
+ *
+ * The engine packs and blocks like the floating point GEMM (see gemm.h), with two differences. Panels hold k in
+ * groups of four bytes, the unit consumed by one lane of vpdpbusd. A is always packed as unsigned bytes: signed A is
+ * shifted by 128 while packing, which the zero point correction undoes. The kernels compute the raw sums of products;
+ * the zero points are applied afterwards from the row sums of A and column sums of B:
+ *
+ *     sum (a - za)(b - zb) = sum ab - zb * sum a - za * sum b + k * za * zb
+ *
+ * Accumulation is exact as long as it fits in 32 bits, i.e. for k up to about 65000.
+ */
+namespace matmul {
+
+    /**
+     * Shift that maps the element type of A onto unsigned bytes.
+     */
+    template <typename TA>
+    struct QuantTraits;
+
+    template <> struct QuantTraits<uint8_t> { enum { OFFSET = 0 }; };
+    template <> struct QuantTraits<int8_t> { enum { OFFSET = 128 }; };
+
+    /**
+     * A quantized micro-kernel together with its register tile. kq is the depth of the panels in groups of four.
+     */
+    struct QuantKernel {
+        typedef void (*kernel_fn)(std::size_t kq, const uint8_t* a, const int8_t* b, int32_t* c, std::size_t ldc,
+                                  std::size_t rows, std::size_t cols, bool accumulate);
+
+        std::size_t mr, nr;
+        kernel_fn fn;
+        const char* name;
+    };
+
+    /**
+     * Portable quantized micro-kernel. Parameters as for genericKernel, with the depth given in groups of four.
+     */
+    template <int MR, int NR>
+    inline void genericQuantKernel(std::size_t kq, const uint8_t* a, const int8_t* b, int32_t* c, std::size_t ldc,
+                                   std::size_t rows, std::size_t cols, bool accumulate) {
+        int32_t acc[MR][NR];
+        for (int r = 0; r < MR; ++r)
+            for (int s = 0; s < NR; ++s)
+                acc[r][s] = 0;
+
+        for (std::size_t q = 0; q < kq; ++q) {
+            for (int r = 0; r < MR; ++r) {
+                for (int s = 0; s < NR; ++s) {
+                    int32_t dot = 0;
+                    for (int t = 0; t < 4; ++t)
+                        dot += static_cast<int32_t>(a[4 * r + t]) * static_cast<int32_t>(b[4 * s + t]);
+                    acc[r][s] += dot;
+                }  // s
+            }  // r
+            a += 4 * MR;
+            b += 4 * NR;
+        }  // q
+
+        for (std::size_t r = 0; r < rows; ++r) {
+            int32_t* row = c + r * ldc;
+            if (accumulate) {
+                for (std::size_t s = 0; s < cols; ++s)
+                    row[s] += acc[r][s];
+            } else {
+                for (std::size_t s = 0; s < cols; ++s)
+                    row[s] = acc[r][s];
+            }
+        }  // r
+    }
+
+    /**
+     * @return The quantized micro-kernels that can run on this host, fastest first. Computed once, on first use.
+     */
+    inline const std::vector<QuantKernel>& availableQuantKernels() {
+        struct Selector {
+            static std::vector<QuantKernel> available() {
+                typedef DefaultBlocking<int8_t> Blocking;
+                std::vector<QuantKernel> kernels;
+#ifdef MATRIX_X86
+                if (cpuFeatures().avx512vnni && cpuFeatures().avx512bw) {
+                    QuantKernel k = {12, 32, &avx512::qgemm12x32, "avx512vnni"};
+                    kernels.push_back(k);
+                }
+                if (cpuFeatures().avx2) {
+                    QuantKernel k = {6, 8, &avx2::qgemm6x8, "avx2"};
+                    kernels.push_back(k);
+                }
+#endif
+                QuantKernel k = {Blocking::MR, Blocking::NR, &genericQuantKernel<Blocking::MR, Blocking::NR>,
+                                 "generic"};
+                kernels.push_back(k);
+                return kernels;
+            }
+        };
+        static const std::vector<QuantKernel> kernels = Selector::available();
+        return kernels;
+    }
+
+    /**
+     * Copies an mc x kc block of row-major A into consecutive mr-row panels of unsigned bytes. Within a panel, each
+     * group of four k holds four bytes per row. Rows past mc and k past kc are zero-filled.
+     *
+     * @param buf Destination buffer of at least roundUp(mc, mr) * roundUp(kc, 4) bytes
+     */
+    template <typename TA>
+    inline void packQuantA(std::size_t mc, std::size_t kc, const TA* a, std::size_t lda, std::size_t mr,
+                           uint8_t* buf) {
+        const std::size_t kq = (kc + 3) / 4;
+        for (std::size_t i = 0; i < mc; i += mr) {
+            const std::size_t rows = std::min(mr, mc - i);
+            for (std::size_t q = 0; q < kq; ++q) {
+                const std::size_t depth = std::min<std::size_t>(4, kc - 4 * q);
+                std::fill(buf, buf + 4 * mr, uint8_t(0));
+                for (std::size_t r = 0; r < rows; ++r) {
+                    const TA* src = a + (i + r) * lda + 4 * q;
+                    for (std::size_t t = 0; t < depth; ++t)
+                        buf[4 * r + t] = static_cast<uint8_t>(src[t] + QuantTraits<TA>::OFFSET);
+                }  // r
+                buf += 4 * mr;
+            }  // q
+        }  // i
+    }
+
+    /**
+     * Copies a kc x nc block of row-major B into consecutive nr-column panels. Within a panel, each group of four k
+     * holds four bytes per column. Columns past nc and k past kc are zero-filled.
+     *
+     * @param buf Destination buffer of at least roundUp(kc, 4) * roundUp(nc, nr) bytes
+     */
+    inline void packQuantB(std::size_t kc, std::size_t nc, const int8_t* b, std::size_t ldb, std::size_t nr,
+                           int8_t* buf) {
+        const std::size_t kq = (kc + 3) / 4;
+        for (std::size_t j = 0; j < nc; j += nr) {
+            const std::size_t cols = std::min(nr, nc - j);
+            for (std::size_t q = 0; q < kq; ++q) {
+                const std::size_t depth = std::min<std::size_t>(4, kc - 4 * q);
+                std::fill(buf, buf + 4 * nr, int8_t(0));
+                for (std::size_t t = 0; t < depth; ++t) {
+                    const int8_t* src = b + (4 * q + t) * ldb + j;
+                    for (std::size_t s = 0; s < cols; ++s)
+                        buf[4 * s + t] = src[s];
+                }  // t
+                buf += 4 * nr;
+            }  // q
+        }  // j
+    }
+
+    /**
+     * Packing buffers owned by the calling thread, kept between calls.
+     */
+    struct QuantBuffers {
+        std::vector<uint8_t> a;
+        std::vector<int8_t> b;
+
+        static QuantBuffers& local() {
+            static thread_local QuantBuffers buffers;
+            return buffers;
+        }
+    };
+
+    /**
+     * Operands and blocking of one quantized multiplication.
+     */
+    template <typename TA>
+    struct QuantProblem {
+        std::size_t m, n, k;
+        const TA* a;
+        std::size_t lda;
+        const int8_t* b;
+        std::size_t ldb;
+        int32_t* c;
+        std::size_t ldc;
+        const QuantKernel* kernel;
+        std::size_t mcBlock, kcBlock, ncBlock;
+    };
+
+    /**
+     * Computes the raw sums of products for rows [i0, i0 + mSub) and columns [j0, j0 + nSub) of C.
+     */
+    template <typename TA>
+    void quantizedBlock(const QuantProblem<TA>& p, std::size_t i0, std::size_t mSub, std::size_t j0,
+                        std::size_t nSub) {
+        const QuantKernel& kernel = *p.kernel;
+        const std::size_t kcMax = std::min(p.kcBlock, (p.k + 3) / 4 * 4);
+        const std::size_t mcMax = std::min(p.mcBlock, mSub);
+        const std::size_t ncMax = std::min(p.ncBlock, nSub);
+        QuantBuffers& buffers = QuantBuffers::local();
+        uint8_t* packedA = alignedBuffer(buffers.a, kcMax * ((mcMax + kernel.mr - 1) / kernel.mr) * kernel.mr);
+        int8_t* packedB = alignedBuffer(buffers.b, kcMax * ((ncMax + kernel.nr - 1) / kernel.nr) * kernel.nr);
+
+        for (std::size_t jc = j0; jc < j0 + nSub; jc += p.ncBlock) {
+            const std::size_t nc = std::min(p.ncBlock, j0 + nSub - jc);
+            for (std::size_t pc = 0; pc < p.k; pc += p.kcBlock) {
+                const std::size_t kc = std::min(p.kcBlock, p.k - pc);
+                const std::size_t kq = (kc + 3) / 4;
+                packQuantB(kc, nc, p.b + pc * p.ldb + jc, p.ldb, kernel.nr, packedB);
+                for (std::size_t ic = i0; ic < i0 + mSub; ic += p.mcBlock) {
+                    const std::size_t mc = std::min(p.mcBlock, i0 + mSub - ic);
+                    packQuantA(mc, kc, p.a + ic * p.lda + pc, p.lda, kernel.mr, packedA);
+                    for (std::size_t j = 0; j < nc; j += kernel.nr) {
+                        const std::size_t cols = std::min(kernel.nr, nc - j);
+                        for (std::size_t i = 0; i < mc; i += kernel.mr) {
+                            const std::size_t rows = std::min(kernel.mr, mc - i);
+                            kernel.fn(kq, packedA + i * 4 * kq, packedB + j * 4 * kq,
+                                      p.c + (ic + i) * p.ldc + jc + j, p.ldc, rows, cols, pc != 0);
+                        }  // i
+                    }  // j
+                }  // ic
+            }  // pc
+        }  // jc
+    }
+
+    /**
+     * Computes C = (A - zA) * (B - zB) in 32-bit integers for a row-major m x k matrix A of int8_t or uint8_t and a
+     * row-major k x n matrix B of int8_t, storing the result in the row-major m x n matrix C.
+     *
+     * @param lda Row stride of A
+     * @param ldb Row stride of B
+     * @param ldc Row stride of C
+     * @param zeroA Zero point of each of the m rows of A, or NULL for zero
+     * @param zeroB Zero point of each of the n columns of B, or NULL for zero
+     * @param kernel Micro-kernel to use
+     */
+    template <typename TA>
+    void quantizedMultiply(std::size_t m, std::size_t n, std::size_t k,
+                           const TA* a, std::size_t lda, const int8_t* b, std::size_t ldb,
+                           int32_t* c, std::size_t ldc, const int32_t* zeroA, const int32_t* zeroB,
+                           const QuantKernel& kernel) {
+        typedef DefaultBlocking<int8_t> Blocking;
+        QuantProblem<TA> p;
+        p.m = m; p.n = n; p.k = k;
+        p.a = a; p.lda = lda;
+        p.b = b; p.ldb = ldb;
+        p.c = c; p.ldc = ldc;
+        p.kernel = &kernel;
+        p.mcBlock = std::max<std::size_t>(Blocking::MC / kernel.mr, 1) * kernel.mr;
+        p.kcBlock = std::max<std::size_t>(Blocking::KC / 4, 1) * 4;
+        p.ncBlock = std::max<std::size_t>(Blocking::NC / kernel.nr, 1) * kernel.nr;
+
+        if (k == 0) {
+            for (std::size_t i = 0; i < m; ++i)
+                std::fill(c + i * ldc, c + i * ldc + n, 0);
+            return;
+        }
+        forEachTile(m, n, k, p.mcBlock, p.ncBlock, kernel.nr,
+                    [&p](std::size_t i0, std::size_t mSub, std::size_t j0, std::size_t nSub) {
+                        quantizedBlock(p, i0, mSub, j0, nSub);
+                    });
+
+        const int32_t offset = QuantTraits<TA>::OFFSET;
+        if (offset == 0 && zeroA == NULL && zeroB == NULL)
+            return;
+
+        // Zero point correction, with A's zero points moved into the unsigned domain it was packed in
+        std::vector<int32_t> rowSumA(m, 0), colSumB(n, 0);
+        for (std::size_t i = 0; i < m; ++i)
+            for (std::size_t t = 0; t < k; ++t)
+                rowSumA[i] += static_cast<int32_t>(a[i * lda + t]) + offset;
+        for (std::size_t t = 0; t < k; ++t)
+            for (std::size_t j = 0; j < n; ++j)
+                colSumB[j] += b[t * ldb + j];
+        const int32_t depth = static_cast<int32_t>(k);
+        for (std::size_t i = 0; i < m; ++i) {
+            const int32_t za = (zeroA != NULL ? zeroA[i] : 0) + offset;
+            int32_t* row = c + i * ldc;
+            for (std::size_t j = 0; j < n; ++j) {
+                const int32_t zb = zeroB != NULL ? zeroB[j] : 0;
+                row[j] += depth * za * zb - za * colSumB[j] - zb * rowSumA[i];
+            }  // j
+        }  // i
+    }
+
+    /**
+     * Same as above with the fastest kernel the host supports.
+     */
+    template <typename TA>
+    void quantizedMultiply(std::size_t m, std::size_t n, std::size_t k,
+                           const TA* a, std::size_t lda, const int8_t* b, std::size_t ldb,
+                           int32_t* c, std::size_t ldc, const int32_t* zeroA, const int32_t* zeroB) {
+        quantizedMultiply(m, n, k, a, lda, b, ldb, c, ldc, zeroA, zeroB, availableQuantKernels().front());
+    }
+
+    /**
+     * @return values expanded to n entries: empty means all zero, a single value applies to every entry.
+     * @throws Matrix<int32_t>::size_mismatch for any other length than 0, 1 or n
+     */
+    template <typename V>
+    inline std::vector<V> broadcastParams(const std::vector<V>& values, std::size_t n, V fill) {
+        if (values.empty())
+            return std::vector<V>(n, fill);
+        if (values.size() == 1)
+            return std::vector<V>(n, values[0]);
+        if (values.size() != n)
+            throw Matrix<int32_t>::size_mismatch();
+        return values;
+    }
+}
+
+/**
+ * Affine quantization parameters: element q stands for scale * (q - zeroPoint). Holds either one value per row (of
+ * A) or column (of B), or a single value for the whole matrix. An empty zeroPoint means zero.
+ */
+struct QuantParams {
+    std::vector<float> scale;
+    std::vector<int32_t> zeroPoint;
+};
+
+/**
+ * Multiplies 8-bit matrices with 32-bit accumulation: C(i, j) = sum over t of (A(i, t) - zeroA[i]) * (B(t, j) -
+ * zeroB[j]). Each zero point vector may be empty (all zero), hold a single value, or one value per row of A or
+ * column of B.
+ *
+ * @return An int32 Matrix instance of shape (rows of a) x (columns of b).
+ */
+template <typename TA>
+Matrix<int32_t> quantizedMultiply(const Matrix<TA>& a, const Matrix<int8_t>& b,
+                                  const std::vector<int32_t>& zeroA = std::vector<int32_t>(),
+                                  const std::vector<int32_t>& zeroB = std::vector<int32_t>()) {
+    const mat_size_t m = a.shape(0), k = a.shape(1), n = b.shape(1);
+    if (m == 0 || k == 0 || b.shape(0) == 0 || n == 0)
+        throw Matrix<int32_t>::empty_matrix();
+    if (k != b.shape(0))
+        throw Matrix<int32_t>::size_mismatch();
+
+    const std::vector<int32_t> za = matmul::broadcastParams(zeroA, m, 0);
+    const std::vector<int32_t> zb = matmul::broadcastParams(zeroB, n, 0);
+    Matrix<int32_t> res = Matrix<int32_t>(std::make_pair(m, n));
+    matmul::quantizedMultiply<TA>(m, n, k, &a(0, 0), k, &b(0, 0), n, &res(0, 0), n, za.data(), zb.data());
+    return res;
+}
+
+/**
+ * Multiplies 8-bit matrices and dequantizes the result: C(i, j) = scaleA[i] * scaleB[j] * sum over t of (A(i, t) -
+ * zeroA[i]) * (B(t, j) - zeroB[j]), with per-row parameters for A and per-column parameters for B.
+ *
+ * @return A float Matrix instance of shape (rows of a) x (columns of b).
+ */
+template <typename TA>
+Matrix<float> quantizedMultiply(const Matrix<TA>& a, const QuantParams& qa,
+                                const Matrix<int8_t>& b, const QuantParams& qb) {
+    const Matrix<int32_t> acc = quantizedMultiply(a, b, qa.zeroPoint, qb.zeroPoint);
+    const mat_size_t m = acc.shape(0), n = acc.shape(1);
+    const std::vector<float> sa = matmul::broadcastParams(qa.scale, m, 1.0f);
+    const std::vector<float> sb = matmul::broadcastParams(qb.scale, n, 1.0f);
+
+    Matrix<float> res = Matrix<float>(std::make_pair(m, n));
+    for (mat_size_t i = 0; i < m; ++i)
+        for (mat_size_t j = 0; j < n; ++j)
+            res(i, j) = sa[i] * sb[j] * static_cast<float>(acc(i, j));
+    return res;
+}
+
+#endif //MATRIX_QUANTIZED_H
@@ -0,0 +1,133 @@
+#ifndef MATRIX_RANDOMIZED_SVD_H
+#define MATRIX_RANDOMIZED_SVD_H
+
+#include <random>
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+#include <type_traits>
+
+#include "blocking.h"
+#include "gemm.h"
+#include "qr.h"
+#include "eigen.h"
+#include "matrix.h"
+
+/**
+ * Randomized truncated SVD (Halko, Martinsson and Tropp). A Gaussian test matrix of k + oversampling columns is
+ * multiplied by A. The result spans, with high probability, nearly all of A's leading left singular subspace. Power
+ * iterations, products with A^T and then A again, sharpen the span when the singular values decay slowly. The basis
+ * Q found this way is orthonormalized with TSQR after every product. A then only needs to be projected onto it:
+ * B = Q^T * A is small, and its exact SVD gives that of A. Every pass over A is a GEMM with a thin operand.
+ */
+namespace matmul {
+
+    /**
+     * Extra columns of the test matrix beyond the rank asked for.
+     */
+    const std::size_t RANDOMIZED_OVERSAMPLING = 10;
+
+    /**
+     * Products with A^T * A applied to the test matrix.
+     */
+    const int RANDOMIZED_POWER_ITERATIONS = 2;
+
+    /**
+     * @return An m x n matrix whose columns are an orthonormal basis of the span of y's columns, m >= n.
+     */
+    template <typename T, typename Blocking>
+    Matrix<T, Blocking> orthonormalBasis(const Matrix<T, Blocking>& y) {
+        return QR<T, Blocking>(y, TALL_SKINNY_QR).q();
+    }
+}
+
+/**
+ * Approximate SVD A ~ U * diag(sigma) * V^T of rank k, computed from a random sketch of A.
+ *
+ * @tparam T Floating point element type
+ * @tparam Blocking Cache blocking of the GEMM calls (see blocking.h)
+ */
+template <typename T, typename Blocking = DefaultBlocking<T> >
+class RandomizedSVD {
+public:
+    /**
+     * @param a An m x n matrix.
+     * @param k Rank of the approximation
+     * @param oversampling Extra sketch columns; the sketch has min(k + oversampling, m, n) columns
+     * @param powerIterations Products with A^T * A; more are slower but sharper on slowly decaying spectra
+     * @param seed Seed of the Gaussian test matrix
+     * @throws Matrix<T>::empty_matrix if a is empty
+     * @throws Matrix<T>::size_mismatch if k is 0 or exceeds min(m, n)
+     */
+    RandomizedSVD(const Matrix<T, Blocking>& a, mat_size_t k,
+                  std::size_t oversampling = matmul::RANDOMIZED_OVERSAMPLING,
+                  int powerIterations = matmul::RANDOMIZED_POWER_ITERATIONS, unsigned int seed = 0) {
+        static_assert(std::is_floating_point<T>::value, "Randomized SVD needs a floating point element type");
+        const mat_size_t m = a.shape(0), n = a.shape(1);
+        if (m == 0 || n == 0)
+            throw typename Matrix<T, Blocking>::empty_matrix();
+        if (k == 0 || k > std::min(m, n))
+            throw typename Matrix<T, Blocking>::size_mismatch();
+        const mat_size_t l = std::min<mat_size_t>(k + oversampling, std::min(m, n));
+
+        Matrix<T, Blocking> omega = Matrix<T, Blocking>(std::make_pair(n, l));
+        std::default_random_engine generator(seed);
+        std::normal_distribution<T> gaussian;
+        for (mat_size_t i = 0; i < n; ++i)
+            for (mat_size_t j = 0; j < l; ++j)
+                omega(i, j) = gaussian(generator);
+
+        // Q = orth(A * (A^T * A)^q * Omega), orthonormalized after every product
+        Matrix<T, Blocking> y = Matrix<T, Blocking>(std::make_pair(m, l));
+        Matrix<T, Blocking> z = Matrix<T, Blocking>(std::make_pair(n, l));
+        matmul::gemm<T, Blocking>(matmul::NO_TRANSPOSE, matmul::NO_TRANSPOSE, m, l, n, T(1), &a(0, 0), n,
+                                  &omega(0, 0), l, T(0), &y(0, 0), l);
+        Matrix<T, Blocking> q = matmul::orthonormalBasis(y);
+        for (int iter = 0; iter < powerIterations; ++iter) {
+            matmul::gemm<T, Blocking>(matmul::TRANSPOSE, matmul::NO_TRANSPOSE, n, l, m, T(1), &a(0, 0), n,
+                                      &q(0, 0), l, T(0), &z(0, 0), l);
+            z = matmul::orthonormalBasis(z);
+            matmul::gemm<T, Blocking>(matmul::NO_TRANSPOSE, matmul::NO_TRANSPOSE, m, l, n, T(1), &a(0, 0), n,
+                                      &z(0, 0), l, T(0), &y(0, 0), l);
+            q = matmul::orthonormalBasis(y);
+        }  // iter
+
+        // B = Q^T * A is l x n; A ~ Q * B = (Q * U_B) * diag(sigma) * V^T
+        Matrix<T, Blocking> b = Matrix<T, Blocking>(std::make_pair(l, n));
+        matmul::gemm<T, Blocking>(matmul::TRANSPOSE, matmul::NO_TRANSPOSE, l, n, m, T(1), &q(0, 0), l,
+                                  &a(0, 0), n, T(0), &b(0, 0), n);
+        const SVD<T, Blocking> small(b, k);
+        values = small.singularValues();
+        right = small.v();
+        left = Matrix<T, Blocking>(std::make_pair(m, k));
+        matmul::gemm<T, Blocking>(matmul::NO_TRANSPOSE, matmul::NO_TRANSPOSE, m, k, l, T(1), &q(0, 0), l,
+                                  &small.u()(0, 0), k, T(0), &left(0, 0), k);
+    }
+
+    /**
+     * @return The k largest singular values, approximately, in descending order.
+     */
+    const std::vector<T>& singularValues() const {
+        return values;
+    }
+
+    /**
+     * @return The m x k matrix of left singular vectors.
+     */
+    const Matrix<T, Blocking>& u() const {
+        return left;
+    }
+
+    /**
+     * @return The n x k matrix of right singular vectors.
+     */
+    const Matrix<T, Blocking>& v() const {
+        return right;
+    }
+
+private:
+    std::vector<T> values;
+    Matrix<T, Blocking> left, right;
+};
+
+#endif //MATRIX_RANDOMIZED_SVD_H
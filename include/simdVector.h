@@ -0,0 +1,27 @@
+#ifndef MATRIX_SIMDVECTOR_H
+#define MATRIX_SIMDVECTOR_H
+
+/**
+ * Portable SIMD vectors through the GCC/Clang vector extensions. Code written against SimdVector is compiled for
+ * whatever instruction set the enclosing function targets, so one template can be instantiated once per ISA (see
+ * the wrappers in batched.h and gemv.h). MATRIX_VECTOR_EXTENSIONS is left undefined on other compilers, whose code
+ * paths fall back to scalar loops.
+ */
+#if defined(__GNUC__)
+#define MATRIX_VECTOR_EXTENSIONS
+#endif
+
+namespace matmul {
+
+#ifdef MATRIX_VECTOR_EXTENSIONS
+    /**
+     * A vector of W elements of T.
+     */
+    template <typename T, int W>
+    struct SimdVector {
+        typedef T type __attribute__((vector_size(W * sizeof(T))));
+    };
+#endif
+}
+
+#endif //MATRIX_SIMDVECTOR_H
@@ -0,0 +1,307 @@
+#ifndef MATRIX_SPARSE_H
+#define MATRIX_SPARSE_H
+
+#include <vector>
+#include <utility>
+#include <cstddef>
+#include <exception>
+#include <algorithm>
+
+#include "blocking.h"
+#include "gemm.h"
+#include "threadPool.h"
+#include "matrix.h"
+
+/**
+ * Sparse matrices in compressed sparse row (CSR) form, and their products with dense matrices and vectors. A CSR
+ * matrix keeps, for each row, the column indices and values of its nonzeros in one contiguous run, so its products
+ * stream through the nonzeros exactly once. Rows are independent, and are split across the thread pool into ranges
+ * of roughly equal cost. The cost of a range is its nonzeros plus its rows, rather than its rows alone, so a few
+ * dense rows do not leave one thread with most of the work.
+ */
+namespace matmul {
+
+    /**
+     * Splits the rows of a CSR matrix into parts ranges of about equal cost, one unit per nonzero and one per row.
+     *
+     * @param rowStarts The m + 1 row offsets into the nonzeros
+     * @return The parts + 1 boundaries of the ranges, from 0 to m.
+     */
+    inline std::vector<std::size_t> balancedRows(std::size_t m, const std::size_t* rowStarts, std::size_t parts) {
+        // rowStarts[r] + r is increasing in r, so each boundary is a binary search
+        const std::size_t total = rowStarts[m] + m;
+        std::vector<std::size_t> bounds(parts + 1, m);
+        bounds[0] = 0;
+        for (std::size_t t = 1; t < parts; ++t) {
+            const std::size_t target = total * t / parts;
+            std::size_t lo = bounds[t - 1], hi = m;
+            while (lo < hi) {
+                const std::size_t mid = lo + (hi - lo) / 2;
+                if (rowStarts[mid] + mid < target)
+                    lo = mid + 1;
+                else
+                    hi = mid;
+            }
+            bounds[t] = lo;
+        }  // t
+        return bounds;
+    }
+
+    /**
+     * Calls range(r0, r1) over the rows of a CSR matrix, in load-balanced ranges on the thread pool once the
+     * multiply-adds, nonzeros times cols, reach PARALLEL_MIN_FLOPS.
+     */
+    template <typename Fn>
+    void forEachRowRange(std::size_t m, const std::size_t* rowStarts, std::size_t cols, const Fn& range) {
+        const std::size_t threads = ThreadPool::instance().size();
+        if (threads == 1 || m < 2 || (rowStarts[m] + m) * cols < PARALLEL_MIN_FLOPS) {
+            range(0, m);
+            return;
+        }
+        const std::size_t parts = std::min(4 * threads, m);
+        const std::vector<std::size_t> bounds = balancedRows(m, rowStarts, parts);
+        ThreadPool::instance().parallelFor(parts, [&](std::size_t t) {
+            if (bounds[t] < bounds[t + 1])
+                range(bounds[t], bounds[t + 1]);
+        });
+    }
+
+    /**
+     * Computes y = A * x for an m-row CSR matrix A.
+     */
+    template <typename T>
+    void spmv(std::size_t m, const std::size_t* rowStarts, const mat_size_t* columns, const T* values,
+              const T* x, T* y) {
+        forEachRowRange(m, rowStarts, 1, [=](std::size_t r0, std::size_t r1) {
+            for (std::size_t i = r0; i < r1; ++i) {
+                T sum = T(0);
+                for (std::size_t p = rowStarts[i]; p < rowStarts[i + 1]; ++p)
+                    sum += values[p] * x[columns[p]];
+                y[i] = sum;
+            }  // i
+        });
+    }
+
+    /**
+     * Computes C = A * B for an m-row CSR matrix A and a row-major dense B of n columns. Each row of C is a sum of
+     * rows of B scaled by the nonzeros of the matching row of A, built up while it stays in L1.
+     *
+     * @param ldb Row stride of B
+     * @param ldc Row stride of C
+     */
+    template <typename T>
+    void spmm(std::size_t m, std::size_t n, const std::size_t* rowStarts, const mat_size_t* columns, const T* values,
+              const T* b, std::size_t ldb, T* c, std::size_t ldc) {
+        forEachRowRange(m, rowStarts, n, [=](std::size_t r0, std::size_t r1) {
+            for (std::size_t i = r0; i < r1; ++i) {
+                T* row = c + i * ldc;
+                std::fill(row, row + n, T(0));
+                for (std::size_t p = rowStarts[i]; p < rowStarts[i + 1]; ++p) {
+                    const T v = values[p];
+                    const T* src = b + columns[p] * ldb;
+                    for (std::size_t j = 0; j < n; ++j)
+                        row[j] += v * src[j];
+                }  // p
+            }  // i
+        });
+    }
+
+    /**
+     * Computes C = A * B for a row-major dense m x k matrix A and a k-row CSR matrix B of n columns. Row i of C
+     * gathers the rows of B scaled by row i of A, so the rows of A split evenly across the thread pool.
+     */
+    template <typename T>
+    void denseTimesSparse(std::size_t m, std::size_t k, std::size_t n, const T* a, std::size_t lda,
+                          const std::size_t* rowStarts, const mat_size_t* columns, const T* values,
+                          T* c, std::size_t ldc) {
+        auto rows = [=](std::size_t i0, std::size_t i1) {
+            for (std::size_t i = i0; i < i1; ++i) {
+                T* row = c + i * ldc;
+                std::fill(row, row + n, T(0));
+                const T* ai = a + i * lda;
+                for (std::size_t q = 0; q < k; ++q) {
+                    const T v = ai[q];
+                    for (std::size_t p = rowStarts[q]; p < rowStarts[q + 1]; ++p)
+                        row[columns[p]] += v * values[p];
+                }  // q
+            }  // i
+        };
+        const std::size_t threads = ThreadPool::instance().size();
+        if (threads == 1 || m < 2 || m * (rowStarts[k] + k) < PARALLEL_MIN_FLOPS) {
+            rows(0, m);
+            return;
+        }
+        const std::size_t parts = std::min(4 * threads, m);
+        ThreadPool::instance().parallelFor(parts, [&](std::size_t t) {
+            rows(m * t / parts, m * (t + 1) / parts);
+        });
+    }
+}
+
+/**
+ * Sparse matrix in compressed sparse row form: the nonzeros of row i are values()[p] in columns columns()[p], for
+ * p from rowStarts()[i] to rowStarts()[i + 1].
+ *
+ * @tparam T Element type
+ * @tparam Blocking Blocking policy of the dense matrices it converts to and multiplies with (see blocking.h)
+ */
+template <typename T, typename Blocking = DefaultBlocking<T> >
+class SparseMatrix {
+public:
+    /**
+     * Instantiates an empty matrix of size (0 x 0)
+     */
+    SparseMatrix() : n_rows(0), n_cols(0), starts(1, 0) {}
+
+    /**
+     * @param shape Number of rows and columns
+     * @param rowStarts The n_rows + 1 offsets of the rows into columns and values, from 0 to the number of nonzeros
+     * @param columns Column index of each nonzero
+     * @param values Value of each nonzero
+     * @throws bad_structure if the arrays do not describe a shape(0) x shape(1) CSR matrix
+     */
+    SparseMatrix(shape_t shape, std::vector<std::size_t> rowStarts, std::vector<mat_size_t> columns,
+                 std::vector<T> values) :
+            n_rows(std::get<0>(shape)),
+            n_cols(std::get<1>(shape)),
+            starts(std::move(rowStarts)),
+            cols(std::move(columns)),
+            vals(std::move(values)) {
+        if (starts.size() != static_cast<std::size_t>(n_rows) + 1 || starts[0] != 0 ||
+                starts[n_rows] != cols.size() || cols.size() != vals.size())
+            throw bad_structure();
+        for (mat_size_t i = 0; i < n_rows; ++i)
+            if (starts[i] > starts[i + 1])
+                throw bad_structure();
+        for (mat_size_t c : cols)
+            if (c >= n_cols)
+                throw bad_structure();
+    }
+
+    /**
+     * Keeps the nonzero elements of a dense matrix.
+     */
+    explicit SparseMatrix(const Matrix<T, Blocking>& dense) :
+            n_rows(dense.shape(0)),
+            n_cols(dense.shape(1)),
+            starts(1, 0) {
+        starts.reserve(static_cast<std::size_t>(n_rows) + 1);
+        for (mat_size_t i = 0; i < n_rows; ++i) {
+            for (mat_size_t j = 0; j < n_cols; ++j) {
+                if (dense(i, j) != T(0)) {
+                    cols.push_back(j);
+                    vals.push_back(dense(i, j));
+                }
+            }  // j
+            starts.push_back(cols.size());
+        }  // i
+    }
+
+    /**
+     * @return A new dense Matrix instance with the same elements.
+     */
+    Matrix<T, Blocking> toDense() const {
+        Matrix<T, Blocking> res = Matrix<T, Blocking>(std::make_pair(n_rows, n_cols));
+        for (mat_size_t i = 0; i < n_rows; ++i)
+            for (std::size_t p = starts[i]; p < starts[i + 1]; ++p)
+                res(i, cols[p]) = vals[p];
+        return res;
+    }
+
+    /**
+     * @param n 0 for number of rows, 1 for number of columns
+     * @return The requested dimension
+     */
+    mat_size_t shape(mat_size_t n) const {
+        return (n == 0) ? n_rows :
+               (n == 1) ? n_cols :
+               throw typename Matrix<T, Blocking>::bad_shape();
+    }
+
+    std::size_t nonZeros() const {
+        return vals.size();
+    }
+
+    const std::vector<std::size_t>& rowStarts() const {
+        return starts;
+    }
+
+    const std::vector<mat_size_t>& columns() const {
+        return cols;
+    }
+
+    const std::vector<T>& values() const {
+        return vals;
+    }
+
+    /**
+     * Thrown when the CSR arrays are inconsistent with each other or with the shape
+     */
+    struct bad_structure : public std::exception {
+        const char* what() const throw() final {
+            return "Invalid compressed sparse row structure";
+        }
+    };
+
+private:
+    mat_size_t n_rows, n_cols;
+    std::vector<std::size_t> starts;
+    std::vector<mat_size_t> cols;
+    std::vector<T> vals;
+};
+
+/**
+ * Sparse matrix-vector multiplication.
+ *
+ * @param x A vector of a.shape(1) elements.
+ * @return The a.shape(0) elements of a * x.
+ */
+template <typename T, typename Blocking>
+std::vector<T> operator*(const SparseMatrix<T, Blocking>& a, const std::vector<T>& x) {
+    if (a.shape(0) == 0 || a.shape(1) == 0 || x.empty())
+        throw typename Matrix<T, Blocking>::empty_matrix();
+    if (x.size() != a.shape(1))
+        throw typename Matrix<T, Blocking>::size_mismatch();
+
+    std::vector<T> y(a.shape(0));
+    matmul::spmv(a.shape(0), a.rowStarts().data(), a.columns().data(), a.values().data(), x.data(), y.data());
+    return y;
+}
+
+/**
+ * Sparse times dense multiplication.
+ *
+ * @return A new dense Matrix instance.
+ */
+template <typename T, typename Blocking>
+Matrix<T, Blocking> operator*(const SparseMatrix<T, Blocking>& a, const Matrix<T, Blocking>& b) {
+    if (a.shape(0) == 0 || a.shape(1) == 0 || b.shape(0) == 0 || b.shape(1) == 0)
+        throw typename Matrix<T, Blocking>::empty_matrix();
+    if (a.shape(1) != b.shape(0))
+        throw typename Matrix<T, Blocking>::size_mismatch();
+
+    Matrix<T, Blocking> res = Matrix<T, Blocking>(std::make_pair(a.shape(0), b.shape(1)));
+    matmul::spmm(a.shape(0), b.shape(1), a.rowStarts().data(), a.columns().data(), a.values().data(),
+                 &b(0, 0), b.shape(1), &res(0, 0), b.shape(1));
+    return res;
+}
+
+/**
+ * Dense times sparse multiplication.
+ *
+ * @return A new dense Matrix instance.
+ */
+template <typename T, typename Blocking>
+Matrix<T, Blocking> operator*(const Matrix<T, Blocking>& a, const SparseMatrix<T, Blocking>& b) {
+    if (a.shape(0) == 0 || a.shape(1) == 0 || b.shape(0) == 0 || b.shape(1) == 0)
+        throw typename Matrix<T, Blocking>::empty_matrix();
+    if (a.shape(1) != b.shape(0))
+        throw typename Matrix<T, Blocking>::size_mismatch();
+
+    Matrix<T, Blocking> res = Matrix<T, Blocking>(std::make_pair(a.shape(0), b.shape(1)));
+    matmul::denseTimesSparse(a.shape(0), a.shape(1), b.shape(1), &a(0, 0), a.shape(1), b.rowStarts().data(),
+                             b.columns().data(), b.values().data(), &res(0, 0), b.shape(1));
+    return res;
+}
+
+#endif //MATRIX_SPARSE_H
@@ -0,0 +1,259 @@
+#ifndef MATRIX_STRASSEN_H
+#define MATRIX_STRASSEN_H
+
+#include <vector>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <algorithm>
+#include <type_traits>
+
+#include "blocking.h"
+#include "gemm.h"
+#include "threadPool.h"
+
+/**
+ * Strassen-Winograd multiplication for large products: each level of the recursion replaces the eight half-size
+ * products of the blocked algorithm by seven, at the cost of fifteen block additions. Once the blocks fall below the
+ * cutoff the recursion stops and the leaves go through the ordinary packed GEMM (see gemm.h).
+ *
+ * The fast path changes the order of the floating point operations, so results differ from the blocked product in
+ * the last bits, and it is only used for floating point types (integer results would stay exact, but the sums of
+ * operand blocks can overflow where the classical product does not). Disable it with setStrassenEnabled(false)
+ * when results must be reproducible against the classical algorithm.
+ *
+ * The cutoff defaults to the value of the MATRIX_STRASSEN_CUTOFF environment variable (0 disables the fast path),
+ * or to STRASSEN_DEFAULT_CUTOFF when it is unset, and can be changed with setStrassenCutoff().
+ */
+namespace matmul {
+
+    /**
+     * Smallest dimension at which a product is split, when not overridden.
+     */
+    const std::size_t STRASSEN_DEFAULT_CUTOFF = 4096;
+
+    /**
+     * Process-wide switches of the fast path.
+     */
+    struct StrassenSettings {
+        std::atomic<bool> enabled;
+        std::atomic<std::size_t> cutoff;
+
+        static StrassenSettings& instance() {
+            static StrassenSettings settings;
+            return settings;
+        }
+
+    private:
+        StrassenSettings() : enabled(true), cutoff(STRASSEN_DEFAULT_CUTOFF) {
+            const char* env = std::getenv("MATRIX_STRASSEN_CUTOFF");
+            if (env != NULL) {
+                long n = std::strtol(env, NULL, 10);
+                if (n <= 0)
+                    enabled = false;
+                else
+                    cutoff = static_cast<std::size_t>(n);
+            }
+        }
+    };
+
+    /**
+     * Number of times an m x k by k x n product is halved before the blocks fall below the cutoff.
+     */
+    inline std::size_t strassenLevels(std::size_t m, std::size_t n, std::size_t k, std::size_t cutoff) {
+        std::size_t levels = 0;
+        for (std::size_t d = std::min(std::min(m, n), k); d >= cutoff; d = (d + 1) / 2)
+            ++levels;
+        return levels;
+    }
+
+    /**
+     * @return Elements of scratch space a recursion of the given depth needs, for dimensions that are multiples of
+     * 2^levels. Every level needs one block the size of a quadrant of A or C and one the size of a quadrant of B;
+     * sibling calls at the same depth run one after another and share them.
+     */
+    inline std::size_t strassenScratch(std::size_t m, std::size_t n, std::size_t k, std::size_t levels) {
+        std::size_t total = 0;
+        for (; levels > 0; --levels) {
+            m /= 2; n /= 2; k /= 2;
+            total += std::max(m * k, m * n) + k * n;
+        }
+        return total;
+    }
+
+    /**
+     * Z = X + Y, or Z = X - Y if subtract is set, for rows x cols blocks. X and Y may be strided views, Z is row-major
+     * with row stride ldz and may alias X or Y. Rows are spread across the thread pool.
+     */
+    template <typename T, bool subtract>
+    void blockAdd(std::size_t rows, std::size_t cols,
+                  const T* x, std::ptrdiff_t rsX, std::ptrdiff_t csX,
+                  const T* y, std::ptrdiff_t rsY, std::ptrdiff_t csY,
+                  T* z, std::size_t ldz) {
+        const std::size_t band = std::max<std::size_t>(PARALLEL_MIN_FLOPS / 16 / std::max<std::size_t>(cols, 1), 1);
+        ThreadPool::instance().parallelFor((rows + band - 1) / band, [=](std::size_t t) {
+            const std::size_t iEnd = std::min(rows, (t + 1) * band);
+            for (std::size_t i = t * band; i < iEnd; ++i) {
+                const T* xRow = x + rsX * static_cast<std::ptrdiff_t>(i);
+                const T* yRow = y + rsY * static_cast<std::ptrdiff_t>(i);
+                T* zRow = z + i * ldz;
+                if (csX == 1 && csY == 1) {
+                    for (std::size_t j = 0; j < cols; ++j)
+                        zRow[j] = subtract ? xRow[j] - yRow[j] : xRow[j] + yRow[j];
+                } else {
+                    for (std::size_t j = 0; j < cols; ++j) {
+                        const T xj = xRow[csX * static_cast<std::ptrdiff_t>(j)];
+                        const T yj = yRow[csY * static_cast<std::ptrdiff_t>(j)];
+                        zRow[j] = subtract ? xj - yj : xj + yj;
+                    }  // j
+                }
+            }  // i
+        });
+    }
+
+    /**
+     * One level of Strassen-Winograd for dimensions that are multiples of 2^levels, using the schedule of Boyer,
+     * Dumas, Pernet and Zhou ("Memory efficient scheduling of Strassen-Winograd's matrix multiplication algorithm",
+     * 2009), which needs only two temporaries besides the quadrants of C.
+     *
+     * @param scratch At least strassenScratch(m, n, k, levels) elements
+     */
+    template <typename T, typename Blocking>
+    void strassenRecurse(std::size_t m, std::size_t n, std::size_t k,
+                         const T* a, std::ptrdiff_t rsA, std::ptrdiff_t csA,
+                         const T* b, std::ptrdiff_t rsB, std::ptrdiff_t csB,
+                         T* c, std::size_t ldc, std::size_t levels, T* scratch) {
+        if (levels == 0) {
+            multiply<T, Blocking>(m, n, k, a, rsA, csA, b, rsB, csB, c, ldc);
+            return;
+        }
+
+        const std::size_t m2 = m / 2, n2 = n / 2, k2 = k / 2;
+        const T* a11 = a;
+        const T* a12 = a + csA * static_cast<std::ptrdiff_t>(k2);
+        const T* a21 = a + rsA * static_cast<std::ptrdiff_t>(m2);
+        const T* a22 = a21 + csA * static_cast<std::ptrdiff_t>(k2);
+        const T* b11 = b;
+        const T* b12 = b + csB * static_cast<std::ptrdiff_t>(n2);
+        const T* b21 = b + rsB * static_cast<std::ptrdiff_t>(k2);
+        const T* b22 = b21 + csB * static_cast<std::ptrdiff_t>(n2);
+        T* c11 = c;
+        T* c12 = c + n2;
+        T* c21 = c + m2 * ldc;
+        T* c22 = c21 + n2;
+
+        // X holds the S_i (m2 x k2) and later P1 (m2 x n2), Y holds the T_i (k2 x n2)
+        T* x = scratch;
+        T* y = x + std::max(m2 * k2, m2 * n2);
+        T* deeper = y + k2 * n2;
+        const std::ptrdiff_t k2s = static_cast<std::ptrdiff_t>(k2), n2s = static_cast<std::ptrdiff_t>(n2);
+
+        blockAdd<T, true>(m2, k2, a11, rsA, csA, a21, rsA, csA, x, k2);                          // S3 = A11 - A21
+        blockAdd<T, true>(k2, n2, b22, rsB, csB, b12, rsB, csB, y, n2);                          // T3 = B22 - B12
+        strassenRecurse<T, Blocking>(m2, n2, k2, x, k2s, 1, y, n2s, 1, c21, ldc, levels - 1, deeper);  // P7 = S3 T3
+        blockAdd<T, false>(m2, k2, a21, rsA, csA, a22, rsA, csA, x, k2);                         // S1 = A21 + A22
+        blockAdd<T, true>(k2, n2, b12, rsB, csB, b11, rsB, csB, y, n2);                          // T1 = B12 - B11
+        strassenRecurse<T, Blocking>(m2, n2, k2, x, k2s, 1, y, n2s, 1, c22, ldc, levels - 1, deeper);  // P5 = S1 T1
+        blockAdd<T, true>(m2, k2, x, k2s, 1, a11, rsA, csA, x, k2);                              // S2 = S1 - A11
+        blockAdd<T, true>(k2, n2, b22, rsB, csB, y, n2s, 1, y, n2);                              // T2 = B22 - T1
+        strassenRecurse<T, Blocking>(m2, n2, k2, x, k2s, 1, y, n2s, 1, c12, ldc, levels - 1, deeper);  // P6 = S2 T2
+        blockAdd<T, true>(m2, k2, a12, rsA, csA, x, k2s, 1, x, k2);                              // S4 = A12 - S2
+        blockAdd<T, true>(k2, n2, y, n2s, 1, b21, rsB, csB, y, n2);                              // T4 = T2 - B21
+        strassenRecurse<T, Blocking>(m2, n2, k2, x, k2s, 1, b22, rsB, csB, c11, ldc, levels - 1, deeper);  // P3
+        strassenRecurse<T, Blocking>(m2, n2, k2, a11, rsA, csA, b11, rsB, csB, x, n2, levels - 1, deeper);  // P1
+
+        const std::ptrdiff_t ldcs = static_cast<std::ptrdiff_t>(ldc);
+        blockAdd<T, false>(m2, n2, x, n2s, 1, c12, ldcs, 1, c12, ldc);                           // U2 = P1 + P6
+        blockAdd<T, false>(m2, n2, c12, ldcs, 1, c21, ldcs, 1, c21, ldc);                        // U3 = U2 + P7
+        blockAdd<T, false>(m2, n2, c12, ldcs, 1, c22, ldcs, 1, c12, ldc);                        // U4 = U2 + P5
+        blockAdd<T, false>(m2, n2, c21, ldcs, 1, c22, ldcs, 1, c22, ldc);                        // U7 = U3 + P5
+        blockAdd<T, false>(m2, n2, c12, ldcs, 1, c11, ldcs, 1, c12, ldc);                        // U5 = U4 + P3
+        strassenRecurse<T, Blocking>(m2, n2, k2, a22, rsA, csA, y, n2s, 1, c11, ldc, levels - 1, deeper);  // P4
+        blockAdd<T, true>(m2, n2, c21, ldcs, 1, c11, ldcs, 1, c21, ldc);                         // U6 = U3 - P4
+        strassenRecurse<T, Blocking>(m2, n2, k2, a12, rsA, csA, b21, rsB, csB, c11, ldc, levels - 1, deeper);  // P2
+        blockAdd<T, false>(m2, n2, x, n2s, 1, c11, ldcs, 1, c11, ldc);                           // U1 = P1 + P2
+    }
+
+    /**
+     * Scratch space owned by the calling thread, kept between calls: the recursion temporaries and, for dimensions
+     * that do not halve evenly, zero-padded copies of the operands and the result.
+     */
+    template <typename T>
+    struct StrassenBuffers {
+        std::vector<T> scratch, a, b, c;
+
+        static StrassenBuffers& local() {
+            static thread_local StrassenBuffers buffers;
+            return buffers;
+        }
+    };
+
+    /**
+     * Computes C = A * B like multiply(), switching to Strassen-Winograd when T is a floating point type, the fast
+     * path is enabled and every dimension reaches the cutoff. Dimensions that do not halve evenly down to the leaves
+     * are zero-padded.
+     */
+    template <typename T, typename Blocking = DefaultBlocking<T> >
+    void strassenMultiply(std::size_t m, std::size_t n, std::size_t k,
+                          const T* a, std::ptrdiff_t rsA, std::ptrdiff_t csA,
+                          const T* b, std::ptrdiff_t rsB, std::ptrdiff_t csB,
+                          T* c, std::size_t ldc) {
+        const StrassenSettings& settings = StrassenSettings::instance();
+        const std::size_t levels = std::is_floating_point<T>::value && settings.enabled
+                                   ? strassenLevels(m, n, k, std::max<std::size_t>(settings.cutoff, 2)) : 0;
+        if (levels == 0) {
+            multiply<T, Blocking>(m, n, k, a, rsA, csA, b, rsB, csB, c, ldc);
+            return;
+        }
+
+        const std::size_t unit = std::size_t(1) << levels;
+        const std::size_t mp = (m + unit - 1) / unit * unit;
+        const std::size_t np = (n + unit - 1) / unit * unit;
+        const std::size_t kp = (k + unit - 1) / unit * unit;
+        StrassenBuffers<T>& buffers = StrassenBuffers<T>::local();
+        buffers.scratch.resize(strassenScratch(mp, np, kp, levels));
+        if (mp == m && np == n && kp == k) {
+            strassenRecurse<T, Blocking>(m, n, k, a, rsA, csA, b, rsB, csB, c, ldc, levels, buffers.scratch.data());
+            return;
+        }
+
+        buffers.a.assign(mp * kp, T(0));
+        buffers.b.assign(kp * np, T(0));
+        buffers.c.resize(mp * np);
+        for (std::size_t i = 0; i < m; ++i)
+            for (std::size_t j = 0; j < k; ++j)
+                buffers.a[i * kp + j] = a[rsA * static_cast<std::ptrdiff_t>(i) + csA * static_cast<std::ptrdiff_t>(j)];
+        for (std::size_t i = 0; i < k; ++i)
+            for (std::size_t j = 0; j < n; ++j)
+                buffers.b[i * np + j] = b[rsB * static_cast<std::ptrdiff_t>(i) + csB * static_cast<std::ptrdiff_t>(j)];
+        strassenRecurse<T, Blocking>(mp, np, kp, buffers.a.data(), static_cast<std::ptrdiff_t>(kp), 1,
+                                     buffers.b.data(), static_cast<std::ptrdiff_t>(np), 1,
+                                     buffers.c.data(), np, levels, buffers.scratch.data());
+        for (std::size_t i = 0; i < m; ++i)
+            std::copy(buffers.c.begin() + i * np, buffers.c.begin() + i * np + n, c + i * ldc);
+    }
+}
+
+/**
+ * Enables or disables the Strassen-Winograd fast path of operator*. Disable it when products must be reproducible
+ * against the classical algorithm.
+ */
+inline void setStrassenEnabled(bool enabled) {
+    matmul::StrassenSettings::instance().enabled = enabled;
+}
+
+/**
+ * Sets the smallest dimension at which operator* switches to Strassen-Winograd. Values below 2 are treated as 2.
+ */
+inline void setStrassenCutoff(std::size_t cutoff) {
+    matmul::StrassenSettings::instance().cutoff = std::max<std::size_t>(cutoff, 2);
+}
+
+/**
+ * @return The smallest dimension at which operator* switches to Strassen-Winograd.
+ */
+inline std::size_t getStrassenCutoff() {
+    return matmul::StrassenSettings::instance().cutoff;
+}
+
+#endif //MATRIX_STRASSEN_H
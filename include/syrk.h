@@ -0,0 +1,267 @@
+#ifndef MATRIX_SYRK_H
+#define MATRIX_SYRK_H
+
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+#include <type_traits>
+
+#include "blocking.h"
+#include "gemm.h"
+#include "matrix.h"
+
+/**
+ * Symmetric rank-k products C = X * X^T, i.e. the Gram matrices A * A^T and A^T * A. The result is symmetric, so
+ * only its lower triangle goes through the blocked GEMM loop nest of gemm.h: column blocks, row blocks and register
+ * tiles that lie wholly above the diagonal are skipped, which halves the flops, and the upper triangle is then
+ * mirrored from the lower one. X^T is the same memory as X read with the strides swapped, so the transpose is
+ * never formed. The symmetric rank-2k update X * Y^T + Y * X^T runs both of its products over the same lower
+ * tiles.
+ */
+namespace matmul {
+
+    /**
+     * Runs the micro-kernel over the tiles of an mc x nc block of C that reach the diagonal or below it. diag is the
+     * row of C where the block starts minus the column where it starts. Tiles that straddle the diagonal are
+     * computed whole, so a few elements just above it are written too.
+     */
+    template <typename T>
+    inline void syrkMacroKernel(const MicroKernel<T>& kernel, std::ptrdiff_t diag, std::size_t mc, std::size_t nc,
+                                std::size_t kc, const T* packedA, const T* packedB, T* c, std::size_t ldc,
+                                T alpha, T beta) {
+        for (std::size_t j = 0; j < nc; j += kernel.nr) {
+            const std::size_t cols = std::min(kernel.nr, nc - j);
+            const T* b = packedB + j * kc;
+            for (std::size_t i = 0; i < mc; i += kernel.mr) {
+                const std::size_t rows = std::min(kernel.mr, mc - i);
+                if (static_cast<std::ptrdiff_t>(j) > diag + static_cast<std::ptrdiff_t>(i + rows) - 1)
+                    continue;
+                kernel.fn(kc, packedA + i * kc, b, c + i * ldc + j, ldc, rows, cols, alpha, beta);
+            }  // i
+        }  // j
+    }
+
+    /**
+     * Computes the lower triangle of rows [i0, i0 + mSub) and columns [j0, j0 + nSub) of C, following
+     * multiplyBlock() in gemm.h.
+     */
+    template <typename T, typename S>
+    void syrkBlock(const GemmProblem<T, S>& p, std::size_t i0, std::size_t mSub, std::size_t j0, std::size_t nSub) {
+        const MicroKernel<T>& kernel = *p.kernel;
+        const std::size_t kcMax = std::min(p.kcBlock, p.k);
+        const std::size_t mcMax = std::min(p.mcBlock, mSub);
+        const std::size_t ncMax = std::min(p.ncBlock, nSub);
+        PackBuffers<T>& buffers = PackBuffers<T>::local();
+        T* packedA = alignedBuffer(buffers.a, kcMax * ((mcMax + kernel.mr - 1) / kernel.mr) * kernel.mr);
+        T* packedB = alignedBuffer(buffers.b, kcMax * ((ncMax + kernel.nr - 1) / kernel.nr) * kernel.nr);
+
+        for (std::size_t jc = j0; jc < j0 + nSub && jc < i0 + mSub; jc += p.ncBlock) {
+            // Columns past the last row of the block are above the diagonal
+            const std::size_t nc = std::min(std::min(p.ncBlock, j0 + nSub - jc), i0 + mSub - jc);
+            for (std::size_t pc = 0; pc < p.k; pc += p.kcBlock) {
+                const std::size_t kc = std::min(p.kcBlock, p.k - pc);
+                packB(kc, nc, p.b + p.rsB * static_cast<std::ptrdiff_t>(pc) + p.csB * static_cast<std::ptrdiff_t>(jc),
+                      p.rsB, p.csB, kernel.nr, packedB);
+                for (std::size_t ic = i0; ic < i0 + mSub; ic += p.mcBlock) {
+                    const std::size_t mc = std::min(p.mcBlock, i0 + mSub - ic);
+                    if (ic + mc <= jc)
+                        continue;
+                    packA(mc, kc,
+                          p.a + p.rsA * static_cast<std::ptrdiff_t>(ic) + p.csA * static_cast<std::ptrdiff_t>(pc),
+                          p.rsA, p.csA, kernel.mr, packedA);
+                    syrkMacroKernel(kernel, static_cast<std::ptrdiff_t>(ic) - static_cast<std::ptrdiff_t>(jc),
+                                    mc, nc, kc, packedA, packedB, p.c + ic * p.ldc + jc, p.ldc,
+                                    p.alpha, pc != 0 ? T(1) : p.beta);
+                }  // ic
+            }  // pc
+        }  // jc
+    }
+
+    /**
+     * Copies the strictly lower triangle of the n x n matrix C onto its upper triangle, in square tiles of block
+     * elements so the strided writes stay in cache.
+     */
+    template <typename T>
+    void mirrorLower(std::size_t n, T* c, std::size_t ldc, std::size_t block) {
+        for (std::size_t ii = 0; ii < n; ii += block) {
+            const std::size_t iEnd = std::min(n, ii + block);
+            for (std::size_t jj = 0; jj <= ii; jj += block) {
+                const std::size_t jEnd = std::min(n, jj + block);
+                for (std::size_t i = ii; i < iEnd; ++i) {
+                    for (std::size_t j = jj; j < jEnd && j < i; ++j) {
+                        c[j * ldc + i] = c[i * ldc + j];
+                    }  // j
+                }  // i
+            }  // jj
+        }  // ii
+    }
+
+    /**
+     * @return The problem alpha * X * Y^T + beta * C for n x k matrices X and Y and an n x n matrix C, blocked for
+     * kernel.
+     */
+    template <typename T, typename S>
+    GemmProblem<T, S> lowerProblem(std::size_t n, std::size_t k, const S* x, std::ptrdiff_t rsX, std::ptrdiff_t csX,
+                                   const S* y, std::ptrdiff_t rsY, std::ptrdiff_t csY, T alpha, T beta,
+                                   T* c, std::size_t ldc, const MicroKernel<T>& kernel,
+                                   const GemmBlocking& blocking) {
+        GemmProblem<T, S> p;
+        p.m = n; p.n = n; p.k = k;
+        p.a = x; p.rsA = rsX; p.csA = csX;
+        p.b = y; p.rsB = csY; p.csB = rsY;
+        p.c = c; p.ldc = ldc;
+        p.alpha = alpha; p.beta = beta;
+        p.kernel = &kernel;
+        p.mcBlock = std::max<std::size_t>(blocking.mc / kernel.mr, 1) * kernel.mr;
+        p.kcBlock = std::max<std::size_t>(blocking.kc, 1);
+        p.ncBlock = std::max<std::size_t>(blocking.nc / kernel.nr, 1) * kernel.nr;
+        return p;
+    }
+
+    /**
+     * Computes the lower triangle of C = alpha * X * X^T + beta * C for an n x k matrix X and the row-major n x n
+     * matrix C. Elements just above the diagonal, up to a register tile away, are overwritten with unspecified
+     * values.
+     *
+     * @param rsX Distance between consecutive rows of X
+     * @param csX Distance between consecutive columns of X
+     * @param ldc Row stride of C
+     * @param kernel Micro-kernel to use
+     * @param blocking Row, depth and column block sizes; the kernel name in it is ignored
+     */
+    template <typename T, typename S>
+    void syrkLower(std::size_t n, std::size_t k, const S* x, std::ptrdiff_t rsX, std::ptrdiff_t csX,
+                   T alpha, T beta, T* c, std::size_t ldc, const MicroKernel<T>& kernel,
+                   const GemmBlocking& blocking) {
+        const GemmProblem<T, S> p = lowerProblem(n, k, x, rsX, csX, x, rsX, csX, alpha, beta, c, ldc, kernel,
+                                                 blocking);
+
+        // Tiles above the diagonal return at once and the pool steals around them
+        forEachTile(n, n, k, p.mcBlock, p.ncBlock, kernel.nr,
+                    [&p](std::size_t i0, std::size_t mSub, std::size_t j0, std::size_t nSub) {
+                        syrkBlock(p, i0, mSub, j0, nSub);
+                    });
+    }
+
+    /**
+     * Computes the lower triangle of C = alpha * (X * Y^T + Y * X^T) + beta * C for n x k matrices X and Y. Each
+     * tile of C takes both products in turn, on the same thread. Elements above the diagonal are overwritten as by
+     * syrkLower().
+     *
+     * @param rsY Distance between consecutive rows of Y
+     * @param csY Distance between consecutive columns of Y
+     * @see syrkLower() for the other parameters
+     */
+    template <typename T, typename S>
+    void syr2kLower(std::size_t n, std::size_t k, const S* x, std::ptrdiff_t rsX, std::ptrdiff_t csX,
+                    const S* y, std::ptrdiff_t rsY, std::ptrdiff_t csY, T alpha, T beta, T* c, std::size_t ldc,
+                    const MicroKernel<T>& kernel, const GemmBlocking& blocking) {
+        const GemmProblem<T, S> xy = lowerProblem(n, k, x, rsX, csX, y, rsY, csY, alpha, beta, c, ldc, kernel,
+                                                  blocking);
+        const GemmProblem<T, S> yx = lowerProblem(n, k, y, rsY, csY, x, rsX, csX, alpha, T(1), c, ldc, kernel,
+                                                  blocking);
+        forEachTile(n, n, 2 * k, xy.mcBlock, xy.ncBlock, kernel.nr,
+                    [&xy, &yx](std::size_t i0, std::size_t mSub, std::size_t j0, std::size_t nSub) {
+                        syrkBlock(xy, i0, mSub, j0, nSub);
+                        syrkBlock(yx, i0, mSub, j0, nSub);
+                    });
+    }
+
+    /**
+     * Computes C = X * X^T for an n x k matrix X, storing the full symmetric result in the row-major n x n matrix C.
+     *
+     * @param mirrorBlock Tile size of the mirroring pass
+     * @see syrkLower() for the other parameters
+     */
+    template <typename T, typename S>
+    void syrk(std::size_t n, std::size_t k, const S* x, std::ptrdiff_t rsX, std::ptrdiff_t csX,
+              T* c, std::size_t ldc, const MicroKernel<T>& kernel, const GemmBlocking& blocking,
+              std::size_t mirrorBlock) {
+        syrkLower(n, k, x, rsX, csX, T(1), T(0), c, ldc, kernel, blocking);
+        mirrorLower(n, c, ldc, std::max<std::size_t>(mirrorBlock, 1));
+    }
+
+    /**
+     * Stores a product computed in the accumulator type straight into C.
+     */
+    template <typename T>
+    void syrkInto(std::size_t n, std::size_t k, const T* x, std::ptrdiff_t rsX, std::ptrdiff_t csX,
+                  T* c, std::size_t ldc, const MicroKernel<T>& kernel, const GemmBlocking& blocking,
+                  std::size_t mirrorBlock, std::true_type) {
+        syrk(n, k, x, rsX, csX, c, ldc, kernel, blocking, mirrorBlock);
+    }
+
+    /**
+     * Computes the product of a storage-only type in its accumulator type Acc and converts it into C at the end.
+     */
+    template <typename T, typename Acc>
+    void syrkInto(std::size_t n, std::size_t k, const T* x, std::ptrdiff_t rsX, std::ptrdiff_t csX,
+                  T* c, std::size_t ldc, const MicroKernel<Acc>& kernel, const GemmBlocking& blocking,
+                  std::size_t mirrorBlock, std::false_type) {
+        std::vector<Acc> acc(n * n);
+        syrk(n, k, x, rsX, csX, acc.data(), n, kernel, blocking, mirrorBlock);
+        for (std::size_t i = 0; i < n; ++i)
+            convertArray(n, acc.data() + i * n, c + i * ldc);
+    }
+
+    /**
+     * Same as above with the host's tuned kernel and cache blocking, falling back to the policy's.
+     */
+    template <typename T, typename Blocking = DefaultBlocking<T> >
+    void syrk(std::size_t n, std::size_t k, const T* x, std::ptrdiff_t rsX, std::ptrdiff_t csX,
+              T* c, std::size_t ldc) {
+        typedef typename Accumulator<T>::type Acc;
+        const GemmBlocking blocking = tunedBlocking<Acc, Blocking>(n, n, k);
+        syrkInto(n, k, x, rsX, csX, c, ldc, kernelByName<Acc, Blocking>(blocking.kernel), blocking,
+                 Blocking::XPOSE, typename std::is_same<T, Acc>::type());
+    }
+
+    /**
+     * Lower-triangle update C = alpha * X * X^T + beta * C with the host's tuned kernel and cache blocking, for
+     * element types that are their own accumulator type.
+     */
+    template <typename T, typename Blocking = DefaultBlocking<T> >
+    void syrkLower(std::size_t n, std::size_t k, T alpha, const T* x, std::ptrdiff_t rsX, std::ptrdiff_t csX,
+                   T beta, T* c, std::size_t ldc) {
+        static_assert(std::is_same<T, typename Accumulator<T>::type>::value,
+                      "syrkLower needs an element type that accumulates in itself");
+        const GemmBlocking blocking = tunedBlocking<T, Blocking>(n, n, k);
+        syrkLower(n, k, x, rsX, csX, alpha, beta, c, ldc, kernelByName<T, Blocking>(blocking.kernel), blocking);
+    }
+
+    /**
+     * Lower-triangle update C = alpha * (X * Y^T + Y * X^T) + beta * C with the host's tuned kernel and cache
+     * blocking, for element types that are their own accumulator type.
+     */
+    template <typename T, typename Blocking = DefaultBlocking<T> >
+    void syr2kLower(std::size_t n, std::size_t k, T alpha, const T* x, std::ptrdiff_t rsX, std::ptrdiff_t csX,
+                    const T* y, std::ptrdiff_t rsY, std::ptrdiff_t csY, T beta, T* c, std::size_t ldc) {
+        static_assert(std::is_same<T, typename Accumulator<T>::type>::value,
+                      "syr2kLower needs an element type that accumulates in itself");
+        const GemmBlocking blocking = tunedBlocking<T, Blocking>(n, n, 2 * k);
+        syr2kLower(n, k, x, rsX, csX, y, rsY, csY, alpha, beta, c, ldc, kernelByName<T, Blocking>(blocking.kernel),
+                   blocking);
+    }
+}
+
+/**
+ * Gram matrix of a: a * a^T, or a^T * a when trans is TRANSPOSE. Takes about half the flops of the equivalent
+ * operator* and no transposed copy.
+ *
+ * @return A new symmetric Matrix instance.
+ * @throws Matrix<T>::empty_matrix if a is empty
+ */
+template <typename T, typename Blocking>
+Matrix<T, Blocking> syrk(const Matrix<T, Blocking>& a, matmul::Transpose trans = matmul::NO_TRANSPOSE) {
+    const mat_size_t rows = a.shape(0), cols = a.shape(1);
+    if (rows == 0 || cols == 0)
+        throw typename Matrix<T, Blocking>::empty_matrix();
+
+    const bool t = trans == matmul::TRANSPOSE;
+    const mat_size_t n = t ? cols : rows, k = t ? rows : cols;
+    Matrix<T, Blocking> res = Matrix<T, Blocking>(std::make_pair(n, n));
+    matmul::syrk<T, Blocking>(n, k, &a(0, 0), t ? 1 : cols, t ? cols : 1, &res(0, 0), n);
+    return res;
+}
+
+#endif //MATRIX_SYRK_H
@@ -0,0 +1,334 @@
+#ifndef MATRIX_THREADPOOL_H
+#define MATRIX_THREADPOOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <exception>
+
+/**
+ * A persistent pool of worker threads shared by all matrix operations. Workers are started once and sleep between
+ * jobs, so a parallel multiplication only pays for a wake-up, not for thread creation. The thread that submits a job
+ * takes part in it, so a pool of size n runs n - 1 workers.
+ *
+ * Jobs are scheduled by work stealing: each thread starts with a contiguous share of the tasks in its own queue,
+ * runs them from the back, and once its queue is empty steals the front half of another thread's queue. Tasks of
+ * uneven cost (ragged edge tiles, irregular shapes) therefore even out across the pool.
+ *
+ * An exception thrown by a task stops the job: threads finish the tasks they are running and start no new ones, and
+ * once all of them are done the first exception is rethrown on the submitting thread.
+ *
+ * The pool size defaults to the value of the MATRIX_NUM_THREADS environment variable, or to the number of hardware
+ * threads when it is unset, and can be changed at any time with setNumThreads().
+ */
+class ThreadPool {
+public:
+    typedef std::function<void(std::size_t)> task_fn;
+
+    /**
+     * Scheduling counters of one thread of the pool, accumulated since the pool was (re)sized or resetStats().
+     */
+    struct WorkerStats {
+        unsigned long executed;  // Tasks run by this thread
+        unsigned long stolen;    // Tasks this thread moved out of other threads' queues
+        unsigned long steals;    // Successful steal attempts
+    };
+
+    /**
+     * @return The process-wide pool.
+     */
+    static ThreadPool& instance() {
+        static ThreadPool pool(defaultSize());
+        return pool;
+    }
+
+    /**
+     * @return The pool size requested by MATRIX_NUM_THREADS, or the number of hardware threads.
+     */
+    static std::size_t defaultSize() {
+        const char* env = std::getenv("MATRIX_NUM_THREADS");
+        if (env != NULL) {
+            long n = std::strtol(env, NULL, 10);
+            if (n > 0)
+                return static_cast<std::size_t>(n);
+        }
+        unsigned hw = std::thread::hardware_concurrency();
+        return hw > 0 ? hw : 1;
+    }
+
+    explicit ThreadPool(std::size_t n) : job(NULL), generation(0), running(0), stopping(false), failed(false) {
+        start(n);
+    }
+
+    ~ThreadPool() {
+        stop();
+    }
+
+    /**
+     * @return Number of threads that take part in a job, including the calling thread.
+     */
+    std::size_t size() const {
+        return workers.size() + 1;
+    }
+
+    /**
+     * Stops the current workers and starts n - 1 new ones. Must not be called while a job is running.
+     */
+    void resize(std::size_t n) {
+        std::lock_guard<std::mutex> submit(submitMutex);
+        stop();
+        start(n);
+    }
+
+    /**
+     * @return Scheduling counters, indexed by thread. Index 0 is the thread that submits jobs.
+     */
+    std::vector<WorkerStats> stats() const {
+        std::lock_guard<std::mutex> submit(submitMutex);
+        std::vector<WorkerStats> res(queues.size());
+        for (std::size_t i = 0; i < queues.size(); ++i) {
+            res[i].executed = queues[i]->executed;
+            res[i].stolen = queues[i]->stolen;
+            res[i].steals = queues[i]->steals;
+        }
+        return res;
+    }
+
+    void resetStats() {
+        std::lock_guard<std::mutex> submit(submitMutex);
+        for (std::size_t i = 0; i < queues.size(); ++i) {
+            queues[i]->executed = 0;
+            queues[i]->stolen = 0;
+            queues[i]->steals = 0;
+        }
+    }
+
+    /**
+     * Calls fn(t) once for every t in [0, nTasks), spreading the calls across the pool, and returns when all of
+     * them are done. Thread i starts out owning the i-th contiguous share of the tasks, so neighbouring tasks tend
+     * to run on the same thread. Calls made from inside a task run serially on the calling thread.
+     *
+     * @throws The first exception thrown by fn, once no thread is running a task any more
+     */
+    void parallelFor(std::size_t nTasks, const task_fn& fn) {
+        if (nTasks == 0)
+            return;
+        if (workers.empty() || nTasks == 1 || insideJob()) {
+            for (std::size_t t = 0; t < nTasks; ++t)
+                fn(t);
+            return;
+        }
+
+        std::lock_guard<std::mutex> submit(submitMutex);
+        const std::size_t nThreads = queues.size();
+        for (std::size_t i = 0; i < nThreads; ++i) {
+            std::lock_guard<std::mutex> lock(queues[i]->lock);
+            queues[i]->begin = nTasks * i / nThreads;
+            queues[i]->end = nTasks * (i + 1) / nThreads;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = &fn;
+            error = std::exception_ptr();
+            failed = false;
+            running = workers.size();
+            ++generation;
+        }
+        wake.notify_all();
+
+        {
+            JobScope scope;
+            runShare(0);
+        }
+
+        // Workers may still be calling fn even if this thread's share failed
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return running == 0; });
+        job = NULL;
+        const std::exception_ptr first = error;
+        error = std::exception_ptr();
+        lock.unlock();
+        if (first)
+            std::rethrow_exception(first);
+    }
+
+private:
+    /**
+     * The tasks [begin, end) currently owned by one thread. The owner pops from the back, thieves take from the
+     * front.
+     */
+    struct WorkQueue {
+        std::mutex lock;
+        std::size_t begin, end;
+        std::atomic<unsigned long> executed, stolen, steals;
+        char pad[64];  // Keep neighbouring queues off each other's cache line
+
+        WorkQueue() : begin(0), end(0), executed(0), stolen(0), steals(0) {}
+    };
+
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<WorkQueue> > queues;
+    mutable std::mutex submitMutex;  // Serializes jobs, resizes and stats, which all walk the queues
+    std::mutex mutex;
+    std::condition_variable wake, done;
+
+    const task_fn* job;
+    unsigned long generation;
+    std::size_t running;
+    bool stopping;
+    std::atomic<bool> failed;  // Set once a task of the current job has thrown
+    std::exception_ptr error;  // The first exception of the current job, guarded by mutex
+
+    /**
+     * @return Whether the current thread is executing a task of this pool.
+     */
+    static bool& insideJob() {
+        static thread_local bool inside = false;
+        return inside;
+    }
+
+    /**
+     * Marks the submitting thread as inside a job for its lifetime, however the job ends.
+     */
+    struct JobScope {
+        JobScope() {
+            insideJob() = true;
+        }
+
+        ~JobScope() {
+            insideJob() = false;
+        }
+    };
+
+    void start(std::size_t n) {
+        stopping = false;
+        queues.clear();
+        for (std::size_t id = 0; id < n; ++id)
+            queues.push_back(std::unique_ptr<WorkQueue>(new WorkQueue()));
+        for (std::size_t id = 1; id < n; ++id)
+            workers.push_back(std::thread(&ThreadPool::workerLoop, this, id, generation));
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::size_t i = 0; i < workers.size(); ++i)
+            workers[i].join();
+        workers.clear();
+    }
+
+    /**
+     * Takes the last task of a thread's own queue.
+     */
+    bool popLocal(std::size_t id, std::size_t& task) {
+        WorkQueue& q = *queues[id];
+        std::lock_guard<std::mutex> lock(q.lock);
+        if (q.begin == q.end)
+            return false;
+        task = --q.end;
+        return true;
+    }
+
+    /**
+     * Moves the front half of the first non-empty queue after id's into id's own (empty) queue.
+     *
+     * @return False if every queue was empty
+     */
+    bool steal(std::size_t id) {
+        const std::size_t nThreads = queues.size();
+        for (std::size_t offset = 1; offset < nThreads; ++offset) {
+            WorkQueue& victim = *queues[(id + offset) % nThreads];
+            std::size_t first, count;
+            {
+                std::lock_guard<std::mutex> lock(victim.lock);
+                const std::size_t remaining = victim.end - victim.begin;
+                if (remaining == 0)
+                    continue;
+                count = (remaining + 1) / 2;
+                first = victim.begin;
+                victim.begin += count;
+            }
+            WorkQueue& own = *queues[id];
+            {
+                std::lock_guard<std::mutex> lock(own.lock);
+                own.begin = first;
+                own.end = first + count;
+            }
+            own.stolen += count;
+            ++own.steals;
+            return true;
+        }  // offset
+        return false;
+    }
+
+    /**
+     * Runs tasks from id's queue, then stolen ones, until none are left or a task has thrown. Catches what the tasks
+     * throw, keeping the first exception for parallelFor().
+     */
+    void runShare(std::size_t id) {
+        std::size_t task;
+        try {
+            for (;;) {
+                while (!failed && popLocal(id, task)) {
+                    (*job)(task);
+                    ++queues[id]->executed;
+                }
+                if (failed || !steal(id))
+                    return;
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!error)
+                error = std::current_exception();
+            failed = true;
+        }
+    }
+
+    /**
+     * @param seen Generation of the last job submitted before this worker was started
+     */
+    void workerLoop(std::size_t id, unsigned long seen) {
+        insideJob() = true;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this, seen] { return stopping || generation != seen; });
+                if (stopping)
+                    return;
+                seen = generation;
+            }
+            runShare(id);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (--running == 0)
+                    done.notify_one();
+            }
+        }
+    }
+};
+
+/**
+ * Sets the number of threads used by matrix operations, including the calling thread. Values below 1 are treated
+ * as 1.
+ */
+inline void setNumThreads(std::size_t n) {
+    ThreadPool::instance().resize(n > 0 ? n : 1);
+}
+
+/**
+ * @return The number of threads used by matrix operations.
+ */
+inline std::size_t getNumThreads() {
+    return ThreadPool::instance().size();
+}
+
+#endif //MATRIX_THREADPOOL_H
@@ -0,0 +1,244 @@
+#ifndef MATRIX_TRIANGULAR_H
+#define MATRIX_TRIANGULAR_H
+
+#include <cstddef>
+#include <algorithm>
+#include <type_traits>
+
+#include "blocking.h"
+#include "gemm.h"
+#include "lu.h"
+#include "matrix.h"
+
+/**
+ * Triangular matrix products (TRMM) and triangular solves (TRSM) with many right-hand sides, on either side of B
+ * and with either triangle of A, optionally transposed. Both halve the triangle recursively: the off-diagonal block
+ * becomes one GEMM with the packed kernels of gemm.h, and the two diagonal blocks recurse. Only triangles of
+ * TRIANGULAR_LEAF rows are left to plain loops, which split B into strips on the thread pool: strips of columns
+ * when A is on the left, since each column of B is then independent, and strips of rows when it is on the right.
+ * A triangular product thus costs half the flops of the equivalent GEMM, and the other triangle of A is never
+ * read.
+ */
+namespace matmul {
+
+    enum Side { LEFT, RIGHT };
+
+    enum Triangle { LOWER, UPPER };
+
+    enum Diagonal { NON_UNIT, UNIT };
+
+    /**
+     * Triangles of at most this many rows are handled without the GEMM.
+     */
+    const std::size_t TRIANGULAR_LEAF = 32;
+
+    /**
+     * @return The start of block (r0, c0) of op(A) in the storage of A.
+     */
+    template <typename T>
+    const T* triangularBlock(const T* a, std::size_t lda, Transpose trans, std::size_t r0, std::size_t c0) {
+        return trans == TRANSPOSE ? a + c0 * lda + r0 : a + r0 * lda + c0;
+    }
+
+    /**
+     * Computes B = op(A)^-1 * B, or B = op(A) * B when solve is not set, for a k x k triangle op(A) and a k x n
+     * block B, by rows of B.
+     *
+     * @param lower Whether op(A), rather than A, is lower triangular
+     */
+    template <typename T>
+    void triangularLeafLeft(bool solve, bool lower, Transpose trans, bool unit, std::size_t k, std::size_t n,
+                            const T* a, std::size_t lda, T* b, std::size_t ldb) {
+        const bool t = trans == TRANSPOSE;
+        // A solve needs the rows it subtracts already solved; a product needs them not yet overwritten
+        const bool ascending = solve == lower;
+        forEachStrip(n, k * k * n, [=](std::size_t j0, std::size_t j1) {
+            for (std::size_t s = 0; s < k; ++s) {
+                const std::size_t i = ascending ? s : k - 1 - s;
+                T* row = b + i * ldb;
+                const T diag = unit ? T(1) : a[i * lda + i];
+                if (!solve && diag != T(1))
+                    for (std::size_t j = j0; j < j1; ++j)
+                        row[j] *= diag;
+                const std::size_t p0 = lower ? 0 : i + 1, p1 = lower ? i : k;
+                for (std::size_t p = p0; p < p1; ++p) {
+                    const T aip = t ? a[p * lda + i] : a[i * lda + p];
+                    const T coef = solve ? -aip : aip;
+                    const T* src = b + p * ldb;
+                    for (std::size_t j = j0; j < j1; ++j)
+                        row[j] += coef * src[j];
+                }  // p
+                if (solve && diag != T(1)) {
+                    const T inv = T(1) / diag;
+                    for (std::size_t j = j0; j < j1; ++j)
+                        row[j] *= inv;
+                }
+            }  // s
+        });
+    }
+
+    /**
+     * Computes B = B * op(A)^-1, or B = B * op(A) when solve is not set, for a k x k triangle op(A) and an m x k
+     * block B, row by row.
+     */
+    template <typename T>
+    void triangularLeafRight(bool solve, bool lower, Transpose trans, bool unit, std::size_t m, std::size_t k,
+                             const T* a, std::size_t lda, T* b, std::size_t ldb) {
+        const bool t = trans == TRANSPOSE;
+        const bool ascending = solve != lower;
+        forEachStrip(m, m * k * k, [=](std::size_t i0, std::size_t i1) {
+            for (std::size_t i = i0; i < i1; ++i) {
+                T* row = b + i * ldb;
+                for (std::size_t s = 0; s < k; ++s) {
+                    const std::size_t j = ascending ? s : k - 1 - s;
+                    const T diag = unit ? T(1) : a[j * lda + j];
+                    T sum = solve ? row[j] : row[j] * diag;
+                    const std::size_t p0 = lower ? j + 1 : 0, p1 = lower ? k : j;
+                    for (std::size_t p = p0; p < p1; ++p) {
+                        const T apj = t ? a[j * lda + p] : a[p * lda + j];
+                        sum = solve ? sum - row[p] * apj : sum + row[p] * apj;
+                    }  // p
+                    row[j] = solve ? sum / diag : sum;
+                }  // s
+            }  // i
+        });
+    }
+
+    /**
+     * Recursive TRSM or TRMM on an m x n block B, already scaled by alpha. The triangle, of size m on the left and
+     * n on the right, is split in halves, and its off-diagonal block maps one half of B, the source, onto the
+     * other, the target. A solve finishes the source before subtracting its product from the target; a product
+     * updates the target while the source still holds its old value.
+     */
+    template <typename T, typename Blocking>
+    void triangularRecurse(bool solve, Side side, bool lower, Transpose trans, bool unit, std::size_t m,
+                           std::size_t n, const T* a, std::size_t lda, T* b, std::size_t ldb) {
+        const bool left = side == LEFT;
+        const std::size_t k = left ? m : n;
+        if (k <= TRIANGULAR_LEAF) {
+            if (left)
+                triangularLeafLeft(solve, lower, trans, unit, m, n, a, lda, b, ldb);
+            else
+                triangularLeafRight(solve, lower, trans, unit, m, n, a, lda, b, ldb);
+            return;
+        }
+        const std::size_t k1 = k / 2, k2 = k - k1;
+        // op(A)[k1:, :k1] if lower, op(A)[:k1, k1:] if upper
+        const T* off = lower ? triangularBlock(a, lda, trans, k1, 0) : triangularBlock(a, lda, trans, 0, k1);
+        const bool sourceFirst = left == lower;
+        T* first = b;
+        T* second = left ? b + k1 * ldb : b + k1;
+        T* src = sourceFirst ? first : second;
+        T* dst = sourceFirst ? second : first;
+        const T* aSrc = sourceFirst ? a : a + k1 * lda + k1;
+        const T* aDst = sourceFirst ? a + k1 * lda + k1 : a;
+        const std::size_t ks = sourceFirst ? k1 : k2, kt = sourceFirst ? k2 : k1;
+
+        auto recurse = [=](const T* half, T* bHalf, std::size_t kHalf) {
+            triangularRecurse<T, Blocking>(solve, side, lower, trans, unit, left ? kHalf : m, left ? n : kHalf,
+                                           half, lda, bHalf, ldb);
+        };
+        auto update = [=]() {
+            const T sign = solve ? T(-1) : T(1);
+            if (left)
+                gemm<T, Blocking>(trans, NO_TRANSPOSE, kt, n, ks, sign, off, lda, src, ldb, T(1), dst, ldb);
+            else
+                gemm<T, Blocking>(NO_TRANSPOSE, trans, m, kt, ks, sign, src, ldb, off, lda, T(1), dst, ldb);
+        };
+        if (solve) {
+            recurse(aSrc, src, ks);
+            update();
+            recurse(aDst, dst, kt);
+        } else {
+            recurse(aDst, dst, kt);
+            update();
+            recurse(aSrc, src, ks);
+        }
+    }
+
+    /**
+     * Computes B = alpha * B in place for an m x n block.
+     */
+    template <typename T>
+    void scaleBlock(std::size_t m, std::size_t n, T alpha, T* b, std::size_t ldb) {
+        if (alpha == T(1))
+            return;
+        forEachStrip(m, m * n, [=](std::size_t i0, std::size_t i1) {
+            for (std::size_t i = i0; i < i1; ++i)
+                for (std::size_t j = 0; j < n; ++j)
+                    b[i * ldb + j] *= alpha;
+        });
+    }
+
+    /**
+     * Computes B = alpha * op(A) * B (side LEFT) or B = alpha * B * op(A) (side RIGHT) in place, for a row-major
+     * m x n matrix B and a triangular matrix A, m x m or n x n. Only the triangle uplo of A is read, and its diagonal
+     * only if diag is NON_UNIT.
+     *
+     * @param lda Row stride of A
+     * @param ldb Row stride of B
+     */
+    template <typename T, typename Blocking = DefaultBlocking<T> >
+    void trmm(Side side, Triangle uplo, Transpose transA, Diagonal diag, std::size_t m, std::size_t n, T alpha,
+              const T* a, std::size_t lda, T* b, std::size_t ldb) {
+        if (m == 0 || n == 0)
+            return;
+        scaleBlock(m, n, alpha, b, ldb);
+        const bool lower = (uplo == LOWER) != (transA == TRANSPOSE);
+        triangularRecurse<T, Blocking>(false, side, lower, transA, diag == UNIT, m, n, a, lda, b, ldb);
+    }
+
+    /**
+     * Solves op(A) * X = alpha * B (side LEFT) or X * op(A) = alpha * B (side RIGHT) in place of the row-major
+     * m x n matrix B, for a triangular matrix A, m x m or n x n. Only the triangle uplo of A is read, and its
+     * diagonal only if diag is NON_UNIT. A zero on the diagonal yields infinities or NaNs, as in BLAS.
+     */
+    template <typename T, typename Blocking = DefaultBlocking<T> >
+    void trsm(Side side, Triangle uplo, Transpose transA, Diagonal diag, std::size_t m, std::size_t n, T alpha,
+              const T* a, std::size_t lda, T* b, std::size_t ldb) {
+        static_assert(std::is_floating_point<T>::value, "Triangular solves need a floating point element type");
+        if (m == 0 || n == 0)
+            return;
+        scaleBlock(m, n, alpha, b, ldb);
+        const bool lower = (uplo == LOWER) != (transA == TRANSPOSE);
+        triangularRecurse<T, Blocking>(true, side, lower, transA, diag == UNIT, m, n, a, lda, b, ldb);
+    }
+}
+
+/**
+ * In-place triangular product b = alpha * op(a) * b (side LEFT) or b = alpha * b * op(a) (side RIGHT), reading only
+ * the triangle uplo of a.
+ *
+ * @throws Matrix<T>::empty_matrix if a or b is empty
+ * @throws Matrix<T>::size_mismatch if a is not square or does not match b on the given side
+ */
+template <typename T, typename Blocking>
+void trmm(matmul::Side side, matmul::Triangle uplo, matmul::Transpose transA, matmul::Diagonal diag, T alpha,
+          const Matrix<T, Blocking>& a, Matrix<T, Blocking>& b) {
+    if (a.shape(0) == 0 || a.shape(1) == 0 || b.shape(0) == 0 || b.shape(1) == 0)
+        throw typename Matrix<T, Blocking>::empty_matrix();
+    if (a.shape(0) != a.shape(1) || a.shape(0) != b.shape(side == matmul::LEFT ? 0 : 1))
+        throw typename Matrix<T, Blocking>::size_mismatch();
+    matmul::trmm<T, Blocking>(side, uplo, transA, diag, b.shape(0), b.shape(1), alpha, &a(0, 0), a.shape(1),
+                              &b(0, 0), b.shape(1));
+}
+
+/**
+ * In-place triangular solve of op(a) * x = alpha * b (side LEFT) or x * op(a) = alpha * b (side RIGHT), overwriting
+ * b with x and reading only the triangle uplo of a.
+ *
+ * @throws Matrix<T>::empty_matrix if a or b is empty
+ * @throws Matrix<T>::size_mismatch if a is not square or does not match b on the given side
+ */
+template <typename T, typename Blocking>
+void trsm(matmul::Side side, matmul::Triangle uplo, matmul::Transpose transA, matmul::Diagonal diag, T alpha,
+          const Matrix<T, Blocking>& a, Matrix<T, Blocking>& b) {
+    if (a.shape(0) == 0 || a.shape(1) == 0 || b.shape(0) == 0 || b.shape(1) == 0)
+        throw typename Matrix<T, Blocking>::empty_matrix();
+    if (a.shape(0) != a.shape(1) || a.shape(0) != b.shape(side == matmul::LEFT ? 0 : 1))
+        throw typename Matrix<T, Blocking>::size_mismatch();
+    matmul::trsm<T, Blocking>(side, uplo, transA, diag, b.shape(0), b.shape(1), alpha, &a(0, 0), a.shape(1),
+                              &b(0, 0), b.shape(1));
+}
+
+#endif //MATRIX_TRIANGULAR_H
@@ -0,0 +1,214 @@
+#ifndef MATRIX_TUNING_H
+#define MATRIX_TUNING_H
+
+#include <string>
+#include <map>
+#include <mutex>
+#include <fstream>
+#include <sstream>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+/**
+ * Rough classification of a product C(m x n) = A(m x k) * B(k x n). Products of different classes stress the cache
+ * hierarchy differently, so each class gets its own tuned blocking.
+ */
+enum ShapeClass {
+    SHAPE_SMALL,   // Everything fits in cache anyway
+    SHAPE_SQUARE,
+    SHAPE_TALL,    // m dominates
+    SHAPE_WIDE,    // n dominates
+    SHAPE_DEEP,    // k dominates
+    N_SHAPE_CLASSES
+};
+
+inline const char* shapeClassName(ShapeClass shape) {
+    static const char* names[N_SHAPE_CLASSES] = {"small", "square", "tall", "wide", "deep"};
+    return names[shape];
+}
+
+inline ShapeClass classifyShape(std::size_t m, std::size_t n, std::size_t k) {
+    if (m <= 128 && n <= 128 && k <= 128)
+        return SHAPE_SMALL;
+    if (m >= 4 * n && m >= 4 * k)
+        return SHAPE_TALL;
+    if (n >= 4 * m && n >= 4 * k)
+        return SHAPE_WIDE;
+    if (k >= 4 * m && k >= 4 * n)
+        return SHAPE_DEEP;
+    return SHAPE_SQUARE;
+}
+
+/**
+ * Name under which an element type is stored in the tuning profile. Types without a name are never tuned and
+ * always use the compiled-in defaults.
+ */
+template <typename T>
+struct TypeName {
+    static const char* get() { return NULL; }
+};
+
+template <> struct TypeName<float> { static const char* get() { return "float"; } };
+template <> struct TypeName<double> { static const char* get() { return "double"; } };
+template <> struct TypeName<int32_t> { static const char* get() { return "int32"; } };
+template <> struct TypeName<int64_t> { static const char* get() { return "int64"; } };
+
+/**
+ * Cache and register blocking of the GEMM engine: the micro-kernel (by name, see matmul::MicroKernel) and the
+ * I/K/J block sizes of the packed loop nest.
+ */
+struct GemmBlocking {
+    std::string kernel;
+    std::size_t mc, kc, nc;
+};
+
+/**
+ * Host-specific blocking parameters, as measured by the autotune tool. The profile is read once, the first time
+ * any operation asks for it, from the file named by the MATRIX_PROFILE environment variable, or from
+ * ~/.matrix_profile.<hostname> when that is unset. Without a profile every lookup misses and callers fall back to
+ * their compiled-in defaults.
+ *
+ * The file holds one entry per line:
+ *
+ *     gemm <type> <shape class> <kernel> <mc> <kc> <nc>
+ *     transpose <type> <block>
+ */
+class TuningProfile {
+public:
+    static TuningProfile& instance() {
+        static TuningProfile profile(defaultPath());
+        return profile;
+    }
+
+    /**
+     * @return The path the profile is loaded from at startup.
+     */
+    static std::string defaultPath() {
+        const char* env = std::getenv("MATRIX_PROFILE");
+        if (env != NULL)
+            return env;
+        const char* home = std::getenv("HOME");
+        std::string path = std::string(home != NULL ? home : ".") + "/.matrix_profile";
+#if defined(__unix__) || defined(__APPLE__)
+        char host[256];
+        if (gethostname(host, sizeof(host)) == 0) {
+            host[sizeof(host) - 1] = '\0';
+            path += std::string(".") + host;
+        }
+#endif
+        return path;
+    }
+
+    TuningProfile() {}
+
+    explicit TuningProfile(const std::string& path) {
+        load(path);
+    }
+
+    /**
+     * Replaces the current entries with those read from path.
+     *
+     * @return False if the file could not be opened; the profile is then left empty
+     */
+    bool load(const std::string& path) {
+        std::lock_guard<std::mutex> guard(lock);
+        gemm.clear();
+        xpose.clear();
+        std::ifstream in(path.c_str());
+        if (!in)
+            return false;
+
+        std::string line;
+        while (std::getline(in, line)) {
+            std::istringstream ss(line);
+            std::string what, type;
+            if (!(ss >> what >> type))
+                continue;
+            if (what == "gemm") {
+                std::string shape;
+                GemmBlocking b;
+                if (ss >> shape >> b.kernel >> b.mc >> b.kc >> b.nc && b.mc > 0 && b.kc > 0 && b.nc > 0)
+                    gemm[type + " " + shape] = b;
+            } else if (what == "transpose") {
+                std::size_t block;
+                if (ss >> block && block > 0)
+                    xpose[type] = block;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @return False if the file could not be written
+     */
+    bool save(const std::string& path) const {
+        std::lock_guard<std::mutex> guard(lock);
+        std::ofstream out(path.c_str());
+        if (!out)
+            return false;
+        for (std::map<std::string, GemmBlocking>::const_iterator it = gemm.begin(); it != gemm.end(); ++it) {
+            out << "gemm " << it->first << " " << it->second.kernel << " "
+                << it->second.mc << " " << it->second.kc << " " << it->second.nc << "\n";
+        }
+        for (std::map<std::string, std::size_t>::const_iterator it = xpose.begin(); it != xpose.end(); ++it)
+            out << "transpose " << it->first << " " << it->second << "\n";
+        return static_cast<bool>(out);
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> guard(lock);
+        gemm.clear();
+        xpose.clear();
+    }
+
+    void setGemm(const std::string& type, ShapeClass shape, const GemmBlocking& blocking) {
+        std::lock_guard<std::mutex> guard(lock);
+        gemm[type + " " + shapeClassName(shape)] = blocking;
+    }
+
+    /**
+     * @return False if there is no entry for this type and shape class
+     */
+    bool findGemm(const char* type, ShapeClass shape, GemmBlocking& blocking) const {
+        if (type == NULL)
+            return false;
+        std::lock_guard<std::mutex> guard(lock);
+        std::map<std::string, GemmBlocking>::const_iterator it =
+                gemm.find(std::string(type) + " " + shapeClassName(shape));
+        if (it == gemm.end())
+            return false;
+        blocking = it->second;
+        return true;
+    }
+
+    void setTranspose(const std::string& type, std::size_t block) {
+        std::lock_guard<std::mutex> guard(lock);
+        xpose[type] = block;
+    }
+
+    /**
+     * @return False if there is no entry for this type
+     */
+    bool findTranspose(const char* type, std::size_t& block) const {
+        if (type == NULL)
+            return false;
+        std::lock_guard<std::mutex> guard(lock);
+        std::map<std::string, std::size_t>::const_iterator it = xpose.find(type);
+        if (it == xpose.end())
+            return false;
+        block = it->second;
+        return true;
+    }
+
+private:
+    mutable std::mutex lock;
+    std::map<std::string, GemmBlocking> gemm;
+    std::map<std::string, std::size_t> xpose;
+};
+
+#endif //MATRIX_TUNING_H
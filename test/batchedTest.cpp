@@ -0,0 +1,157 @@
+#include "naiveMatrix.h"
+#include "batched.h"
+#include <gtest/gtest.h>
+#include <random>
+
+namespace {
+
+    /**
+     * Compares the batched entry points with the naive product of each pair. Operands are multiples of 1/8 with
+     * small magnitudes, so every sum is exact in float and double as well as in long.
+     */
+    class BatchedTest : public ::testing::Test {
+
+    protected:
+        const int MAX_DIM = 20;
+
+        std::default_random_engine generator;
+        std::uniform_int_distribution<> uniformDim;
+        std::uniform_int_distribution<> uniformData;
+
+        BatchedTest() {
+            generator = std::default_random_engine( (unsigned int)time(0) );
+            uniformDim = std::uniform_int_distribution<>(1, MAX_DIM);
+            uniformData = std::uniform_int_distribution<>(-100, 100);
+        }
+
+        template <typename T>
+        Matrix<T> randomMatrix(mat_size_t n_rows, mat_size_t n_cols) {
+            Matrix<T> m = Matrix<T>(std::make_pair(n_rows, n_cols));
+            for (mat_size_t i = 0; i < n_rows; ++i)
+                for (mat_size_t j = 0; j < n_cols; ++j)
+                    m(i, j) = static_cast<T>(uniformData(generator)) / 8;
+            return m;
+        }
+
+        template <typename T>
+        Matrix<T> naiveProduct(Matrix<T>& a, Matrix<T>& b) {
+            NaiveMatrix<T> naiveA(a);
+            NaiveMatrix<T> naiveB(b);
+            return naiveA * naiveB;
+        }
+
+        /**
+         * Multiplies batch pairs of m x k and k x n matrices through the pointer array and the strided entry point.
+         */
+        template <typename T>
+        void checkBatch(std::size_t batch, mat_size_t m, mat_size_t k, mat_size_t n) {
+            std::vector<Matrix<T> > a, b, c(batch, Matrix<T>(std::make_pair(m, n)));
+            std::vector<const T*> pa, pb;
+            std::vector<T*> pc;
+            std::vector<T> flatA, flatB, flatC(batch * m * n);
+            for (std::size_t i = 0; i < batch; ++i) {
+                a.push_back(randomMatrix<T>(m, k));
+                b.push_back(randomMatrix<T>(k, n));
+                pa.push_back(&a[i](0, 0));
+                pb.push_back(&b[i](0, 0));
+                pc.push_back(&c[i](0, 0));
+                flatA.insert(flatA.end(), pa[i], pa[i] + m * k);
+                flatB.insert(flatB.end(), pb[i], pb[i] + k * n);
+            }
+
+            matmul::batchedMultiply<T>(batch, m, n, k, pa.data(), k, pb.data(), n, pc.data(), n);
+            matmul::batchedMultiply<T>(batch, m, n, k, flatA.data(), k, m * k, flatB.data(), n, k * n,
+                                       flatC.data(), n, m * n);
+
+            for (std::size_t i = 0; i < batch; ++i) {
+                Matrix<T> expected = naiveProduct(a[i], b[i]);
+                ASSERT_EQ(c[i], expected) << "pointers, product " << i;
+                Matrix<T> strided = Matrix<T>(std::make_pair(m, n), std::vector<T>(
+                        flatC.begin() + i * m * n, flatC.begin() + (i + 1) * m * n));
+                ASSERT_EQ(strided, expected) << "strided, product " << i;
+            }
+        }
+
+        /**
+         * Every tile height and every width from a full vector down to a single column.
+         */
+        template <typename T>
+        void checkTileShapes() {
+            for (mat_size_t m = 1; m <= 9; ++m)
+                for (mat_size_t n = 1; n <= 33; n += 4)
+                    checkBatch<T>(3, m, 5, n);
+        }
+    };
+
+    TEST_F(BatchedTest, Float_Batch_Equals_Naive) {
+        checkBatch<float>(50, uniformDim(generator), uniformDim(generator), uniformDim(generator));
+        checkTileShapes<float>();
+    }
+
+    TEST_F(BatchedTest, Double_Batch_Equals_Naive) {
+        checkBatch<double>(50, uniformDim(generator), uniformDim(generator), uniformDim(generator));
+        checkTileShapes<double>();
+    }
+
+    TEST_F(BatchedTest, Long_Batch_Equals_Naive) {
+        checkBatch<long>(50, uniformDim(generator), uniformDim(generator), uniformDim(generator));
+        checkTileShapes<long>();
+    }
+
+    TEST_F(BatchedTest, Large_Products_Fall_Back_To_Gemm) {
+        const mat_size_t big = matmul::BATCH_SMALL_MAX + 3;
+        checkBatch<float>(4, 7, big, 9);
+        checkBatch<double>(2, big, 11, big);
+    }
+
+    TEST_F(BatchedTest, Large_Batch_Equals_Naive) {
+        checkBatch<float>(2000, 8, 8, 8);
+    }
+
+    TEST_F(BatchedTest, Zero_Stride_Reuses_Operand) {
+        const mat_size_t m = 6, k = 4, n = 10;
+        const std::size_t batch = 5;
+        Matrix<double> a = randomMatrix<double>(m, k);
+        std::vector<Matrix<double> > b;
+        std::vector<double> flatB, flatC(batch * m * n);
+        for (std::size_t i = 0; i < batch; ++i) {
+            b.push_back(randomMatrix<double>(k, n));
+            flatB.insert(flatB.end(), &b[i](0, 0), &b[i](0, 0) + k * n);
+        }
+        matmul::batchedMultiply<double>(batch, m, n, k, &a(0, 0), k, 0, flatB.data(), n, k * n,
+                                        flatC.data(), n, m * n);
+        for (std::size_t i = 0; i < batch; ++i) {
+            Matrix<double> res = Matrix<double>(std::make_pair(m, n), std::vector<double>(
+                    flatC.begin() + i * m * n, flatC.begin() + (i + 1) * m * n));
+            EXPECT_EQ(res, naiveProduct(a, b[i]));
+        }
+    }
+
+    TEST_F(BatchedTest, Matrix_Batch_Of_Mixed_Shapes_Equals_Naive) {
+        std::vector<Matrix<float> > a, b;
+        for (int i = 0; i < 30; ++i) {
+            const mat_size_t m = uniformDim(generator), k = uniformDim(generator);
+            a.push_back(randomMatrix<float>(m, k));
+            b.push_back(randomMatrix<float>(k, uniformDim(generator)));
+        }
+        a.push_back(randomMatrix<float>(70, 80));
+        b.push_back(randomMatrix<float>(80, 5));
+
+        std::vector<Matrix<float> > res = batchedMultiply(a, b);
+        ASSERT_EQ(res.size(), a.size());
+        for (std::size_t i = 0; i < a.size(); ++i)
+            EXPECT_EQ(res[i], naiveProduct(a[i], b[i])) << "product " << i;
+    }
+
+    TEST_F(BatchedTest, Mismatched_Batch_Throws_Size_Ex) {
+        std::vector<Matrix<float> > a(3, randomMatrix<float>(4, 5));
+        std::vector<Matrix<float> > b(2, randomMatrix<float>(5, 4));
+        EXPECT_THROW(batchedMultiply(a, b), Matrix<float>::size_mismatch);
+
+        b.push_back(randomMatrix<float>(6, 4));
+        EXPECT_THROW(batchedMultiply(a, b), Matrix<float>::size_mismatch);
+
+        std::vector<Matrix<float> > empty(3);
+        EXPECT_THROW(batchedMultiply(a, empty), Matrix<float>::empty_matrix);
+    }
+}
@@ -0,0 +1,111 @@
+#include "naiveMatrix.h"
+#include "chain.h"
+#include <gtest/gtest.h>
+#include <random>
+
+namespace {
+
+    class ChainTest : public ::testing::Test {
+
+    protected:
+        typedef long data_t;
+
+        const int MAX_DIM = 100;
+
+        std::default_random_engine generator;
+        std::uniform_int_distribution<> uniformDim;
+        std::uniform_int_distribution<> uniformData;
+
+        ChainTest() {
+            generator = std::default_random_engine( (unsigned int)time(0) );
+            uniformDim = std::uniform_int_distribution<>(1, MAX_DIM);
+            uniformData = std::uniform_int_distribution<>(-10, 10);
+        }
+
+        template <typename T>
+        Matrix<T> randomMatrix(mat_size_t n_rows, mat_size_t n_cols) {
+            Matrix<T> m = Matrix<T>(std::make_pair(n_rows, n_cols));
+            for (mat_size_t i = 0; i < n_rows; ++i)
+                for (mat_size_t j = 0; j < n_cols; ++j)
+                    m(i, j) = static_cast<T>(uniformData(generator));
+            return m;
+        }
+
+        /**
+         * Multiplies a random chain with the given shapes and compares it with the naive left-to-right product.
+         */
+        void checkChain(const std::vector<mat_size_t>& dims) {
+            std::vector<Matrix<data_t> > mats;
+            for (std::size_t i = 0; i + 1 < dims.size(); ++i)
+                mats.push_back(randomMatrix<data_t>(dims[i], dims[i + 1]));
+
+            Matrix<data_t> expected = mats[0];
+            for (std::size_t i = 1; i < mats.size(); ++i) {
+                NaiveMatrix<data_t> naive(expected);
+                expected = naive * mats[i];
+            }
+
+            matmul::ChainOrder order;
+            EXPECT_EQ(multiplyChain(mats, &order), expected);
+            EXPECT_EQ(order.size(), mats.size());
+        }
+    };
+
+    TEST_F(ChainTest, Order_Matches_Textbook_Example) {
+        const std::size_t dims[] = {30, 35, 15, 5, 10, 20, 25};
+        matmul::ChainOrder order = matmul::chainOrder(std::vector<std::size_t>(dims, dims + 7));
+
+        EXPECT_EQ(order.flops, 2u * 15125);
+        EXPECT_EQ(order.to_string(), "((A0 * (A1 * A2)) * ((A3 * A4) * A5))");
+    }
+
+    TEST_F(ChainTest, Matrix_Vector_Chain_Is_Evaluated_Right_To_Left) {
+        const std::size_t dims[] = {500, 500, 500, 1};
+        matmul::ChainOrder order = matmul::chainOrder(std::vector<std::size_t>(dims, dims + 4));
+
+        EXPECT_EQ(order.to_string(), "(A0 * (A1 * A2))");
+        EXPECT_EQ(order.flops, 2u * 2 * 500 * 500);
+    }
+
+    TEST_F(ChainTest, Random_Chain_Equals_Naive) {
+        std::vector<mat_size_t> dims;
+        const int length = 2 + uniformDim(generator) % 6;
+        for (int i = 0; i <= length; ++i)
+            dims.push_back(uniformDim(generator));
+        checkChain(dims);
+    }
+
+    TEST_F(ChainTest, Chain_With_Vector_Shapes_Equals_Naive) {
+        checkChain({1, 60, 80, 70, 1});
+        checkChain({90, 1, 70, 50});
+        checkChain({40, 40, 40, 1});
+    }
+
+    TEST_F(ChainTest, Single_Matrix_Is_Returned) {
+        Matrix<data_t> a = randomMatrix<data_t>(uniformDim(generator), uniformDim(generator));
+        matmul::ChainOrder order;
+
+        EXPECT_EQ(multiplyChain(std::vector<Matrix<data_t> >(1, a), &order), a);
+        EXPECT_EQ(order.flops, 0u);
+        EXPECT_EQ(order.to_string(), "A0");
+    }
+
+    TEST_F(ChainTest, Mismatched_Chain_Throws_Size_Ex) {
+        const mat_size_t dim = uniformDim(generator);
+        std::vector<Matrix<data_t> > mats;
+        mats.push_back(randomMatrix<data_t>(dim, dim));
+        mats.push_back(randomMatrix<data_t>(dim, dim));
+        mats.push_back(randomMatrix<data_t>(dim + 1, dim));
+
+        EXPECT_THROW(multiplyChain(mats), Matrix<data_t>::size_mismatch);
+    }
+
+    TEST_F(ChainTest, Empty_Chain_Throws_Empty_Ex) {
+        std::vector<Matrix<data_t> > mats;
+        EXPECT_THROW(multiplyChain(mats), Matrix<data_t>::empty_matrix);
+
+        mats.push_back(randomMatrix<data_t>(3, 3));
+        mats.push_back(Matrix<data_t>());
+        EXPECT_THROW(multiplyChain(mats), Matrix<data_t>::empty_matrix);
+    }
+}
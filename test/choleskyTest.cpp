@@ -0,0 +1,136 @@
+#include "cholesky.h"
+#include <gtest/gtest.h>
+#include <random>
+
+namespace {
+
+    class CholeskyTest : public ::testing::Test {
+
+    protected:
+        const int MAX_DIM = 300;
+
+        std::default_random_engine generator;
+        std::uniform_int_distribution<> uniformDim;
+        std::uniform_real_distribution<double> uniformData;
+
+        CholeskyTest() {
+            generator = std::default_random_engine( (unsigned int)time(0) );
+            uniformDim = std::uniform_int_distribution<>(1, MAX_DIM);
+            uniformData = std::uniform_real_distribution<double>(-1, 1);
+        }
+
+        template <typename T>
+        Matrix<T> randomMatrix(mat_size_t n_rows, mat_size_t n_cols) {
+            Matrix<T> m = Matrix<T>(std::make_pair(n_rows, n_cols));
+            for (mat_size_t i = 0; i < n_rows; ++i)
+                for (mat_size_t j = 0; j < n_cols; ++j)
+                    m(i, j) = static_cast<T>(uniformData(generator));
+            return m;
+        }
+
+        /**
+         * @return X * X^T + n * I for a random n x n matrix X.
+         */
+        template <typename T>
+        Matrix<T> randomSpd(mat_size_t n) {
+            Matrix<T> a = syrk(randomMatrix<T>(n, n));
+            for (mat_size_t i = 0; i < n; ++i)
+                a(i, i) += static_cast<T>(n);
+            return a;
+        }
+
+        /**
+         * Factors a random SPD matrix with the given panel width and checks that L is lower triangular and that
+         * L * L^T equals the input.
+         */
+        void checkFactor(mat_size_t n, std::size_t block) {
+            Matrix<double> a = randomSpd<double>(n);
+            Matrix<double> l = a;
+            ASSERT_TRUE(matmul::cholesky(n, &l(0, 0), n, block));
+
+            for (mat_size_t i = 0; i < n; ++i) {
+                for (mat_size_t j = 0; j < n; ++j) {
+                    if (j > i) {
+                        EXPECT_EQ(l(i, j), 0);
+                        continue;
+                    }
+                    double sum = 0;
+                    for (mat_size_t p = 0; p <= j; ++p)
+                        sum += l(i, p) * l(j, p);
+                    EXPECT_NEAR(sum, a(i, j), 1e-10 * n);
+                }  // j
+            }  // i
+        }
+    };
+
+    TEST_F(CholeskyTest, Factor_Reconstructs_Matrix) {
+        checkFactor(uniformDim(generator), matmul::CHOLESKY_BLOCK);
+        checkFactor(uniformDim(generator), 5);
+        checkFactor(2 * matmul::CHOLESKY_BLOCK + 37, matmul::CHOLESKY_BLOCK);
+        checkFactor(1, matmul::CHOLESKY_BLOCK);
+    }
+
+    TEST_F(CholeskyTest, Upper_Triangle_Is_Not_Read) {
+        const mat_size_t n = uniformDim(generator);
+        Matrix<double> a = randomSpd<double>(n);
+        Matrix<double> lower = a;
+        for (mat_size_t i = 0; i < n; ++i)
+            for (mat_size_t j = i + 1; j < n; ++j)
+                lower(i, j) = -1000;
+
+        EXPECT_EQ(Cholesky<double>(lower).factor(), Cholesky<double>(a).factor());
+    }
+
+    TEST_F(CholeskyTest, Solve_Has_Small_Residual) {
+        const mat_size_t n = uniformDim(generator), cols = uniformDim(generator);
+        Matrix<double> a = randomSpd<double>(n);
+        Matrix<double> b = randomMatrix<double>(n, cols);
+
+        Matrix<double> x = Cholesky<double>(a).solve(b);
+        Matrix<double> ax = a * x;
+        for (mat_size_t i = 0; i < n; ++i)
+            for (mat_size_t j = 0; j < cols; ++j)
+                EXPECT_NEAR(ax(i, j), b(i, j), 1e-8 * n);
+    }
+
+    TEST_F(CholeskyTest, Float_Inverse_Times_Matrix_Is_Identity) {
+        const mat_size_t n = uniformDim(generator);
+        Matrix<float> a = randomSpd<float>(n);
+
+        Matrix<float> inv = Cholesky<float>(a).inverse();
+        Matrix<float> id = inv * a;
+        for (mat_size_t i = 0; i < n; ++i)
+            for (mat_size_t j = 0; j < n; ++j)
+                EXPECT_NEAR(id(i, j), i == j ? 1 : 0, 1e-4f);
+    }
+
+    TEST_F(CholeskyTest, Determinant_Matches_LU) {
+        const mat_size_t n = uniformDim(generator) % 40 + 1;
+        Matrix<double> a = randomSpd<double>(n);
+        const double det = determinant(a);
+
+        EXPECT_NEAR(Cholesky<double>(a).determinant(), det, 1e-10 * std::abs(det));
+    }
+
+    TEST_F(CholeskyTest, Indefinite_Matrix_Is_Detected) {
+        const mat_size_t n = uniformDim(generator) + 1;
+        Matrix<double> a = randomSpd<double>(n);
+        a(n - 1, n - 1) = -1;
+
+        Cholesky<double> chol(a);
+        EXPECT_FALSE(chol.positiveDefinite());
+        EXPECT_EQ(chol.determinant(), 0);
+        EXPECT_THROW(chol.solve(a), Matrix<double>::singular_matrix);
+    }
+
+    TEST_F(CholeskyTest, Bad_Shapes_Throw) {
+        const mat_size_t n = uniformDim(generator);
+        Matrix<double> a = randomMatrix<double>(n, n + 1);
+        Matrix<double> b = randomMatrix<double>(n + 1, 1);
+        Matrix<double> empty;
+
+        EXPECT_THROW(Cholesky<double> chol(a), Matrix<double>::size_mismatch);
+        EXPECT_THROW(Cholesky<double>(randomSpd<double>(n)).solve(b), Matrix<double>::size_mismatch);
+        EXPECT_THROW(Cholesky<double> chol(empty), Matrix<double>::empty_matrix);
+    }
+}
@@ -0,0 +1,204 @@
+#include "eigen.h"
+#include <gtest/gtest.h>
+#include <random>
+
+namespace {
+
+    class EigenTest : public ::testing::Test {
+
+    protected:
+        const int MAX_DIM = 200;
+
+        std::default_random_engine generator;
+        std::uniform_int_distribution<> uniformDim;
+        std::uniform_real_distribution<double> uniformData;
+
+        EigenTest() {
+            generator = std::default_random_engine( (unsigned int)time(0) );
+            uniformDim = std::uniform_int_distribution<>(1, MAX_DIM);
+            uniformData = std::uniform_real_distribution<double>(-1, 1);
+        }
+
+        template <typename T>
+        Matrix<T> randomMatrix(mat_size_t n_rows, mat_size_t n_cols) {
+            Matrix<T> m = Matrix<T>(std::make_pair(n_rows, n_cols));
+            for (mat_size_t i = 0; i < n_rows; ++i)
+                for (mat_size_t j = 0; j < n_cols; ++j)
+                    m(i, j) = static_cast<T>(uniformData(generator));
+            return m;
+        }
+
+        template <typename T>
+        Matrix<T> randomSymmetric(mat_size_t n) {
+            Matrix<T> m = Matrix<T>(std::make_pair(n, n));
+            for (mat_size_t i = 0; i < n; ++i)
+                for (mat_size_t j = 0; j <= i; ++j)
+                    m(i, j) = m(j, i) = static_cast<T>(uniformData(generator));
+            return m;
+        }
+
+        /**
+         * Checks that the columns of v are orthonormal and that a * v = v * diag(lambda).
+         */
+        void checkEigenpairs(Matrix<double> a, const std::vector<double>& lambda, Matrix<double> v) {
+            const mat_size_t n = a.shape(0), k = v.shape(1);
+            ASSERT_EQ(lambda.size(), k);
+            for (mat_size_t j = 1; j < k; ++j)
+                EXPECT_GE(lambda[j - 1], lambda[j]);
+
+            Matrix<double> av = a * v;
+            for (mat_size_t i = 0; i < n; ++i)
+                for (mat_size_t j = 0; j < k; ++j)
+                    EXPECT_NEAR(av(i, j), lambda[j] * v(i, j), 1e-10 * n);
+            for (mat_size_t p = 0; p < k; ++p) {
+                for (mat_size_t q = 0; q < k; ++q) {
+                    double dot = 0;
+                    for (mat_size_t i = 0; i < n; ++i)
+                        dot += v(i, p) * v(i, q);
+                    EXPECT_NEAR(dot, p == q ? 1 : 0, 1e-10 * n);
+                }  // q
+            }  // p
+        }
+    };
+
+    TEST_F(EigenTest, Eigenpairs_Satisfy_Definition) {
+        const mat_size_t n = uniformDim(generator);
+        Matrix<double> a = randomSymmetric<double>(n);
+        SymmetricEigen<double> eig(a);
+        checkEigenpairs(a, eig.eigenvalues(), eig.eigenvectors());
+
+        double trace = 0, sum = 0;
+        for (mat_size_t i = 0; i < n; ++i) {
+            trace += a(i, i);
+            sum += eig.eigenvalues()[i];
+        }  // i
+        EXPECT_NEAR(sum, trace, 1e-10 * n);
+    }
+
+    TEST_F(EigenTest, Top_Eigenpairs_Match_Full_Decomposition) {
+        const mat_size_t n = 2 * matmul::EIGEN_BLOCK + uniformDim(generator);
+        const mat_size_t k = std::min<mat_size_t>(n, 10);
+        Matrix<double> a = randomSymmetric<double>(n);
+        SymmetricEigen<double> all(a), top(a, k);
+        checkEigenpairs(a, top.eigenvalues(), top.eigenvectors());
+        for (mat_size_t j = 0; j < k; ++j)
+            EXPECT_NEAR(top.eigenvalues()[j], all.eigenvalues()[j], 1e-10 * n);
+    }
+
+    TEST_F(EigenTest, Repeated_Eigenvalues_Have_Orthogonal_Vectors) {
+        // diag(B, B, I) has every eigenvalue of B twice, and 1 many times
+        const mat_size_t m = uniformDim(generator), n = 2 * m + 20;
+        Matrix<double> b = randomSymmetric<double>(m);
+        Matrix<double> a = Matrix<double>(std::make_pair(n, n));
+        for (mat_size_t i = 0; i < m; ++i) {
+            for (mat_size_t j = 0; j < m; ++j)
+                a(i, j) = a(m + i, m + j) = b(i, j);
+        }  // i
+        for (mat_size_t i = 2 * m; i < n; ++i)
+            a(i, i) = 1;
+
+        SymmetricEigen<double> eig(a);
+        checkEigenpairs(a, eig.eigenvalues(), eig.eigenvectors());
+    }
+
+    TEST_F(EigenTest, Reduction_Handles_Odd_Block_Sizes) {
+        const mat_size_t n = uniformDim(generator) + 1;
+        Matrix<double> a = randomSymmetric<double>(n);
+        Matrix<double> t = a;
+        std::vector<double> d(n), e(n - 1), tau(n - 1);
+        matmul::tridiagonalize(n, &t(0, 0), n, d.data(), e.data(), tau.data(), 7);
+
+        // Q^T * A * Q is tridiagonal with d and e, so Q * T = A * Q
+        Matrix<double> q = Matrix<double>(std::make_pair(n, n));
+        for (mat_size_t i = 0; i < n; ++i)
+            q(i, i) = 1;
+        matmul::tridiagonalApply(n, &t(0, 0), n, tau.data(), n, &q(0, 0), n);
+        Matrix<double> aq = a * q;
+        for (mat_size_t i = 0; i < n; ++i) {
+            for (mat_size_t j = 0; j < n; ++j) {
+                double qt = q(i, j) * d[j];
+                if (j > 0)
+                    qt += q(i, j - 1) * e[j - 1];
+                if (j + 1 < n)
+                    qt += q(i, j + 1) * e[j];
+                EXPECT_NEAR(aq(i, j), qt, 1e-10 * n);
+            }  // j
+        }  // i
+    }
+
+    TEST_F(EigenTest, Small_Matrices_Have_Known_Eigenvalues) {
+        Matrix<double> one = Matrix<double>(std::make_pair(1, 1), {-3});
+        SymmetricEigen<double> eig1(one);
+        EXPECT_EQ(eig1.eigenvalues()[0], -3);
+        EXPECT_EQ(std::abs(eig1.eigenvectors()(0, 0)), 1);
+
+        Matrix<double> two = Matrix<double>(std::make_pair(2, 2), {2, 1,
+                                                                   1, 2});
+        SymmetricEigen<double> eig2(two);
+        EXPECT_NEAR(eig2.eigenvalues()[0], 3, 1e-14);
+        EXPECT_NEAR(eig2.eigenvalues()[1], 1, 1e-14);
+        checkEigenpairs(two, eig2.eigenvalues(), eig2.eigenvectors());
+    }
+
+    TEST_F(EigenTest, Float_Eigenpairs_Have_Small_Residual) {
+        const mat_size_t n = uniformDim(generator);
+        Matrix<float> a = randomSymmetric<float>(n);
+        SymmetricEigen<float> eig(a, std::min<mat_size_t>(n, 5));
+        Matrix<float> v = eig.eigenvectors();
+        Matrix<float> av = a * v;
+        for (mat_size_t i = 0; i < n; ++i)
+            for (mat_size_t j = 0; j < eig.eigenvalues().size(); ++j)
+                EXPECT_NEAR(av(i, j), eig.eigenvalues()[j] * v(i, j), 1e-4f * n);
+    }
+
+    TEST_F(EigenTest, Svd_Reconstructs_Tall_And_Wide_Matrices) {
+        const mat_size_t m = uniformDim(generator), n = uniformDim(generator);
+        for (int wide = 0; wide < 2; ++wide) {
+            Matrix<double> a = wide ? randomMatrix<double>(std::min(m, n), std::max(m, n))
+                                    : randomMatrix<double>(std::max(m, n), std::min(m, n));
+            SVD<double> svd(a);
+            const std::vector<double>& sigma = svd.singularValues();
+            ASSERT_EQ(sigma.size(), std::min(m, n));
+            ASSERT_EQ(svd.u().shape(0), a.shape(0));
+            ASSERT_EQ(svd.v().shape(0), a.shape(1));
+
+            Matrix<double> us = svd.u();
+            for (mat_size_t i = 0; i < us.shape(0); ++i)
+                for (mat_size_t j = 0; j < us.shape(1); ++j)
+                    us(i, j) *= sigma[j];
+            Matrix<double> vt = svd.v();
+            vt = vt.transpose();
+            Matrix<double> usv = us * vt;
+            for (mat_size_t i = 0; i < a.shape(0); ++i)
+                for (mat_size_t j = 0; j < a.shape(1); ++j)
+                    EXPECT_NEAR(usv(i, j), a(i, j), 1e-8 * (m + n));
+        }  // wide
+    }
+
+    TEST_F(EigenTest, Truncated_Svd_Has_Leading_Singular_Values) {
+        const mat_size_t n = uniformDim(generator) + 10;
+        Matrix<double> a = randomMatrix<double>(2 * n, n);
+        SVD<double> svd(a, 3);
+        Matrix<double> at = a.transpose();
+        SymmetricEigen<double> gram(at * a, 3);
+        for (mat_size_t j = 0; j < 3; ++j) {
+            EXPECT_NEAR(svd.singularValues()[j] * svd.singularValues()[j], gram.eigenvalues()[j], 1e-10 * n);
+            double norm = 0;
+            for (mat_size_t i = 0; i < 2 * n; ++i)
+                norm += svd.u()(i, j) * svd.u()(i, j);
+            EXPECT_NEAR(norm, 1, 1e-10);
+        }  // j
+    }
+
+    TEST_F(EigenTest, Bad_Shapes_Throw) {
+        const mat_size_t n = uniformDim(generator);
+        Matrix<double> a = randomMatrix<double>(n, n + 1);
+        Matrix<double> empty;
+
+        EXPECT_THROW(SymmetricEigen<double> eig(a), Matrix<double>::size_mismatch);
+        EXPECT_THROW(SymmetricEigen<double> eig(randomSymmetric<double>(n), n + 1), Matrix<double>::size_mismatch);
+        EXPECT_THROW(SymmetricEigen<double> eig(empty), Matrix<double>::empty_matrix);
+        EXPECT_THROW(SVD<double> svd(a, n + 1), Matrix<double>::size_mismatch);
+        EXPECT_THROW(SVD<double> svd(empty), Matrix<double>::empty_matrix);
+    }
+}
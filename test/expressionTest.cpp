@@ -0,0 +1,141 @@
+#include "naiveMatrix.h"
+#include "expression.h"
+#include <gtest/gtest.h>
+#include <random>
+
+namespace {
+
+    class ExpressionTest : public ::testing::Test {
+
+    protected:
+        typedef long data_t;
+
+        const int MAX_DIM = 200;
+
+        std::default_random_engine generator;
+        std::uniform_int_distribution<> uniformDim;
+        std::uniform_int_distribution<> uniformData;
+
+        ExpressionTest() {
+            generator = std::default_random_engine( (unsigned int)time(0) );
+            uniformDim = std::uniform_int_distribution<>(1, MAX_DIM);
+            uniformData = std::uniform_int_distribution<>(-1000, 1000);
+        }
+
+        template <typename T>
+        Matrix<T> randomMatrix(mat_size_t n_rows, mat_size_t n_cols) {
+            Matrix<T> m = Matrix<T>(std::make_pair(n_rows, n_cols));
+            for (mat_size_t i = 0; i < n_rows; ++i)
+                for (mat_size_t j = 0; j < n_cols; ++j)
+                    m(i, j) = static_cast<T>(uniformData(generator));
+            return m;
+        }
+
+        template <typename T>
+        Matrix<T> naiveProduct(Matrix<T>& a, Matrix<T>& b) {
+            NaiveMatrix<T> naiveA(a);
+            NaiveMatrix<T> naiveB(b);
+            return naiveA * naiveB;
+        }
+
+        /**
+         * @return x * a + y * b, element by element.
+         */
+        template <typename T>
+        Matrix<T> combine(T x, const Matrix<T>& a, T y, const Matrix<T>& b) {
+            Matrix<T> res = Matrix<T>(std::make_pair(a.shape(0), a.shape(1)));
+            for (mat_size_t i = 0; i < a.shape(0); ++i)
+                for (mat_size_t j = 0; j < a.shape(1); ++j)
+                    res(i, j) = x * a(i, j) + y * b(i, j);
+            return res;
+        }
+    };
+
+    TEST_F(ExpressionTest, Elementwise_Expression_Equals_Loop) {
+        const mat_size_t rows = uniformDim(generator), cols = uniformDim(generator);
+        Matrix<data_t> a = randomMatrix<data_t>(rows, cols);
+        Matrix<data_t> b = randomMatrix<data_t>(rows, cols);
+        Matrix<data_t> c = randomMatrix<data_t>(rows, cols);
+
+        Matrix<data_t> res = a + 3 * b - c * 2 - (-c);
+        Matrix<data_t> expected = combine<data_t>(1, combine<data_t>(1, a, 3, b), -1, c);
+        EXPECT_EQ(res, expected);
+    }
+
+    TEST_F(ExpressionTest, Chained_Products_Equal_Naive) {
+        const mat_size_t m = uniformDim(generator), n = uniformDim(generator);
+        const mat_size_t k1 = uniformDim(generator), k2 = uniformDim(generator);
+        Matrix<data_t> a = randomMatrix<data_t>(m, k1);
+        Matrix<data_t> b = randomMatrix<data_t>(k1, n);
+        Matrix<data_t> c = randomMatrix<data_t>(m, k2);
+        Matrix<data_t> d = randomMatrix<data_t>(k2, n);
+        Matrix<data_t> e = randomMatrix<data_t>(m, n);
+        Matrix<data_t> ab = naiveProduct(a, b);
+        Matrix<data_t> cd = naiveProduct(c, d);
+
+        Matrix<data_t> res = lazy(a) * b + lazy(c) * d - e;
+        EXPECT_EQ(res, combine<data_t>(1, combine<data_t>(1, ab, 1, cd), -1, e));
+
+        Matrix<data_t> products = lazy(a) * b - 2 * (lazy(c) * d);
+        EXPECT_EQ(products, combine<data_t>(1, ab, -2, cd));
+    }
+
+    TEST_F(ExpressionTest, Compound_Operands_Equal_Naive) {
+        const mat_size_t m = uniformDim(generator), n = uniformDim(generator), k = uniformDim(generator);
+        Matrix<data_t> a = randomMatrix<data_t>(m, k);
+        Matrix<data_t> b = randomMatrix<data_t>(m, k);
+        Matrix<data_t> c = randomMatrix<data_t>(k, n);
+        Matrix<data_t> sum = combine<data_t>(1, a, 1, b);
+
+        Matrix<data_t> res = (a + b) * c;
+        EXPECT_EQ(res, naiveProduct(sum, c));
+    }
+
+    TEST_F(ExpressionTest, Assignment_To_An_Operand_Equals_Naive) {
+        const mat_size_t n = uniformDim(generator);
+        Matrix<data_t> a = randomMatrix<data_t>(n, n);
+        Matrix<data_t> b = randomMatrix<data_t>(n, n);
+        Matrix<data_t> expected = combine<data_t>(1, naiveProduct(a, b), 1, a);
+
+        a = lazy(a) * b + a;
+        EXPECT_EQ(a, expected);
+
+        Matrix<data_t> c = randomMatrix<data_t>(n, 3);
+        Matrix<data_t> scaled = combine<data_t>(2, c, 0, c);
+        c = c + c;
+        EXPECT_EQ(c, scaled);
+    }
+
+    TEST_F(ExpressionTest, Float_Expression_Close_To_Naive) {
+        const mat_size_t m = uniformDim(generator), n = uniformDim(generator), k = uniformDim(generator);
+        Matrix<float> a = randomMatrix<float>(m, k);
+        Matrix<float> b = randomMatrix<float>(k, n);
+        Matrix<float> c = randomMatrix<float>(m, n);
+        Matrix<float> ab = naiveProduct(a, b);
+
+        Matrix<float> res = 0.5f * lazy(a) * b - c;
+        for (mat_size_t i = 0; i < m; ++i)
+            for (mat_size_t j = 0; j < n; ++j)
+                EXPECT_NEAR(res(i, j), 0.5f * ab(i, j) - c(i, j), 1e-4f * k * 1000 * 1000);
+    }
+
+    TEST_F(ExpressionTest, Mismatched_Operands_Throw_Size_Ex) {
+        const mat_size_t dim = uniformDim(generator);
+        Matrix<data_t> a = randomMatrix<data_t>(dim, dim);
+        Matrix<data_t> b = randomMatrix<data_t>(dim, dim + 1);
+        Matrix<data_t> c = randomMatrix<data_t>(dim + 1, dim);
+
+        EXPECT_THROW(a + b, Matrix<data_t>::size_mismatch);
+        EXPECT_THROW(a - c, Matrix<data_t>::size_mismatch);
+        EXPECT_THROW(lazy(b) * b, Matrix<data_t>::size_mismatch);
+        EXPECT_THROW(lazy(a) * b + a, Matrix<data_t>::size_mismatch);
+    }
+
+    TEST_F(ExpressionTest, Empty_Operand_Throws_Empty_Ex) {
+        Matrix<data_t> a = randomMatrix<data_t>(3, 3);
+        Matrix<data_t> empty;
+
+        EXPECT_THROW(a + empty, Matrix<data_t>::empty_matrix);
+        EXPECT_THROW(lazy(empty), Matrix<data_t>::empty_matrix);
+    }
+}
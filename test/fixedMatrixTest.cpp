@@ -0,0 +1,91 @@
+#include "naiveMatrix.h"
+#include "fixedMatrix.h"
+#include <gtest/gtest.h>
+#include <random>
+
+namespace {
+
+    class FixedMatrixTest : public ::testing::Test {
+
+    protected:
+        typedef long data_t;
+
+        std::default_random_engine generator;
+        std::uniform_int_distribution<> uniformData;
+
+        FixedMatrixTest() {
+            generator = std::default_random_engine( (unsigned int)time(0) );
+            uniformData = std::uniform_int_distribution<>(-1000, 1000);
+        }
+
+        template <mat_size_t R, mat_size_t C>
+        FixedMatrix<data_t, R, C> randomMatrix() {
+            FixedMatrix<data_t, R, C> m;
+            for (mat_size_t i = 0; i < R; ++i)
+                for (mat_size_t j = 0; j < C; ++j)
+                    m(i, j) = uniformData(generator);
+            return m;
+        }
+
+        template <mat_size_t R, mat_size_t K, mat_size_t C>
+        void checkProduct() {
+            FixedMatrix<data_t, R, K> a = randomMatrix<R, K>();
+            FixedMatrix<data_t, K, C> b = randomMatrix<K, C>();
+            Matrix<data_t> dynA = a, dynB = b;
+            NaiveMatrix<data_t> naiveA(dynA);
+            NaiveMatrix<data_t> naiveB(dynB);
+            Matrix<data_t> expected = naiveA * naiveB;
+            EXPECT_EQ((a * b).toMatrix(), expected);
+            EXPECT_EQ(a * dynB, expected);
+            EXPECT_EQ(dynA * b, expected);
+        }
+    };
+
+    TEST_F(FixedMatrixTest, Default_Is_Zero) {
+        FixedMatrix<data_t, 3, 2> m;
+        EXPECT_EQ(m.shape(0), 3);
+        EXPECT_EQ(m.shape(1), 2);
+        EXPECT_THROW(m.shape(2), Matrix<data_t>::bad_shape);
+        for (mat_size_t i = 0; i < 3; ++i)
+            for (mat_size_t j = 0; j < 2; ++j)
+                EXPECT_EQ(m(i, j), 0);
+    }
+
+    TEST_F(FixedMatrixTest, Initializer_List_Fills_Row_By_Row) {
+        FixedMatrix<data_t, 2, 3> m = {1, 2, 3, 4, 5, 6};
+        EXPECT_EQ(m(0, 2), 3);
+        EXPECT_EQ(m(1, 0), 4);
+        EXPECT_THROW((FixedMatrix<data_t, 2, 3>{1, 2, 3}), Matrix<data_t>::size_mismatch);
+    }
+
+    TEST_F(FixedMatrixTest, Round_Trips_Through_Matrix) {
+        FixedMatrix<data_t, 4, 4> m = randomMatrix<4, 4>();
+        Matrix<data_t> dyn = m;
+        EXPECT_EQ((FixedMatrix<data_t, 4, 4>(dyn)), m);
+        EXPECT_THROW((FixedMatrix<data_t, 4, 3>(dyn)), Matrix<data_t>::size_mismatch);
+    }
+
+    TEST_F(FixedMatrixTest, Transpose_Equals_Naive) {
+        FixedMatrix<data_t, 3, 5> m = randomMatrix<3, 5>();
+        Matrix<data_t> dyn = m;
+        NaiveMatrix<data_t> naive(dyn);
+        EXPECT_EQ(m.transpose().toMatrix(), naive.transpose());
+        EXPECT_EQ(m.transpose().transpose(), m);
+    }
+
+    TEST_F(FixedMatrixTest, MatMul_Equals_Naive) {
+        checkProduct<3, 3, 3>();
+        checkProduct<4, 4, 4>();
+        checkProduct<1, 7, 2>();
+        checkProduct<6, 1, 5>();
+    }
+
+    TEST_F(FixedMatrixTest, Mixed_MatMul_Checks_Shapes) {
+        FixedMatrix<data_t, 3, 3> m = randomMatrix<3, 3>();
+        Matrix<data_t> wrong = Matrix<data_t>(std::make_pair(4, 3)), empty;
+        EXPECT_THROW(m * wrong, Matrix<data_t>::size_mismatch);
+        EXPECT_THROW(wrong.transpose() * m, Matrix<data_t>::size_mismatch);
+        EXPECT_THROW(m * empty, Matrix<data_t>::empty_matrix);
+        EXPECT_THROW(empty * m, Matrix<data_t>::empty_matrix);
+    }
+}
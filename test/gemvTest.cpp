@@ -0,0 +1,117 @@
+#include "naiveMatrix.h"
+#include "matrix.h"
+#include <gtest/gtest.h>
+#include <random>
+
+namespace {
+
+    class GemvTest : public ::testing::Test {
+
+    protected:
+        const int MAX_DIM = 300;
+
+        std::default_random_engine generator;
+        std::uniform_int_distribution<> uniformDim;
+        std::uniform_int_distribution<> uniformData;
+
+        GemvTest() {
+            generator = std::default_random_engine( (unsigned int)time(0) );
+            uniformDim = std::uniform_int_distribution<>(1, MAX_DIM);
+            uniformData = std::uniform_int_distribution<>(-1000, 1000);
+        }
+
+        template <typename T>
+        Matrix<T> randomMatrix(mat_size_t n_rows, mat_size_t n_cols) {
+            Matrix<T> m = Matrix<T>(std::make_pair(n_rows, n_cols));
+            for (mat_size_t i = 0; i < n_rows; ++i)
+                for (mat_size_t j = 0; j < n_cols; ++j)
+                    m(i, j) = static_cast<T>(uniformData(generator));
+            return m;
+        }
+
+        template <typename T>
+        std::vector<T> column(const Matrix<T>& mat) {
+            return std::vector<T>(mat.cbegin(), mat.cend());
+        }
+
+        /**
+         * Checks A * x and x^T * A through both the Matrix and the std::vector overloads. Integer valued data keeps
+         * every sum exact in double and long.
+         */
+        template <typename T>
+        void checkProducts(mat_size_t m, mat_size_t n) {
+            Matrix<T> a = randomMatrix<T>(m, n);
+            Matrix<T> x = randomMatrix<T>(n, 1);
+            Matrix<T> xt = randomMatrix<T>(1, m);
+            NaiveMatrix<T> naiveA(a);
+            NaiveMatrix<T> naiveX(x);
+            NaiveMatrix<T> naiveXt(xt);
+            Matrix<T> expected = naiveA * naiveX;
+            Matrix<T> expectedT = naiveXt * naiveA;
+
+            EXPECT_EQ(a * x, expected);
+            EXPECT_EQ(a * column(x), column(expected));
+            EXPECT_EQ(xt * a, expectedT);
+            EXPECT_EQ(column(xt) * a, column(expectedT));
+        }
+    };
+
+    TEST_F(GemvTest, Double_Gemv_Equals_Naive) {
+        checkProducts<double>(uniformDim(generator), uniformDim(generator));
+    }
+
+    TEST_F(GemvTest, Long_Gemv_Equals_Naive) {
+        checkProducts<long>(uniformDim(generator), uniformDim(generator));
+    }
+
+    TEST_F(GemvTest, Every_Remainder_Equals_Naive) {
+        for (mat_size_t m = 1; m <= 9; ++m)
+            for (mat_size_t n = 1; n <= 70; n += 3)
+                checkProducts<double>(m, n);
+    }
+
+    TEST_F(GemvTest, Large_Gemv_Equals_Naive) {
+        checkProducts<double>(1500, 1100);
+    }
+
+    TEST_F(GemvTest, Float_Gemv_Is_Close_To_Naive) {
+        const mat_size_t m = uniformDim(generator), n = uniformDim(generator);
+        Matrix<float> a = randomMatrix<float>(m, n);
+        Matrix<float> x = randomMatrix<float>(n, 1);
+        NaiveMatrix<float> naiveA(a);
+        NaiveMatrix<float> naiveX(x);
+        Matrix<float> expected = naiveA * naiveX;
+        std::vector<float> res = a * column(x);
+        ASSERT_EQ(res.size(), m);
+        for (mat_size_t i = 0; i < m; ++i)
+            EXPECT_NEAR(res[i], expected(i, 0), 1e-6 * 1000 * 1000 * n);
+    }
+
+    TEST_F(GemvTest, Symmetric_Gemv_Reads_Lower_Triangle) {
+        const mat_size_t n = uniformDim(generator) + matmul::GEMV_SYMMETRIC_TILE;
+        Matrix<long> a = randomMatrix<long>(n, n);
+        for (mat_size_t i = 0; i < n; ++i)
+            for (mat_size_t j = 0; j < i; ++j)
+                a(j, i) = a(i, j);
+        Matrix<long> x = randomMatrix<long>(n, 1);
+        std::vector<long> expected = a * column(x);
+
+        // Only the tiles on and below the diagonal may be read
+        const mat_size_t tile = matmul::GEMV_SYMMETRIC_TILE;
+        for (mat_size_t i = 0; i < n; ++i)
+            for (mat_size_t j = (i / tile + 1) * tile; j < n; ++j)
+                a(i, j) = 12345;
+        std::vector<long> res(n);
+        matmul::gemvSymmetric(n, &a(0, 0), n, &x(0, 0), res.data());
+        EXPECT_EQ(res, expected);
+    }
+
+    TEST_F(GemvTest, Mismatched_Vector_Throws) {
+        Matrix<long> a = randomMatrix<long>(4, 5);
+        EXPECT_THROW(a * std::vector<long>(4), Matrix<long>::size_mismatch);
+        EXPECT_THROW(std::vector<long>(5) * a, Matrix<long>::size_mismatch);
+        EXPECT_THROW(a * std::vector<long>(), Matrix<long>::empty_matrix);
+        Matrix<long> empty;
+        EXPECT_THROW(empty * std::vector<long>(3), Matrix<long>::empty_matrix);
+    }
+}
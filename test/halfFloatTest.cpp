@@ -0,0 +1,107 @@
+#include "naiveMatrix.h"
+#include "matrix.h"
+#include <gtest/gtest.h>
+#include <random>
+#include <cmath>
+
+namespace {
+
+    class HalfFloatTest : public ::testing::Test {
+
+    protected:
+        const int MAX_DIM = 300;
+
+        std::default_random_engine generator;
+        std::uniform_int_distribution<> uniformDim;
+        std::uniform_real_distribution<float> uniformData;
+
+        HalfFloatTest() {
+            generator = std::default_random_engine( (unsigned int)time(0) );
+            uniformDim = std::uniform_int_distribution<>(1, MAX_DIM);
+            uniformData = std::uniform_real_distribution<float>(-1, 1);
+        }
+
+        Matrix<float> randomMatrix(mat_size_t n_rows, mat_size_t n_cols) {
+            Matrix<float> m = Matrix<float>(std::make_pair(n_rows, n_cols));
+            for (mat_size_t i = 0; i < n_rows; ++i)
+                for (mat_size_t j = 0; j < n_cols; ++j)
+                    m(i, j) = uniformData(generator);
+            return m;
+        }
+
+        /**
+         * The half precision product must equal the single precision product of the rounded operands, rounded once.
+         */
+        template <typename H>
+        void checkProduct(mat_size_t m, mat_size_t k, mat_size_t n, float epsilon) {
+            Matrix<H> a = convert<H>(randomMatrix(m, k));
+            Matrix<H> b = convert<H>(randomMatrix(k, n));
+            Matrix<float> wideA = convert<float>(a);
+            Matrix<float> wideB = convert<float>(b);
+            NaiveMatrix<float> naiveA(wideA);
+            NaiveMatrix<float> naiveB(wideB);
+            Matrix<float> expected = naiveA * naiveB;
+            Matrix<H> res = a * b;
+            ASSERT_EQ(res.shape(0), m);
+            ASSERT_EQ(res.shape(1), n);
+            for (mat_size_t i = 0; i < m; ++i)
+                for (mat_size_t j = 0; j < n; ++j)
+                    ASSERT_NEAR(expected(i, j), float(res(i, j)), epsilon * std::fabs(expected(i, j)) + 1e-5f * k);
+        }
+    };
+
+    TEST_F(HalfFloatTest, Representable_Values_Round_Trip) {
+        const float values[] = {0.0f, -0.0f, 1.0f, -2.5f, 0.15625f, 1024.0f, -61440.0f};
+        for (std::size_t i = 0; i < sizeof(values) / sizeof(values[0]); ++i) {
+            EXPECT_EQ(float(bfloat16(values[i])), values[i]);
+            EXPECT_EQ(float(float16(values[i])), values[i]);
+        }
+        EXPECT_EQ(float16(6e-8f).bits, 0x0001);   // Smallest subnormal
+        EXPECT_EQ(float16(70000.0f).bits, 0x7C00);  // Overflows to infinity
+        EXPECT_TRUE(std::isnan(float(bfloat16(NAN))));
+        EXPECT_TRUE(std::isnan(float(float16(NAN))));
+    }
+
+    TEST_F(HalfFloatTest, Rounding_Is_To_Nearest_Even) {
+        EXPECT_EQ(bfloat16(1.0f + 1.0f / 256).bits, bfloat16(1.0f).bits);   // Tie, rounds down to even
+        EXPECT_EQ(bfloat16(1.0f + 3.0f / 256).bits, bfloat16(1.0f + 1.0f / 64).bits);  // Tie, rounds up to even
+        EXPECT_EQ(float16(1.0f + 1.0f / 2048).bits, float16(1.0f).bits);
+        EXPECT_EQ(float16(1.0f + 3.0f / 2048).bits, float16(1.0f + 1.0f / 512).bits);
+    }
+
+    TEST_F(HalfFloatTest, Bulk_Conversion_Equals_Scalar) {
+        const mat_size_t rows = uniformDim(generator), cols = uniformDim(generator);
+        Matrix<float> mat = randomMatrix(rows, cols);
+        Matrix<bfloat16> bf = convert<bfloat16>(mat);
+        Matrix<float16> fp = convert<float16>(mat);
+        Matrix<float> bfBack = convert<float>(bf);
+        Matrix<float> fpBack = convert<float>(fp);
+        for (mat_size_t i = 0; i < rows; ++i) {
+            for (mat_size_t j = 0; j < cols; ++j) {
+                ASSERT_EQ(bf(i, j).bits, floatToBfloat16Bits(mat(i, j)));
+                ASSERT_EQ(fp(i, j).bits, floatToFloat16Bits(mat(i, j)));
+                ASSERT_EQ(bfBack(i, j), bfloat16BitsToFloat(bf(i, j).bits));
+                ASSERT_EQ(fpBack(i, j), float16BitsToFloat(fp(i, j).bits));
+            }  // j
+        }  // i
+    }
+
+    TEST_F(HalfFloatTest, Bfloat16_MatMul_Accumulates_In_Float) {
+        checkProduct<bfloat16>(uniformDim(generator), uniformDim(generator), uniformDim(generator), 1.0f / 128);
+    }
+
+    TEST_F(HalfFloatTest, Float16_MatMul_Accumulates_In_Float) {
+        checkProduct<float16>(uniformDim(generator), uniformDim(generator), uniformDim(generator), 1.0f / 1024);
+    }
+
+    TEST_F(HalfFloatTest, Deep_MatMul_Accumulates_In_Float) {
+        checkProduct<bfloat16>(9, 2 * DefaultBlocking<bfloat16>::KC + 7, 11, 1.0f / 128);
+    }
+
+    TEST_F(HalfFloatTest, Transpose_Equals_Naive) {
+        Matrix<float> mat = randomMatrix(uniformDim(generator), uniformDim(generator));
+        Matrix<float16> half = convert<float16>(mat);
+        NaiveMatrix<float> naive(mat);
+        EXPECT_EQ(convert<float>(half.transpose()), convert<float>(convert<float16>(naive.transpose())));
+    }
+}
@@ -0,0 +1,133 @@
+#include "lu.h"
+#include <gtest/gtest.h>
+#include <random>
+
+namespace {
+
+    class LuTest : public ::testing::Test {
+
+    protected:
+        const int MAX_DIM = 300;
+
+        std::default_random_engine generator;
+        std::uniform_int_distribution<> uniformDim;
+        std::uniform_real_distribution<double> uniformData;
+
+        LuTest() {
+            generator = std::default_random_engine( (unsigned int)time(0) );
+            uniformDim = std::uniform_int_distribution<>(1, MAX_DIM);
+            uniformData = std::uniform_real_distribution<double>(-1, 1);
+        }
+
+        template <typename T>
+        Matrix<T> randomMatrix(mat_size_t n_rows, mat_size_t n_cols) {
+            Matrix<T> m = Matrix<T>(std::make_pair(n_rows, n_cols));
+            for (mat_size_t i = 0; i < n_rows; ++i)
+                for (mat_size_t j = 0; j < n_cols; ++j)
+                    m(i, j) = static_cast<T>(uniformData(generator));
+            return m;
+        }
+
+        /**
+         * Factors a random n x n matrix with the given panel width and checks that L * U equals the pivoted input.
+         */
+        void checkFactors(mat_size_t n, std::size_t block) {
+            Matrix<double> a = randomMatrix<double>(n, n);
+            Matrix<double> f = a;
+            std::vector<std::size_t> pivots(n);
+            ASSERT_TRUE(matmul::lu(n, &f(0, 0), n, pivots.data(), block));
+
+            Matrix<double> pa = a;
+            for (mat_size_t i = 0; i < n; ++i)
+                std::swap_ranges(&pa(i, 0), &pa(i, 0) + n, &pa(pivots[i], 0));
+            for (mat_size_t i = 0; i < n; ++i) {
+                for (mat_size_t j = 0; j < n; ++j) {
+                    double sum = i <= j ? f(i, j) : 0;
+                    for (mat_size_t p = 0; p < std::min(i, j + 1); ++p)
+                        sum += f(i, p) * f(p, j);
+                    EXPECT_NEAR(sum, pa(i, j), 1e-10 * n);
+                }  // j
+            }  // i
+        }
+    };
+
+    TEST_F(LuTest, Factors_Reconstruct_Pivoted_Matrix) {
+        checkFactors(uniformDim(generator), matmul::LU_BLOCK);
+        checkFactors(uniformDim(generator), 5);
+        checkFactors(1, matmul::LU_BLOCK);
+    }
+
+    TEST_F(LuTest, Solve_Has_Small_Residual) {
+        const mat_size_t n = uniformDim(generator), cols = uniformDim(generator);
+        Matrix<double> a = randomMatrix<double>(n, n);
+        Matrix<double> b = randomMatrix<double>(n, cols);
+
+        Matrix<double> x = solve(a, b);
+        Matrix<double> ax = a * x;
+        for (mat_size_t i = 0; i < n; ++i)
+            for (mat_size_t j = 0; j < cols; ++j)
+                EXPECT_NEAR(ax(i, j), b(i, j), 1e-8 * n);
+    }
+
+    TEST_F(LuTest, Vector_Solve_Has_Small_Residual) {
+        const mat_size_t n = uniformDim(generator);
+        Matrix<float> a = randomMatrix<float>(n, n);
+        for (mat_size_t i = 0; i < n; ++i)
+            a(i, i) += static_cast<float>(n);
+        std::vector<float> b(n);
+        for (mat_size_t i = 0; i < n; ++i)
+            b[i] = static_cast<float>(uniformData(generator));
+
+        std::vector<float> ax = a * LU<float>(a).solve(b);
+        for (mat_size_t i = 0; i < n; ++i)
+            EXPECT_NEAR(ax[i], b[i], 1e-4f * n);
+    }
+
+    TEST_F(LuTest, Inverse_Times_Matrix_Is_Identity) {
+        const mat_size_t n = 2 * matmul::LU_BLOCK + 37;
+        Matrix<double> a = randomMatrix<double>(n, n);
+
+        Matrix<double> inv = inverse(a);
+        Matrix<double> id = inv * a;
+        for (mat_size_t i = 0; i < n; ++i)
+            for (mat_size_t j = 0; j < n; ++j)
+                EXPECT_NEAR(id(i, j), i == j ? 1 : 0, 1e-8 * n);
+    }
+
+    TEST_F(LuTest, Determinant_Equals_Known_Value) {
+        Matrix<double> a = Matrix<double>(std::make_pair(3, 3), {0, 2, 1,
+                                                                 3, 1, 4,
+                                                                 1, 5, 9});
+        EXPECT_NEAR(determinant(a), -32, 1e-12);
+
+        Matrix<double> id = Matrix<double>(std::make_pair(4, 4));
+        for (mat_size_t i = 0; i < 4; ++i)
+            id(i, i) = 2;
+        EXPECT_EQ(determinant(id), 16);
+    }
+
+    TEST_F(LuTest, Singular_Matrix_Is_Detected) {
+        const mat_size_t n = uniformDim(generator) + 1;
+        Matrix<double> a = randomMatrix<double>(n, n);
+        for (mat_size_t i = 0; i < n; ++i)
+            a(i, n / 2) = 0;
+
+        LU<double> lu(a);
+        EXPECT_TRUE(lu.singular());
+        EXPECT_EQ(lu.determinant(), 0);
+        EXPECT_THROW(lu.inverse(), Matrix<double>::singular_matrix);
+        EXPECT_THROW(solve(a, a), Matrix<double>::singular_matrix);
+    }
+
+    TEST_F(LuTest, Bad_Shapes_Throw) {
+        const mat_size_t n = uniformDim(generator);
+        Matrix<double> a = randomMatrix<double>(n, n + 1);
+        Matrix<double> sq = randomMatrix<double>(n, n);
+        Matrix<double> b = randomMatrix<double>(n + 1, 1);
+        Matrix<double> empty;
+
+        EXPECT_THROW(LU<double> lu(a), Matrix<double>::size_mismatch);
+        EXPECT_THROW(solve(sq, b), Matrix<double>::size_mismatch);
+        EXPECT_THROW(LU<double> lu(empty), Matrix<double>::empty_matrix);
+    }
+}
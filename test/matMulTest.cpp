@@ -5,6 +5,13 @@
 
 namespace {
 
+    /**
+     * Deliberately odd blocking, so every block and tile of a product is ragged.
+     */
+    struct OddBlocking {
+        enum { MR = 3, NR = 5, MC = 7, KC = 11, NC = 13, XPOSE = 5 };
+    };
+
     class MatMulTest : public ::testing::Test {
 
     protected:
@@ -113,4 +120,104 @@ namespace {
         NaiveMatrix<data_t> naive2(mat2);
         EXPECT_EQ(mat1 * mat2, naive1 * naive2);
     }
-}
\ No newline at end of file
+
+    TEST_F(MatMulTest, MatMul_Implementation_Equals_Naive_For_Wide) {
+        Matrix<data_t> mat1 = randomMatrix(dim1 % 16 + 1, dim2);
+        Matrix<data_t> mat2 = randomMatrix(dim2, DefaultBlocking<data_t>::NC + dim3);
+        NaiveMatrix<data_t> naive1(mat1);
+        NaiveMatrix<data_t> naive2(mat2);
+        EXPECT_EQ(mat1 * mat2, naive1 * naive2);
+    }
+
+    TEST_F(MatMulTest, MatMul_Implementation_Equals_Naive_For_Deep) {
+        Matrix<data_t> mat1 = randomMatrix(dim1, DefaultBlocking<data_t>::KC * 2 + dim2);
+        Matrix<data_t> mat2 = randomMatrix(DefaultBlocking<data_t>::KC * 2 + dim2, dim3);
+        NaiveMatrix<data_t> naive1(mat1);
+        NaiveMatrix<data_t> naive2(mat2);
+        EXPECT_EQ(mat1 * mat2, naive1 * naive2);
+    }
+
+    TEST_F(MatMulTest, MatMul_With_Custom_Blocking_Equals_Naive) {
+        Matrix<data_t> mat1 = randomMatrix(dim1, dim2);
+        Matrix<data_t> mat2 = randomMatrix(dim2, dim3);
+        Matrix<data_t, OddBlocking> odd1(std::make_pair(dim1, dim2), std::vector<data_t>(mat1.cbegin(), mat1.cend()));
+        Matrix<data_t, OddBlocking> odd2(std::make_pair(dim2, dim3), std::vector<data_t>(mat2.cbegin(), mat2.cend()));
+        NaiveMatrix<data_t> naive1(mat1);
+        NaiveMatrix<data_t> naive2(mat2);
+        Matrix<data_t, OddBlocking> res = odd1 * odd2;
+        Matrix<data_t> expected = naive1 * naive2;
+        EXPECT_TRUE(std::equal(res.cbegin(), res.cend(), expected.cbegin()));
+    }
+
+    TEST_F(MatMulTest, Transposed_Operands_Equal_Naive) {
+        const matmul::Transpose flags[] = {matmul::NO_TRANSPOSE, matmul::TRANSPOSE};
+        for (int ta = 0; ta < 2; ++ta) {
+            for (int tb = 0; tb < 2; ++tb) {
+                Matrix<data_t> mat1 = ta ? randomMatrix(dim2, dim1) : randomMatrix(dim1, dim2);
+                Matrix<data_t> mat2 = tb ? randomMatrix(dim3, dim2) : randomMatrix(dim2, dim3);
+                NaiveMatrix<data_t> naive1(mat1);
+                NaiveMatrix<data_t> naive2(mat2);
+                Matrix<data_t> op1 = ta ? naive1.transpose() : mat1;
+                Matrix<data_t> op2 = tb ? naive2.transpose() : mat2;
+                NaiveMatrix<data_t> naiveOp1(op1);
+                NaiveMatrix<data_t> naiveOp2(op2);
+                EXPECT_EQ(multiply(mat1, flags[ta], mat2, flags[tb]), naiveOp1 * naiveOp2) << ta << tb;
+            }  // tb
+        }  // ta
+    }
+
+    TEST_F(MatMulTest, Transposed_Vector_Operands_Equal_Naive) {
+        Matrix<data_t> mat = randomMatrix(dim1, dim2);
+        Matrix<data_t> row = randomMatrix(1, dim1);
+        Matrix<data_t> col = randomMatrix(dim2, 1);
+        NaiveMatrix<data_t> naiveMat(mat);
+        NaiveMatrix<data_t> naiveRow(row);
+        NaiveMatrix<data_t> naiveCol(col);
+        Matrix<data_t> matT = naiveMat.transpose();
+        Matrix<data_t> rowT = naiveRow.transpose();
+        Matrix<data_t> colT = naiveCol.transpose();
+        NaiveMatrix<data_t> naiveMatT(matT);
+        NaiveMatrix<data_t> naiveRowT(rowT);
+        NaiveMatrix<data_t> naiveColT(colT);
+        EXPECT_EQ(multiply(mat, matmul::TRANSPOSE, row, matmul::TRANSPOSE), naiveMatT * naiveRowT);
+        EXPECT_EQ(multiply(colT, matmul::NO_TRANSPOSE, mat, matmul::TRANSPOSE), naiveColT * naiveMatT);
+        EXPECT_EQ(multiply(row, matmul::NO_TRANSPOSE, mat, matmul::NO_TRANSPOSE), naiveRow * naiveMat);
+        EXPECT_EQ(multiply(mat, matmul::NO_TRANSPOSE, colT, matmul::TRANSPOSE), naiveMat * naiveCol);
+    }
+
+    TEST_F(MatMulTest, Transposed_Operands_With_Different_Dimensions_Throw_Size_Ex) {
+        Matrix<data_t> mat1 = randomMatrix(dim1, dim2);
+        Matrix<data_t> mat2 = randomMatrix(dim1 + 1, dim3);
+        EXPECT_THROW(multiply(mat1, matmul::TRANSPOSE, mat2, matmul::NO_TRANSPOSE), Matrix<data_t>::size_mismatch);
+        EXPECT_THROW(multiply(mat1, matmul::NO_TRANSPOSE, randomMatrix(dim3, dim2 + 1), matmul::TRANSPOSE),
+                     Matrix<data_t>::size_mismatch);
+        Matrix<data_t> empty;
+        EXPECT_THROW(multiply(mat1, matmul::TRANSPOSE, empty, matmul::NO_TRANSPOSE), Matrix<data_t>::empty_matrix);
+    }
+
+    TEST_F(MatMulTest, Gemm_Updates_Output_In_Place) {
+        Matrix<data_t> mat1 = randomMatrix(dim2, dim1);
+        Matrix<data_t> mat2 = randomMatrix(dim2, dim3);
+        Matrix<data_t> res = randomMatrix(dim1, dim3);
+        NaiveMatrix<data_t> naive1(mat1);
+        NaiveMatrix<data_t> naive2(mat2);
+        Matrix<data_t> transposed = naive1.transpose();
+        NaiveMatrix<data_t> naiveT(transposed);
+        Matrix<data_t> product = naiveT * naive2;
+        Matrix<data_t> expected = res;
+        for (mat_size_t i = 0; i < dim1; ++i)
+            for (mat_size_t j = 0; j < dim3; ++j)
+                expected(i, j) = 3 * product(i, j) - 2 * expected(i, j);
+
+        gemm<data_t>(3, mat1, matmul::TRANSPOSE, mat2, matmul::NO_TRANSPOSE, -2, res);
+        EXPECT_EQ(res, expected);
+    }
+
+    TEST_F(MatMulTest, Gemm_Into_Wrong_Shape_Throws_Size_Ex) {
+        Matrix<data_t> mat1 = randomMatrix(dim1, dim2);
+        Matrix<data_t> mat2 = randomMatrix(dim2, dim3);
+        Matrix<data_t> res = randomMatrix(dim1, dim3 + 1);
+        EXPECT_THROW(gemm<data_t>(1, mat1, matmul::NO_TRANSPOSE, mat2, matmul::NO_TRANSPOSE, 0, res),
+                     Matrix<data_t>::size_mismatch);
+    }
+}
@@ -3,6 +3,7 @@
 #include <iomanip>
 
 #include "matrix.h"
+#include "syrk.h"
 #include "naiveMatrix.h"
 #include <gtest/gtest.h>
 #include <chrono>
@@ -51,6 +52,16 @@ namespace {
         Matrix<data_t> matMulWrapper(NaiveMatrix<data_t>& mat) {
             return mat * mat;
         }
+
+        Matrix<data_t> gramWrapper(Matrix<data_t>& mat) {
+            return syrk(mat);
+        }
+
+        Matrix<data_t> gramWrapper(NaiveMatrix<data_t>& mat) {
+            Matrix<data_t> transposed = mat.transpose();
+            NaiveMatrix<data_t> naiveTransposed(transposed);
+            return mat * naiveTransposed;
+        }
     };
 
     TEST_F(PerformanceTest, Transpose) {
@@ -99,4 +110,28 @@ namespace {
 
         SUCCEED();
     }
+
+    TEST_F(PerformanceTest, Gram) {
+        dim1 = 1024, dim2 = 1024;
+
+        std::cout << "[Info      ] " << "Testing gram matrix performance on size " << dim1 << " x " << dim2
+                  << std::endl;
+        optim1 = randomMatrix(dim1, dim2);
+        auto start = std::chrono::high_resolution_clock::now();
+        gramWrapper(optim1);
+        auto end = std::chrono::high_resolution_clock::now();
+        optimDuration = end - start;
+
+        naive1 = NaiveMatrix<data_t>(optim1);
+        start = std::chrono::high_resolution_clock::now();
+        gramWrapper(naive1);
+        end = std::chrono::high_resolution_clock::now();
+        naiveDuration = end - start;
+
+        std::cout << "[Naive     ] " << naiveDuration.count() << std::endl;
+        std::cout << "[Optimized ] " << optimDuration.count() << std::endl;
+        std::cout << "[Improvemt.] " << (naiveDuration.count() / optimDuration.count() - 1) * 100 << " %" << std::endl;
+
+        SUCCEED();
+    }
 }
\ No newline at end of file
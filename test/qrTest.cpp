@@ -0,0 +1,137 @@
+#include "qr.h"
+#include "expression.h"
+#include <gtest/gtest.h>
+#include <random>
+
+namespace {
+
+    class QrTest : public ::testing::Test {
+
+    protected:
+        const int MAX_DIM = 200;
+
+        std::default_random_engine generator;
+        std::uniform_int_distribution<> uniformDim;
+        std::uniform_real_distribution<double> uniformData;
+
+        QrTest() {
+            generator = std::default_random_engine( (unsigned int)time(0) );
+            uniformDim = std::uniform_int_distribution<>(1, MAX_DIM);
+            uniformData = std::uniform_real_distribution<double>(-1, 1);
+        }
+
+        template <typename T>
+        Matrix<T> randomMatrix(mat_size_t n_rows, mat_size_t n_cols) {
+            Matrix<T> m = Matrix<T>(std::make_pair(n_rows, n_cols));
+            for (mat_size_t i = 0; i < n_rows; ++i)
+                for (mat_size_t j = 0; j < n_cols; ++j)
+                    m(i, j) = static_cast<T>(uniformData(generator));
+            return m;
+        }
+
+        /**
+         * Checks that R is upper triangular, that Q has orthonormal columns and that Q * R equals a.
+         */
+        void checkFactors(Matrix<double>& a, matmul::QrMode mode) {
+            const mat_size_t m = a.shape(0), n = a.shape(1);
+            QR<double> qr(a, mode);
+            Matrix<double> q = qr.q();
+            Matrix<double> r = qr.r();
+
+            for (mat_size_t i = 0; i < n; ++i)
+                for (mat_size_t j = 0; j < i; ++j)
+                    EXPECT_EQ(r(i, j), 0);
+            Matrix<double> qtq = multiply(q, matmul::TRANSPOSE, q, matmul::NO_TRANSPOSE);
+            for (mat_size_t i = 0; i < n; ++i)
+                for (mat_size_t j = 0; j < n; ++j)
+                    EXPECT_NEAR(qtq(i, j), i == j ? 1 : 0, 1e-12 * m);
+            Matrix<double> qr_ = q * r;
+            for (mat_size_t i = 0; i < m; ++i)
+                for (mat_size_t j = 0; j < n; ++j)
+                    EXPECT_NEAR(qr_(i, j), a(i, j), 1e-12 * m);
+        }
+    };
+
+    TEST_F(QrTest, Blocked_Factors_Reconstruct_Matrix) {
+        const mat_size_t n = uniformDim(generator);
+        Matrix<double> a = randomMatrix<double>(n + uniformDim(generator), n);
+        checkFactors(a, matmul::BLOCKED_QR);
+
+        Matrix<double> square = randomMatrix<double>(2 * matmul::QR_BLOCK + 21, 2 * matmul::QR_BLOCK + 21);
+        checkFactors(square, matmul::BLOCKED_QR);
+    }
+
+    TEST_F(QrTest, Tall_Skinny_Factors_Reconstruct_Matrix) {
+        const mat_size_t n = uniformDim(generator) % 40 + 1;
+        Matrix<double> a = randomMatrix<double>(100 * n + uniformDim(generator), n);
+        checkFactors(a, matmul::TALL_SKINNY_QR);
+    }
+
+    TEST_F(QrTest, Odd_Panel_Width_Reconstructs_Matrix) {
+        const mat_size_t n = uniformDim(generator), m = n + uniformDim(generator);
+        Matrix<double> a = randomMatrix<double>(m, n);
+        Matrix<double> f = a;
+        std::vector<double> t(5 * n);
+        matmul::qr(m, n, &f(0, 0), n, t.data(), n, 5);
+
+        // Q * R, applying Q to R padded with zero rows
+        Matrix<double> qr_ = Matrix<double>(std::make_pair(m, n));
+        for (mat_size_t i = 0; i < n; ++i)
+            for (mat_size_t j = i; j < n; ++j)
+                qr_(i, j) = f(i, j);
+        matmul::qrApply(false, m, n, &f(0, 0), n, t.data(), n, n, &qr_(0, 0), n, 5);
+        for (mat_size_t i = 0; i < m; ++i)
+            for (mat_size_t j = 0; j < n; ++j)
+                EXPECT_NEAR(qr_(i, j), a(i, j), 1e-12 * m);
+    }
+
+    TEST_F(QrTest, Least_Squares_Residual_Is_Orthogonal_To_Columns) {
+        const mat_size_t n = uniformDim(generator) % 50 + 1, cols = uniformDim(generator) % 5 + 1;
+        const mat_size_t m = 20 * n + uniformDim(generator);
+        Matrix<double> a = randomMatrix<double>(m, n);
+        Matrix<double> b = randomMatrix<double>(m, cols);
+
+        for (matmul::QrMode mode : {matmul::BLOCKED_QR, matmul::TALL_SKINNY_QR}) {
+            Matrix<double> x = QR<double>(a, mode).solve(b);
+            Matrix<double> residual = lazy(a) * x - b;
+            Matrix<double> normal = multiply(a, matmul::TRANSPOSE, residual, matmul::NO_TRANSPOSE);
+            for (mat_size_t i = 0; i < n; ++i)
+                for (mat_size_t j = 0; j < cols; ++j)
+                    EXPECT_NEAR(normal(i, j), 0, 1e-10 * m);
+        }
+    }
+
+    TEST_F(QrTest, Float_Least_Squares_Recovers_Exact_Solution) {
+        const mat_size_t n = uniformDim(generator) % 30 + 1, m = 10 * n;
+        Matrix<float> a = randomMatrix<float>(m, n);
+        std::vector<float> x(n);
+        for (mat_size_t i = 0; i < n; ++i)
+            x[i] = static_cast<float>(uniformData(generator));
+
+        std::vector<float> solved = QR<float>(a).solve(a * x);
+        for (mat_size_t i = 0; i < n; ++i)
+            EXPECT_NEAR(solved[i], x[i], 1e-3f);
+    }
+
+    TEST_F(QrTest, Rank_Deficient_Matrix_Throws_Singular_Ex) {
+        const mat_size_t n = uniformDim(generator) + 1;
+        Matrix<double> a = randomMatrix<double>(2 * n, n);
+        for (mat_size_t i = 0; i < 2 * n; ++i)
+            a(i, n - 1) = 0;
+        Matrix<double> b = randomMatrix<double>(2 * n, 1);
+
+        EXPECT_THROW(leastSquares(a, b), Matrix<double>::singular_matrix);
+    }
+
+    TEST_F(QrTest, Bad_Shapes_Throw) {
+        const mat_size_t n = uniformDim(generator);
+        Matrix<double> wide = randomMatrix<double>(n, n + 1);
+        Matrix<double> a = randomMatrix<double>(n + 1, n);
+        Matrix<double> b = randomMatrix<double>(n, 1);
+        Matrix<double> empty;
+
+        EXPECT_THROW(QR<double> qr(wide), Matrix<double>::size_mismatch);
+        EXPECT_THROW(leastSquares(a, b), Matrix<double>::size_mismatch);
+        EXPECT_THROW(QR<double> qr(empty), Matrix<double>::empty_matrix);
+    }
+}
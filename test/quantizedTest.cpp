@@ -0,0 +1,123 @@
+#include "quantized.h"
+#include <gtest/gtest.h>
+#include <random>
+
+namespace {
+
+    /**
+     * Checks every quantized micro-kernel the host supports against a plain triple loop, which is exact in 32-bit
+     * integers for these sizes.
+     */
+    class QuantizedTest : public ::testing::Test {
+
+    protected:
+        const int MAX_DIM = 300;
+
+        std::default_random_engine generator;
+        std::uniform_int_distribution<> uniformDim;
+        std::uniform_int_distribution<> uniformByte;
+
+        QuantizedTest() {
+            generator = std::default_random_engine( (unsigned int)time(0) );
+            uniformDim = std::uniform_int_distribution<>(1, MAX_DIM);
+            uniformByte = std::uniform_int_distribution<>(0, 255);
+        }
+
+        template <typename T>
+        Matrix<T> randomMatrix(mat_size_t n_rows, mat_size_t n_cols) {
+            Matrix<T> m = Matrix<T>(std::make_pair(n_rows, n_cols));
+            for (mat_size_t i = 0; i < n_rows; ++i)
+                for (mat_size_t j = 0; j < n_cols; ++j)
+                    m(i, j) = static_cast<T>(uniformByte(generator));
+            return m;
+        }
+
+        std::vector<int32_t> randomZeros(std::size_t n) {
+            std::vector<int32_t> z(n);
+            for (std::size_t i = 0; i < n; ++i)
+                z[i] = uniformByte(generator) - 128;
+            return z;
+        }
+
+        template <typename TA>
+        Matrix<int32_t> reference(const Matrix<TA>& a, const Matrix<int8_t>& b,
+                                  const std::vector<int32_t>& za, const std::vector<int32_t>& zb) {
+            Matrix<int32_t> res = Matrix<int32_t>(std::make_pair(a.shape(0), b.shape(1)));
+            for (mat_size_t i = 0; i < a.shape(0); ++i)
+                for (mat_size_t j = 0; j < b.shape(1); ++j)
+                    for (mat_size_t t = 0; t < a.shape(1); ++t)
+                        res(i, j) += (static_cast<int32_t>(a(i, t)) - za[i]) * (static_cast<int32_t>(b(t, j)) - zb[j]);
+            return res;
+        }
+
+        template <typename TA>
+        void checkAllKernels(mat_size_t m, mat_size_t k, mat_size_t n) {
+            Matrix<TA> a = randomMatrix<TA>(m, k);
+            Matrix<int8_t> b = randomMatrix<int8_t>(k, n);
+            std::vector<int32_t> za = randomZeros(m), zb = randomZeros(n);
+            Matrix<int32_t> expected = reference(a, b, za, zb);
+
+            const std::vector<matmul::QuantKernel>& kernels = matmul::availableQuantKernels();
+            for (std::size_t idx = 0; idx < kernels.size(); ++idx) {
+                Matrix<int32_t> res = Matrix<int32_t>(std::make_pair(m, n));
+                matmul::quantizedMultiply<TA>(m, n, k, &a(0, 0), k, &b(0, 0), n, &res(0, 0), n,
+                                              za.data(), zb.data(), kernels[idx]);
+                EXPECT_EQ(res, expected) << kernels[idx].name;
+            }
+        }
+    };
+
+    TEST_F(QuantizedTest, Generic_Kernel_Is_Always_Available) {
+        EXPECT_EQ(std::string("generic"), matmul::availableQuantKernels().back().name);
+    }
+
+    TEST_F(QuantizedTest, Unsigned_Times_Signed_Equals_Reference) {
+        checkAllKernels<uint8_t>(uniformDim(generator), uniformDim(generator), uniformDim(generator));
+    }
+
+    TEST_F(QuantizedTest, Signed_Times_Signed_Equals_Reference) {
+        checkAllKernels<int8_t>(uniformDim(generator), uniformDim(generator), uniformDim(generator));
+    }
+
+    TEST_F(QuantizedTest, Small_And_Deep_Equal_Reference) {
+        checkAllKernels<uint8_t>(1, 3, 1);
+        checkAllKernels<int8_t>(5, 7, 33);
+        checkAllKernels<int8_t>(13, DefaultBlocking<int8_t>::KC * 2 + 5, 17);
+    }
+
+    TEST_F(QuantizedTest, Saturating_Operands_Are_Exact) {
+        Matrix<uint8_t> a = Matrix<uint8_t>(std::make_pair(16, 64), std::vector<uint8_t>(16 * 64, 255));
+        Matrix<int8_t> b = Matrix<int8_t>(std::make_pair(64, 40), std::vector<int8_t>(64 * 40, -128));
+        Matrix<int32_t> res = quantizedMultiply(a, b);
+        for (mat_size_t i = 0; i < res.shape(0); ++i)
+            for (mat_size_t j = 0; j < res.shape(1); ++j)
+                ASSERT_EQ(res(i, j), 255 * -128 * 64);
+    }
+
+    TEST_F(QuantizedTest, Dequantized_Product_Equals_Reference) {
+        const mat_size_t m = 37, k = 50, n = 23;
+        Matrix<int8_t> a = randomMatrix<int8_t>(m, k);
+        Matrix<int8_t> b = randomMatrix<int8_t>(k, n);
+        QuantParams qa, qb;
+        qa.zeroPoint = randomZeros(m);
+        qb.zeroPoint = std::vector<int32_t>(1, 3);
+        for (mat_size_t i = 0; i < m; ++i)
+            qa.scale.push_back(0.01f * (i + 1));
+        qb.scale = std::vector<float>(1, 0.5f);
+
+        Matrix<float> res = quantizedMultiply(a, qa, b, qb);
+        Matrix<int32_t> expected = reference(a, b, qa.zeroPoint, std::vector<int32_t>(n, 3));
+        for (mat_size_t i = 0; i < m; ++i)
+            for (mat_size_t j = 0; j < n; ++j)
+                ASSERT_FLOAT_EQ(res(i, j), qa.scale[i] * 0.5f * expected(i, j));
+    }
+
+    TEST_F(QuantizedTest, Mismatched_Shapes_Throw_Size_Ex) {
+        Matrix<int8_t> a = randomMatrix<int8_t>(4, 5);
+        Matrix<int8_t> b = randomMatrix<int8_t>(6, 4);
+        EXPECT_THROW(quantizedMultiply(a, b), Matrix<int32_t>::size_mismatch);
+
+        Matrix<int8_t> c = randomMatrix<int8_t>(5, 4);
+        EXPECT_THROW(quantizedMultiply(a, c, std::vector<int32_t>(3, 0)), Matrix<int32_t>::size_mismatch);
+    }
+}
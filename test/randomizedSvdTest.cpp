@@ -0,0 +1,104 @@
+#include "randomizedSvd.h"
+#include <gtest/gtest.h>
+#include <random>
+
+namespace {
+
+    class RandomizedSvdTest : public ::testing::Test {
+
+    protected:
+        const int MAX_DIM = 300;
+
+        std::default_random_engine generator;
+        std::uniform_int_distribution<> uniformDim;
+        std::uniform_real_distribution<double> uniformData;
+
+        RandomizedSvdTest() {
+            generator = std::default_random_engine( (unsigned int)time(0) );
+            uniformDim = std::uniform_int_distribution<>(20, MAX_DIM);
+            uniformData = std::uniform_real_distribution<double>(-1, 1);
+        }
+
+        template <typename T>
+        Matrix<T> randomMatrix(mat_size_t n_rows, mat_size_t n_cols) {
+            Matrix<T> m = Matrix<T>(std::make_pair(n_rows, n_cols));
+            for (mat_size_t i = 0; i < n_rows; ++i)
+                for (mat_size_t j = 0; j < n_cols; ++j)
+                    m(i, j) = static_cast<T>(uniformData(generator));
+            return m;
+        }
+
+        /**
+         * @return A random m x n matrix of the given rank.
+         */
+        Matrix<double> lowRankMatrix(mat_size_t m, mat_size_t n, mat_size_t rank) {
+            Matrix<double> x = randomMatrix<double>(m, rank);
+            Matrix<double> y = randomMatrix<double>(rank, n);
+            return x * y;
+        }
+
+        /**
+         * Checks that U * diag(sigma) * V^T equals a.
+         */
+        template <typename Svd>
+        void checkReconstruction(const Matrix<double>& a, const Svd& svd, double tolerance) {
+            Matrix<double> us = svd.u();
+            for (mat_size_t i = 0; i < us.shape(0); ++i)
+                for (mat_size_t j = 0; j < us.shape(1); ++j)
+                    us(i, j) *= svd.singularValues()[j];
+            Matrix<double> vt = svd.v();
+            vt = vt.transpose();
+            Matrix<double> usv = us * vt;
+            for (mat_size_t i = 0; i < a.shape(0); ++i)
+                for (mat_size_t j = 0; j < a.shape(1); ++j)
+                    EXPECT_NEAR(usv(i, j), a(i, j), tolerance);
+        }
+    };
+
+    TEST_F(RandomizedSvdTest, Low_Rank_Matrix_Is_Recovered) {
+        const mat_size_t m = uniformDim(generator), n = uniformDim(generator), rank = 5;
+        Matrix<double> a = lowRankMatrix(m, n, rank);
+        RandomizedSVD<double> svd(a, rank, matmul::RANDOMIZED_OVERSAMPLING, 0, (unsigned int)time(0));
+        ASSERT_EQ(svd.u().shape(0), m);
+        ASSERT_EQ(svd.v().shape(0), n);
+        checkReconstruction(a, svd, 1e-8 * (m + n));
+    }
+
+    TEST_F(RandomizedSvdTest, Leading_Singular_Values_Match_Svd) {
+        // A decaying spectrum plus noise, as in PCA
+        const mat_size_t m = uniformDim(generator) + 100, n = uniformDim(generator), k = 5;
+        Matrix<double> a = lowRankMatrix(m, n, 10);
+        for (mat_size_t i = 0; i < m; ++i)
+            for (mat_size_t j = 0; j < n; ++j)
+                a(i, j) += 1e-3 * uniformData(generator);
+
+        SVD<double> exact(a, k);
+        RandomizedSVD<double> svd(a, k);
+        for (mat_size_t j = 0; j < k; ++j)
+            EXPECT_NEAR(svd.singularValues()[j], exact.singularValues()[j], 1e-6 * exact.singularValues()[0]);
+        for (mat_size_t p = 0; p < k; ++p) {
+            for (mat_size_t q = 0; q < k; ++q) {
+                double dot = 0;
+                for (mat_size_t i = 0; i < m; ++i)
+                    dot += svd.u()(i, p) * svd.u()(i, q);
+                EXPECT_NEAR(dot, p == q ? 1 : 0, 1e-8);
+            }  // q
+        }  // p
+    }
+
+    TEST_F(RandomizedSvdTest, Full_Rank_Sketch_Is_Exact) {
+        // With k + oversampling >= min(m, n) the sketch spans all of A
+        const mat_size_t m = uniformDim(generator), n = 12;
+        Matrix<double> a = randomMatrix<double>(m, n);
+        RandomizedSVD<double> svd(a, n, 4);
+        checkReconstruction(a, svd, 1e-8 * m);
+    }
+
+    TEST_F(RandomizedSvdTest, Bad_Ranks_Throw) {
+        Matrix<double> a = randomMatrix<double>(30, 20);
+        Matrix<double> empty;
+        EXPECT_THROW(RandomizedSVD<double> svd(a, 0), Matrix<double>::size_mismatch);
+        EXPECT_THROW(RandomizedSVD<double> svd(a, 21), Matrix<double>::size_mismatch);
+        EXPECT_THROW(RandomizedSVD<double> svd(empty, 1), Matrix<double>::empty_matrix);
+    }
+}
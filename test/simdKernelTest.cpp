@@ -0,0 +1,133 @@
+#include "naiveMatrix.h"
+#include "matrix.h"
+#include <gtest/gtest.h>
+#include <random>
+#include <cmath>
+
+namespace {
+
+    /**
+     * Runs every micro-kernel the host supports (not only the one operator* picks) against the naive product, on
+     * shapes that exercise full tiles, ragged tiles and several KC passes.
+     */
+    class SimdKernelTest : public ::testing::Test {
+
+    protected:
+        const int MAX_DIM = 300;
+
+        std::default_random_engine generator;
+        std::uniform_int_distribution<> uniformDim;
+        std::uniform_real_distribution<> uniformData;
+
+        SimdKernelTest() {
+            generator = std::default_random_engine( (unsigned int)time(0) );
+            uniformDim = std::uniform_int_distribution<>(1, MAX_DIM);
+            uniformData = std::uniform_real_distribution<>(-1, 1);
+        }
+
+        template <typename T>
+        Matrix<T> randomMatrix(mat_size_t n_rows, mat_size_t n_cols) {
+            Matrix<T> m = Matrix<T>(std::make_pair(n_rows, n_cols));
+            for (mat_size_t i = 0; i < n_rows; ++i)
+                for (mat_size_t j = 0; j < n_cols; ++j)
+                    m(i, j) = static_cast<T>(uniformData(generator));
+            return m;
+        }
+
+        template <typename T>
+        void checkAllKernels(mat_size_t m, mat_size_t k, mat_size_t n, T tolerance) {
+            Matrix<T> a = randomMatrix<T>(m, k);
+            Matrix<T> b = randomMatrix<T>(k, n);
+            NaiveMatrix<T> naiveA(a);
+            NaiveMatrix<T> naiveB(b);
+            Matrix<T> expected = naiveA * naiveB;
+
+            std::vector<matmul::MicroKernel<T> > kernels = matmul::KernelSelector<T>::available();
+            for (size_t idx = 0; idx < kernels.size(); ++idx) {
+                Matrix<T> res = Matrix<T>(std::make_pair(m, n));
+                matmul::multiply<T>(m, n, k, &a(0, 0), k, 1, &b(0, 0), n, 1, &res(0, 0), n, kernels[idx]);
+                for (mat_size_t i = 0; i < m; ++i)
+                    for (mat_size_t j = 0; j < n; ++j)
+                        ASSERT_NEAR(expected(i, j), res(i, j), tolerance * k)
+                                            << kernels[idx].name << " at (" << i << ", " << j << ")";
+            }
+        }
+
+        /**
+         * Checks C = alpha * A * B + beta * C for every kernel, with a depth of several KC blocks so the first block
+         * applies beta and the later ones accumulate. A beta of zero must ignore whatever C holds, even NaNs.
+         */
+        template <typename T>
+        void checkAllKernelsScaled(mat_size_t m, mat_size_t k, mat_size_t n, T alpha, T beta, T tolerance) {
+            Matrix<T> a = randomMatrix<T>(m, k);
+            Matrix<T> b = randomMatrix<T>(k, n);
+            Matrix<T> c0 = beta == T(0) ? Matrix<T>(std::make_pair(m, n), std::vector<T>(m * n, NAN))
+                                        : randomMatrix<T>(m, n);
+            NaiveMatrix<T> naiveA(a);
+            NaiveMatrix<T> naiveB(b);
+            Matrix<T> product = naiveA * naiveB;
+            const GemmBlocking blocking = matmul::tunedBlocking<T>(m, n, k);
+
+            std::vector<matmul::MicroKernel<T> > kernels = matmul::KernelSelector<T>::available();
+            for (size_t idx = 0; idx < kernels.size(); ++idx) {
+                Matrix<T> res = c0;
+                matmul::gemm<T>(m, n, k, alpha, &a(0, 0), k, 1, &b(0, 0), n, 1, beta, &res(0, 0), n, kernels[idx],
+                                blocking);
+                for (mat_size_t i = 0; i < m; ++i)
+                    for (mat_size_t j = 0; j < n; ++j)
+                        ASSERT_NEAR(alpha * product(i, j) + (beta == T(0) ? T(0) : beta * c0(i, j)), res(i, j),
+                                    tolerance * k) << kernels[idx].name << " at (" << i << ", " << j << ")";
+            }
+        }
+    };
+
+    TEST_F(SimdKernelTest, Generic_Kernel_Is_Always_Available) {
+        EXPECT_EQ(std::string("generic"), matmul::KernelSelector<float>::available().back().name);
+        EXPECT_EQ(std::string("generic"), matmul::KernelSelector<double>::available().back().name);
+        EXPECT_EQ(std::string("generic"), matmul::KernelSelector<long>::available().back().name);
+    }
+
+    TEST_F(SimdKernelTest, Float_Kernels_Equal_Naive) {
+        checkAllKernels<float>(uniformDim(generator), uniformDim(generator), uniformDim(generator), 1e-5f);
+    }
+
+    TEST_F(SimdKernelTest, Float_Kernels_Equal_Naive_For_Small) {
+        checkAllKernels<float>(1, uniformDim(generator), 1, 1e-5f);
+        checkAllKernels<float>(5, 3, 17, 1e-5f);
+    }
+
+    TEST_F(SimdKernelTest, Double_Kernels_Equal_Naive) {
+        checkAllKernels<double>(uniformDim(generator), uniformDim(generator), uniformDim(generator), 1e-12);
+    }
+
+    TEST_F(SimdKernelTest, Double_Kernels_Equal_Naive_For_Small) {
+        checkAllKernels<double>(1, uniformDim(generator), 1, 1e-12);
+        checkAllKernels<double>(7, 3, 9, 1e-12);
+    }
+
+    TEST_F(SimdKernelTest, Float_Kernels_Scale_And_Accumulate) {
+        const mat_size_t k = 2 * DefaultBlocking<float>::KC + 3;
+        checkAllKernelsScaled<float>(uniformDim(generator), k, uniformDim(generator), 0.5f, -2.0f, 1e-5f);
+        checkAllKernelsScaled<float>(uniformDim(generator), k, uniformDim(generator), -1.5f, 1.0f, 1e-5f);
+        checkAllKernelsScaled<float>(uniformDim(generator), k, uniformDim(generator), 2.0f, 0.0f, 1e-5f);
+    }
+
+    TEST_F(SimdKernelTest, Double_Kernels_Scale_And_Accumulate) {
+        const mat_size_t k = 2 * DefaultBlocking<double>::KC + 3;
+        checkAllKernelsScaled<double>(uniformDim(generator), k, uniformDim(generator), 0.5, -2.0, 1e-12);
+        checkAllKernelsScaled<double>(uniformDim(generator), k, uniformDim(generator), -1.5, 1.0, 1e-12);
+        checkAllKernelsScaled<double>(uniformDim(generator), k, uniformDim(generator), 2.0, 0.0, 1e-12);
+    }
+
+    TEST_F(SimdKernelTest, Float_Operator_Equals_Naive) {
+        Matrix<float> a = randomMatrix<float>(uniformDim(generator), 2 * DefaultBlocking<float>::KC + 3);
+        Matrix<float> b = randomMatrix<float>(2 * DefaultBlocking<float>::KC + 3, uniformDim(generator));
+        NaiveMatrix<float> naiveA(a);
+        NaiveMatrix<float> naiveB(b);
+        Matrix<float> res = a * b;
+        Matrix<float> expected = naiveA * naiveB;
+        for (mat_size_t i = 0; i < res.shape(0); ++i)
+            for (mat_size_t j = 0; j < res.shape(1); ++j)
+                ASSERT_NEAR(expected(i, j), res(i, j), 1e-5f * a.shape(1));
+    }
+}
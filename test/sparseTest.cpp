@@ -0,0 +1,153 @@
+#include "sparse.h"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <limits>
+#include <random>
+
+namespace {
+
+    class SparseTest : public ::testing::Test {
+
+    protected:
+        const int MAX_DIM = 300;
+
+        std::default_random_engine generator;
+        std::uniform_int_distribution<> uniformDim;
+        std::uniform_int_distribution<> uniformData;
+        std::uniform_real_distribution<double> uniformProbability;
+
+        SparseTest() {
+            generator = std::default_random_engine( (unsigned int)time(0) );
+            uniformDim = std::uniform_int_distribution<>(1, MAX_DIM);
+            uniformData = std::uniform_int_distribution<>(-1000, 1000);
+            uniformProbability = std::uniform_real_distribution<double>(0, 1);
+        }
+
+        /**
+         * @return A dense matrix with about the given fraction of nonzeros. Integer valued data keeps every sum
+         * exact, whatever order the kernels add in.
+         */
+        template <typename T>
+        Matrix<T> randomSparse(mat_size_t n_rows, mat_size_t n_cols, double density) {
+            Matrix<T> m = Matrix<T>(std::make_pair(n_rows, n_cols));
+            for (mat_size_t i = 0; i < n_rows; ++i)
+                for (mat_size_t j = 0; j < n_cols; ++j)
+                    if (uniformProbability(generator) < density)
+                        m(i, j) = static_cast<T>(uniformData(generator));
+            return m;
+        }
+    };
+
+    TEST_F(SparseTest, Dense_Round_Trip_Keeps_Elements) {
+        const mat_size_t m = uniformDim(generator), n = uniformDim(generator);
+        Matrix<double> dense = randomSparse<double>(m, n, 0.05);
+        SparseMatrix<double> sparse(dense);
+
+        std::size_t nonZeros = 0;
+        for (mat_size_t i = 0; i < m; ++i)
+            for (mat_size_t j = 0; j < n; ++j)
+                nonZeros += dense(i, j) != 0;
+        EXPECT_EQ(sparse.nonZeros(), nonZeros);
+        EXPECT_EQ(sparse.shape(0), m);
+        EXPECT_EQ(sparse.shape(1), n);
+        EXPECT_EQ(sparse.toDense(), dense);
+    }
+
+    TEST_F(SparseTest, Products_Equal_Dense_Products) {
+        const mat_size_t m = uniformDim(generator), k = uniformDim(generator), n = uniformDim(generator);
+        Matrix<double> a = randomSparse<double>(m, k, 0.05);
+        Matrix<double> b = randomSparse<double>(k, n, 1);
+        Matrix<double> c = randomSparse<double>(n, m, 1);
+        SparseMatrix<double> sparseA(a);
+
+        EXPECT_EQ(sparseA * b, a * b);
+        EXPECT_EQ(c * sparseA, c * a);
+    }
+
+    TEST_F(SparseTest, Spmv_Equals_Dense_Gemv) {
+        const mat_size_t m = uniformDim(generator), n = uniformDim(generator);
+        Matrix<long> a = randomSparse<long>(m, n, 0.1);
+        std::vector<long> x(n);
+        for (mat_size_t j = 0; j < n; ++j)
+            x[j] = uniformData(generator);
+
+        EXPECT_EQ(SparseMatrix<long>(a) * x, a * x);
+    }
+
+    TEST_F(SparseTest, Skewed_Rows_Equal_Dense_Products) {
+        // A few dense rows among many empty ones, large enough to split across the thread pool
+        const mat_size_t m = 3000, k = 800, n = 40;
+        Matrix<double> a = randomSparse<double>(m, k, 0.001);
+        for (mat_size_t i = 0; i < m; i += 997)
+            for (mat_size_t j = 0; j < k; ++j)
+                a(i, j) = uniformData(generator);
+        Matrix<double> b = randomSparse<double>(k, n, 1);
+        SparseMatrix<double> sparseA(a);
+
+        EXPECT_EQ(sparseA * b, a * b);
+        std::vector<double> x(k, 1);
+        EXPECT_EQ(sparseA * x, a * x);
+    }
+
+    TEST_F(SparseTest, Dense_Zeros_Times_Infinity_Give_NaN) {
+        // 0 * inf is NaN, as in the dense product, even where the dense matrix has a zero
+        const double inf = std::numeric_limits<double>::infinity();
+        Matrix<double> a = Matrix<double>(std::make_pair(2, 2), {0, 1, 1, 1});
+        Matrix<double> b = Matrix<double>(std::make_pair(2, 2), {inf, 0, 0, 1});
+        Matrix<double> expected = a * b;
+        Matrix<double> res = a * SparseMatrix<double>(b);
+
+        ASSERT_TRUE(std::isnan(expected(0, 0)));
+        for (mat_size_t i = 0; i < 2; ++i) {
+            for (mat_size_t j = 0; j < 2; ++j) {
+                EXPECT_EQ(std::isnan(res(i, j)), std::isnan(expected(i, j)));
+                if (!std::isnan(expected(i, j))) {
+                    EXPECT_EQ(res(i, j), expected(i, j));
+                }
+            }  // j
+        }  // i
+    }
+
+    TEST_F(SparseTest, Balanced_Rows_Split_Cost_Evenly) {
+        // Row 0 holds half of the cost, so it gets a range of its own
+        std::vector<std::size_t> rowStarts = {0, 1000, 1001, 1002, 1003};
+        for (std::size_t r = 4; r < 1000; ++r)
+            rowStarts.push_back(rowStarts.back());
+        const std::size_t m = rowStarts.size() - 1;
+        std::vector<std::size_t> bounds = matmul::balancedRows(m, rowStarts.data(), 4);
+        ASSERT_EQ(bounds.size(), 5u);
+        EXPECT_EQ(bounds[0], 0u);
+        EXPECT_EQ(bounds[1], 1u);
+        EXPECT_EQ(bounds[4], m);
+        for (std::size_t t = 0; t < 4; ++t)
+            EXPECT_LE(bounds[t], bounds[t + 1]);
+    }
+
+    TEST_F(SparseTest, Csr_Arrays_Are_Validated) {
+        SparseMatrix<float> ok(std::make_pair(2, 3), {0, 1, 3}, {2, 0, 1}, {1.5f, 2, 3});
+        Matrix<float> expected = Matrix<float>(std::make_pair(2, 3), {0, 0, 1.5f,
+                                                                      2, 3, 0});
+        EXPECT_EQ(ok.toDense(), expected);
+
+        EXPECT_THROW(SparseMatrix<float>(std::make_pair(2, 3), {0, 1}, {2}, {1}),
+                     SparseMatrix<float>::bad_structure);
+        EXPECT_THROW(SparseMatrix<float>(std::make_pair(2, 3), {0, 2, 1}, {0, 1}, {1, 2}),
+                     SparseMatrix<float>::bad_structure);
+        EXPECT_THROW(SparseMatrix<float>(std::make_pair(2, 3), {0, 1, 1}, {3}, {1}),
+                     SparseMatrix<float>::bad_structure);
+        EXPECT_THROW(SparseMatrix<float>(std::make_pair(2, 3), {0, 1, 2}, {0, 1}, {1}),
+                     SparseMatrix<float>::bad_structure);
+    }
+
+    TEST_F(SparseTest, Bad_Shapes_Throw) {
+        SparseMatrix<double> a(randomSparse<double>(4, 5, 0.5));
+        Matrix<double> b = randomSparse<double>(4, 5, 1);
+        Matrix<double> empty;
+
+        EXPECT_THROW(a * b, Matrix<double>::size_mismatch);
+        EXPECT_THROW(b * a, Matrix<double>::size_mismatch);
+        EXPECT_THROW(a * std::vector<double>(4), Matrix<double>::size_mismatch);
+        EXPECT_THROW(a * empty, Matrix<double>::empty_matrix);
+        EXPECT_THROW(SparseMatrix<double>() * std::vector<double>(3), Matrix<double>::empty_matrix);
+    }
+}
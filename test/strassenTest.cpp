@@ -0,0 +1,98 @@
+#include "naiveMatrix.h"
+#include "matrix.h"
+#include <gtest/gtest.h>
+#include <random>
+
+namespace {
+
+    /**
+     * Runs Strassen-Winograd with a cutoff low enough that small matrices recurse a few levels deep.
+     */
+    class StrassenTest : public ::testing::Test {
+
+    protected:
+        typedef double data_t;
+
+        const int MIN_DIM = 48;
+        const int MAX_DIM = 200;
+        const std::size_t CUTOFF = 24;
+
+        std::default_random_engine generator;
+        std::uniform_int_distribution<> uniformDim;
+        std::uniform_real_distribution<> uniformData;
+        std::size_t savedCutoff;
+
+        StrassenTest() {
+            generator = std::default_random_engine( (unsigned int)time(0) );
+            uniformDim = std::uniform_int_distribution<>(MIN_DIM, MAX_DIM);
+            uniformData = std::uniform_real_distribution<>(-1, 1);
+        }
+
+        void SetUp() {
+            savedCutoff = getStrassenCutoff();
+            setStrassenCutoff(CUTOFF);
+        }
+
+        void TearDown() {
+            setStrassenCutoff(savedCutoff);
+            setStrassenEnabled(true);
+        }
+
+        Matrix<data_t> randomMatrix(mat_size_t n_rows, mat_size_t n_cols) {
+            Matrix<data_t> m = Matrix<data_t>(std::make_pair(n_rows, n_cols));
+            for (mat_size_t i = 0; i < n_rows; ++i)
+                for (mat_size_t j = 0; j < n_cols; ++j)
+                    m(i, j) = uniformData(generator);
+            return m;
+        }
+
+        void checkAgainstNaive(mat_size_t m, mat_size_t k, mat_size_t n) {
+            Matrix<data_t> a = randomMatrix(m, k);
+            Matrix<data_t> b = randomMatrix(k, n);
+            NaiveMatrix<data_t> naiveA(a);
+            NaiveMatrix<data_t> naiveB(b);
+            Matrix<data_t> res = a * b;
+            Matrix<data_t> expected = naiveA * naiveB;
+            for (mat_size_t i = 0; i < m; ++i)
+                for (mat_size_t j = 0; j < n; ++j)
+                    ASSERT_NEAR(expected(i, j), res(i, j), 1e-12 * k) << "at (" << i << ", " << j << ")";
+        }
+    };
+
+    TEST_F(StrassenTest, Levels_Follow_Cutoff) {
+        EXPECT_EQ(matmul::strassenLevels(4096, 4096, 4096, 4096), 1);
+        EXPECT_EQ(matmul::strassenLevels(8192, 8192, 8192, 2048), 3);
+        EXPECT_EQ(matmul::strassenLevels(8192, 8192, 1000, 2048), 0);
+    }
+
+    TEST_F(StrassenTest, Strassen_Equals_Naive_For_Power_Of_Two) {
+        checkAgainstNaive(128, 128, 128);
+    }
+
+    TEST_F(StrassenTest, Strassen_Equals_Naive_For_Odd) {
+        checkAgainstNaive(uniformDim(generator) | 1, uniformDim(generator) | 1, uniformDim(generator) | 1);
+    }
+
+    TEST_F(StrassenTest, Strassen_Equals_Naive_For_All) {
+        checkAgainstNaive(uniformDim(generator), uniformDim(generator), uniformDim(generator));
+    }
+
+    TEST_F(StrassenTest, Disabled_Strassen_Matches_Blocked_Product_Exactly) {
+        const mat_size_t dim = 96;
+        Matrix<data_t> a = randomMatrix(dim, dim);
+        Matrix<data_t> b = randomMatrix(dim, dim);
+        Matrix<data_t> blocked = Matrix<data_t>(std::make_pair(dim, dim));
+        matmul::multiply<data_t>(dim, dim, dim, &a(0, 0), dim, 1, &b(0, 0), dim, 1, &blocked(0, 0), dim);
+
+        setStrassenEnabled(false);
+        EXPECT_EQ(a * b, blocked);
+    }
+
+    TEST_F(StrassenTest, Integer_Products_Are_Not_Split) {
+        Matrix<long> a = Matrix<long>(std::make_pair(64, 64), std::vector<long>(64 * 64, 3));
+        Matrix<long> b = Matrix<long>(std::make_pair(64, 64), std::vector<long>(64 * 64, 5));
+        NaiveMatrix<long> naiveA(a);
+        NaiveMatrix<long> naiveB(b);
+        EXPECT_EQ(a * b, naiveA * naiveB);
+    }
+}
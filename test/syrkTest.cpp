@@ -0,0 +1,117 @@
+#include "naiveMatrix.h"
+#include "syrk.h"
+#include <gtest/gtest.h>
+#include <random>
+
+namespace {
+
+    /**
+     * Deliberately odd blocking, so blocks and register tiles straddle the diagonal at every offset.
+     */
+    struct OddBlocking {
+        enum { MR = 3, NR = 5, MC = 7, KC = 11, NC = 13, XPOSE = 5 };
+    };
+
+    class SyrkTest : public ::testing::Test {
+
+    protected:
+        typedef long data_t;
+
+        const int MAX_DIM = 300;
+
+        std::default_random_engine generator;
+        std::uniform_int_distribution<> uniformDim;
+        std::uniform_int_distribution<> uniformData;
+
+        SyrkTest() {
+            generator = std::default_random_engine( (unsigned int)time(0) );
+            uniformDim = std::uniform_int_distribution<>(1, MAX_DIM);
+            uniformData = std::uniform_int_distribution<>(-1000, 1000);
+        }
+
+        template <typename T, typename Blocking>
+        Matrix<T, Blocking> randomMatrix(mat_size_t n_rows, mat_size_t n_cols) {
+            Matrix<T, Blocking> m = Matrix<T, Blocking>(std::make_pair(n_rows, n_cols));
+            for (mat_size_t i = 0; i < n_rows; ++i)
+                for (mat_size_t j = 0; j < n_cols; ++j)
+                    m(i, j) = static_cast<T>(uniformData(generator));
+            return m;
+        }
+
+        /**
+         * Compares both Gram matrices of a random rows x cols matrix with the naive product of it and its transpose.
+         */
+        template <typename Blocking>
+        void checkGram(mat_size_t rows, mat_size_t cols) {
+            Matrix<data_t, Blocking> a = randomMatrix<data_t, Blocking>(rows, cols);
+            Matrix<data_t> plain = Matrix<data_t>(std::make_pair(rows, cols),
+                                                  std::vector<data_t>(a.cbegin(), a.cend()));
+            NaiveMatrix<data_t> naive(plain);
+            Matrix<data_t> at = naive.transpose();
+            NaiveMatrix<data_t> naiveT(at);
+            Matrix<data_t> expected = naive * naiveT;
+            Matrix<data_t> expectedT = naiveT * naive;
+
+            Matrix<data_t, Blocking> res = syrk(a);
+            Matrix<data_t, Blocking> resT = syrk(a, matmul::TRANSPOSE);
+            EXPECT_EQ(Matrix<data_t>(std::make_pair(rows, rows), std::vector<data_t>(res.cbegin(), res.cend())),
+                      expected);
+            EXPECT_EQ(Matrix<data_t>(std::make_pair(cols, cols), std::vector<data_t>(resT.cbegin(), resT.cend())),
+                      expectedT);
+        }
+    };
+
+    TEST_F(SyrkTest, Gram_Equals_Naive) {
+        checkGram<DefaultBlocking<data_t> >(uniformDim(generator), uniformDim(generator));
+    }
+
+    TEST_F(SyrkTest, Gram_Equals_Naive_For_Odd_Blocking) {
+        checkGram<OddBlocking>(uniformDim(generator), uniformDim(generator));
+        checkGram<OddBlocking>(1, 9);
+        checkGram<OddBlocking>(40, 1);
+    }
+
+    TEST_F(SyrkTest, Large_Gram_Equals_Naive) {
+        checkGram<DefaultBlocking<data_t> >(500, 700);
+    }
+
+    TEST_F(SyrkTest, Float_Gram_Is_Symmetric_And_Close_To_Naive) {
+        const mat_size_t rows = uniformDim(generator), cols = uniformDim(generator);
+        Matrix<float> a = randomMatrix<float, DefaultBlocking<float> >(rows, cols);
+        Matrix<float> at = a.transpose();
+        Matrix<float> expected = a * at;
+        Matrix<float> res = syrk(a);
+        for (mat_size_t i = 0; i < rows; ++i) {
+            for (mat_size_t j = 0; j < rows; ++j) {
+                ASSERT_EQ(res(i, j), res(j, i));
+                ASSERT_NEAR(res(i, j), expected(i, j), 1e-6 * 1000 * 1000 * cols);
+            }  // j
+        }  // i
+    }
+
+    TEST_F(SyrkTest, Rank_2k_Update_Of_Lower_Triangle_Equals_Naive) {
+        const mat_size_t n = uniformDim(generator), k = uniformDim(generator);
+        Matrix<data_t, OddBlocking> x = randomMatrix<data_t, OddBlocking>(n, k);
+        Matrix<data_t, OddBlocking> y = randomMatrix<data_t, OddBlocking>(n, k);
+        Matrix<data_t, OddBlocking> c = randomMatrix<data_t, OddBlocking>(n, n);
+        Matrix<data_t, OddBlocking> expected = c;
+        for (mat_size_t i = 0; i < n; ++i) {
+            for (mat_size_t j = 0; j <= i; ++j) {
+                data_t sum = 0;
+                for (mat_size_t p = 0; p < k; ++p)
+                    sum += x(i, p) * y(j, p) + y(i, p) * x(j, p);
+                expected(i, j) = 3 * sum + 2 * c(i, j);
+            }  // j
+        }  // i
+
+        matmul::syr2kLower<data_t, OddBlocking>(n, k, 3, &x(0, 0), k, 1, &y(0, 0), k, 1, 2, &c(0, 0), n);
+        for (mat_size_t i = 0; i < n; ++i)
+            for (mat_size_t j = 0; j <= i; ++j)
+                ASSERT_EQ(c(i, j), expected(i, j));
+    }
+
+    TEST_F(SyrkTest, Empty_Throws_Empty_Mat_Ex) {
+        Matrix<data_t> m;
+        EXPECT_THROW(syrk(m), Matrix<data_t>::empty_matrix);
+    }
+}
@@ -0,0 +1,145 @@
+#include "naiveMatrix.h"
+#include "matrix.h"
+#include <gtest/gtest.h>
+#include <random>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+
+namespace {
+
+    class ThreadPoolTest : public ::testing::Test {
+
+    protected:
+        typedef long data_t;
+
+        const int MAX_DIM = 400;
+        const int MIN_DATA = std::numeric_limits<int>::min();
+        const int MAX_DATA = std::numeric_limits<int>::max();
+
+        std::size_t initialThreads;
+
+        std::default_random_engine generator;
+        std::uniform_int_distribution<> uniformDim;
+        std::uniform_int_distribution<> uniformData;
+
+        ThreadPoolTest() {
+            initialThreads = getNumThreads();
+            generator = std::default_random_engine( (unsigned int)time(0) );
+            uniformDim = std::uniform_int_distribution<>(1, MAX_DIM);
+            uniformData = std::uniform_int_distribution<>(MIN_DATA, MAX_DATA);
+        }
+
+        ~ThreadPoolTest() {
+            setNumThreads(initialThreads);
+        }
+
+        Matrix<data_t> randomMatrix(mat_size_t n_rows, mat_size_t n_cols) {
+            Matrix<data_t> m = Matrix<data_t>(std::make_pair(n_rows, n_cols));
+            for (mat_size_t i = 0; i < n_rows; ++i)
+                for (mat_size_t j = 0; j < n_cols; ++j)
+                    m(i, j) = uniformData(generator);
+            return m;
+        }
+    };
+
+    TEST_F(ThreadPoolTest, Set_Num_Threads_Resizes_Pool) {
+        setNumThreads(3);
+        EXPECT_EQ(getNumThreads(), 3);
+        setNumThreads(0);
+        EXPECT_EQ(getNumThreads(), 1);
+    }
+
+    TEST_F(ThreadPoolTest, Parallel_For_Runs_Every_Task_Once) {
+        setNumThreads(4);
+        const std::size_t nTasks = 1000;
+        std::vector<std::atomic<int> > counts(nTasks);
+        for (std::size_t t = 0; t < nTasks; ++t)
+            counts[t] = 0;
+        for (int rep = 0; rep < 10; ++rep)
+            ThreadPool::instance().parallelFor(nTasks, [&counts](std::size_t t) { ++counts[t]; });
+        for (std::size_t t = 0; t < nTasks; ++t)
+            EXPECT_EQ(counts[t], 10);
+    }
+
+    TEST_F(ThreadPoolTest, Nested_Parallel_For_Runs_Serially) {
+        setNumThreads(4);
+        std::atomic<int> count(0);
+        ThreadPool::instance().parallelFor(8, [&count](std::size_t) {
+            ThreadPool::instance().parallelFor(8, [&count](std::size_t) { ++count; });
+        });
+        EXPECT_EQ(count, 64);
+    }
+
+    TEST_F(ThreadPoolTest, Task_Exception_Is_Rethrown_To_Submitter) {
+        setNumThreads(4);
+        // Task 0 belongs to the submitting thread, task 39 to the last worker
+        EXPECT_THROW(ThreadPool::instance().parallelFor(40, [](std::size_t t) {
+            if (t == 0 || t == 39)
+                throw std::runtime_error("task failed");
+        }), std::runtime_error);
+
+        // The pool is still usable, and still parallel
+        ThreadPool::instance().resetStats();
+        std::atomic<int> count(0);
+        ThreadPool::instance().parallelFor(40, [&count](std::size_t) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            ++count;
+        });
+        EXPECT_EQ(count, 40);
+        std::vector<ThreadPool::WorkerStats> stats = ThreadPool::instance().stats();
+        EXPECT_LT(stats[0].executed, 40);
+    }
+
+    TEST_F(ThreadPoolTest, Stats_Count_Every_Task) {
+        setNumThreads(4);
+        ThreadPool::instance().resetStats();
+        ThreadPool::instance().parallelFor(1000, [](std::size_t) {});
+        std::vector<ThreadPool::WorkerStats> stats = ThreadPool::instance().stats();
+        ASSERT_EQ(stats.size(), 4);
+        unsigned long executed = 0;
+        for (std::size_t i = 0; i < stats.size(); ++i)
+            executed += stats[i].executed;
+        EXPECT_EQ(executed, 1000);
+    }
+
+    TEST_F(ThreadPoolTest, Idle_Threads_Steal_From_Busy_Ones) {
+        setNumThreads(4);
+        ThreadPool::instance().resetStats();
+        // The submitting thread owns tasks [0, 10) and each of them is slow
+        ThreadPool::instance().parallelFor(40, [](std::size_t t) {
+            if (t < 10)
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        });
+        std::vector<ThreadPool::WorkerStats> stats = ThreadPool::instance().stats();
+        unsigned long stolen = 0;
+        for (std::size_t i = 1; i < stats.size(); ++i)
+            stolen += stats[i].stolen;
+        EXPECT_GT(stolen, 0);
+        EXPECT_LT(stats[0].executed, 10);
+    }
+
+    TEST_F(ThreadPoolTest, Parallel_MatMul_Equals_Naive) {
+        for (std::size_t threads = 2; threads <= 5; ++threads) {
+            setNumThreads(threads);
+            Matrix<data_t> mat1 = randomMatrix(uniformDim(generator), uniformDim(generator));
+            Matrix<data_t> mat2 = randomMatrix(mat1.shape(1), uniformDim(generator));
+            NaiveMatrix<data_t> naive1(mat1);
+            NaiveMatrix<data_t> naive2(mat2);
+            EXPECT_EQ(mat1 * mat2, naive1 * naive2);
+        }
+    }
+
+    TEST_F(ThreadPoolTest, Parallel_MatMul_Equals_Serial_For_Tall_And_Wide) {
+        setNumThreads(4);
+        Matrix<data_t> tall = randomMatrix(3000, 64);
+        Matrix<data_t> square = randomMatrix(64, 64);
+        Matrix<data_t> parallelTall = tall * square;
+        Matrix<data_t> wide = randomMatrix(64, 3000);
+        Matrix<data_t> parallelWide = square * wide;
+
+        setNumThreads(1);
+        EXPECT_EQ(parallelTall, tall * square);
+        EXPECT_EQ(parallelWide, square * wide);
+    }
+}
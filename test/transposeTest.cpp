@@ -82,4 +82,12 @@ namespace {
         NaiveMatrix<data_t> naive(mat);
         EXPECT_EQ(naive.transpose(), mat.transpose());
     }
+
+    TEST_F(TransposeTest, Transpose_Implementation_Equals_Naive_For_Small) {
+        dim1 = dim1 % 16 + 1;
+        dim2 = dim2 % 40 + 1;
+        Matrix<data_t> mat = randomMatrix();
+        NaiveMatrix<data_t> naive(mat);
+        EXPECT_EQ(naive.transpose(), mat.transpose());
+    }
 }
\ No newline at end of file
@@ -0,0 +1,146 @@
+#include "triangular.h"
+#include <gtest/gtest.h>
+#include <random>
+
+namespace {
+
+    class TriangularTest : public ::testing::Test {
+
+    protected:
+        const int MAX_DIM = 200;
+
+        std::default_random_engine generator;
+        std::uniform_int_distribution<> uniformDim;
+        std::uniform_real_distribution<double> uniformData;
+
+        TriangularTest() {
+            generator = std::default_random_engine( (unsigned int)time(0) );
+            uniformDim = std::uniform_int_distribution<>(1, MAX_DIM);
+            uniformData = std::uniform_real_distribution<double>(-1, 1);
+        }
+
+        template <typename T>
+        Matrix<T> randomMatrix(mat_size_t n_rows, mat_size_t n_cols) {
+            Matrix<T> m = Matrix<T>(std::make_pair(n_rows, n_cols));
+            for (mat_size_t i = 0; i < n_rows; ++i)
+                for (mat_size_t j = 0; j < n_cols; ++j)
+                    m(i, j) = static_cast<T>(uniformData(generator));
+            return m;
+        }
+
+        /**
+         * @return op(a) as a dense matrix: the triangle uplo of a, with ones on the diagonal if diag is UNIT, and
+         * transposed if trans is TRANSPOSE.
+         */
+        Matrix<double> denseTriangle(const Matrix<double>& a, matmul::Triangle uplo, matmul::Transpose trans,
+                                     matmul::Diagonal diag) {
+            const mat_size_t k = a.shape(0);
+            Matrix<double> d = Matrix<double>(std::make_pair(k, k));
+            for (mat_size_t i = 0; i < k; ++i) {
+                for (mat_size_t j = 0; j < k; ++j) {
+                    if (uplo == matmul::LOWER ? j < i : j > i)
+                        d(i, j) = a(i, j);
+                }  // j
+                d(i, i) = diag == matmul::UNIT ? 1 : a(i, i);
+            }  // i
+            return trans == matmul::TRANSPOSE ? d.transpose() : d;
+        }
+
+        /**
+         * Runs TRMM and TRSM in every combination of side, triangle, transpose and diagonal on an m x n matrix B,
+         * and checks them against products with the dense triangle.
+         */
+        void checkAllVariants(mat_size_t m, mat_size_t n) {
+            const double alpha = 1.5;
+            for (int s = 0; s < 2; ++s) {
+                const matmul::Side side = s ? matmul::RIGHT : matmul::LEFT;
+                const mat_size_t k = s ? n : m;
+                // Small off-diagonal elements keep the solves well conditioned, with or without the diagonal
+                Matrix<double> a = randomMatrix<double>(k, k);
+                for (mat_size_t i = 0; i < k; ++i) {
+                    for (mat_size_t j = 0; j < k; ++j)
+                        a(i, j) /= k;
+                    a(i, i) = 2 + uniformData(generator);
+                }  // i
+                Matrix<double> b = randomMatrix<double>(m, n);
+                for (int v = 0; v < 8; ++v) {
+                    const matmul::Triangle uplo = v & 1 ? matmul::UPPER : matmul::LOWER;
+                    const matmul::Transpose trans = v & 2 ? matmul::TRANSPOSE : matmul::NO_TRANSPOSE;
+                    const matmul::Diagonal diag = v & 4 ? matmul::UNIT : matmul::NON_UNIT;
+                    Matrix<double> d = denseTriangle(a, uplo, trans, diag);
+
+                    Matrix<double> product = b;
+                    trmm(side, uplo, trans, diag, alpha, a, product);
+                    Matrix<double> expected = s ? b * d : d * b;
+                    for (mat_size_t i = 0; i < m; ++i)
+                        for (mat_size_t j = 0; j < n; ++j)
+                            EXPECT_NEAR(product(i, j), alpha * expected(i, j), 1e-10 * k);
+
+                    Matrix<double> x = b;
+                    trsm(side, uplo, trans, diag, alpha, a, x);
+                    Matrix<double> back = s ? x * d : d * x;
+                    for (mat_size_t i = 0; i < m; ++i)
+                        for (mat_size_t j = 0; j < n; ++j)
+                            EXPECT_NEAR(back(i, j), alpha * b(i, j), 1e-10 * k);
+                }  // v
+            }  // s
+        }
+    };
+
+    TEST_F(TriangularTest, All_Variants_Match_Dense_Products) {
+        checkAllVariants(uniformDim(generator), uniformDim(generator));
+    }
+
+    TEST_F(TriangularTest, Leaf_Sized_Triangles_Match_Dense_Products) {
+        checkAllVariants(1, 1);
+        checkAllVariants(matmul::TRIANGULAR_LEAF, 3);
+        checkAllVariants(matmul::TRIANGULAR_LEAF + 1, matmul::TRIANGULAR_LEAF - 1);
+    }
+
+    TEST_F(TriangularTest, Other_Triangle_Is_Not_Read) {
+        const mat_size_t n = uniformDim(generator);
+        Matrix<double> a = randomMatrix<double>(n, n);
+        for (mat_size_t i = 0; i < n; ++i)
+            a(i, i) = 2;
+        Matrix<double> b = randomMatrix<double>(n, 7);
+        Matrix<double> x = b;
+        trsm(matmul::LEFT, matmul::LOWER, matmul::NO_TRANSPOSE, matmul::NON_UNIT, 1.0, a, x);
+
+        for (mat_size_t i = 0; i < n; ++i)
+            for (mat_size_t j = i + 1; j < n; ++j)
+                a(i, j) = std::numeric_limits<double>::quiet_NaN();
+        Matrix<double> y = b;
+        trsm(matmul::LEFT, matmul::LOWER, matmul::NO_TRANSPOSE, matmul::NON_UNIT, 1.0, a, y);
+        EXPECT_EQ(x, y);
+    }
+
+    TEST_F(TriangularTest, Long_Trmm_Matches_Dense_Product) {
+        const mat_size_t n = uniformDim(generator);
+        Matrix<long> a = Matrix<long>(std::make_pair(n, n));
+        Matrix<long> b = Matrix<long>(std::make_pair(n, 5));
+        for (mat_size_t i = 0; i < n; ++i) {
+            for (mat_size_t j = 0; j <= i; ++j)
+                a(i, j) = static_cast<long>(10 * uniformData(generator));
+            for (mat_size_t j = 0; j < 5; ++j)
+                b(i, j) = static_cast<long>(10 * uniformData(generator));
+        }  // i
+        Matrix<long> expected = a * b;
+        trmm(matmul::LEFT, matmul::LOWER, matmul::NO_TRANSPOSE, matmul::NON_UNIT, 1L, a, b);
+        EXPECT_EQ(b, expected);
+    }
+
+    TEST_F(TriangularTest, Bad_Shapes_Throw) {
+        const mat_size_t n = uniformDim(generator);
+        Matrix<double> a = randomMatrix<double>(n, n);
+        Matrix<double> rect = randomMatrix<double>(n, n + 1);
+        Matrix<double> b = randomMatrix<double>(n + 1, n);
+        Matrix<double> empty;
+
+        EXPECT_THROW(trsm(matmul::LEFT, matmul::LOWER, matmul::NO_TRANSPOSE, matmul::NON_UNIT, 1.0, a, b),
+                     Matrix<double>::size_mismatch);
+        EXPECT_THROW(trmm(matmul::RIGHT, matmul::UPPER, matmul::NO_TRANSPOSE, matmul::UNIT, 1.0, rect, b),
+                     Matrix<double>::size_mismatch);
+        EXPECT_THROW(trmm(matmul::LEFT, matmul::UPPER, matmul::NO_TRANSPOSE, matmul::UNIT, 1.0, a, empty),
+                     Matrix<double>::empty_matrix);
+    }
+}
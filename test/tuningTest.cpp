@@ -0,0 +1,107 @@
+#include "naiveMatrix.h"
+#include "matrix.h"
+#include <gtest/gtest.h>
+#include <random>
+#include <cstdio>
+
+namespace {
+
+    class TuningTest : public ::testing::Test {
+
+    protected:
+        typedef long data_t;
+
+        const int MAX_DIM = 300;
+        const int MIN_DATA = std::numeric_limits<int>::min();
+        const int MAX_DATA = std::numeric_limits<int>::max();
+
+        std::string path;
+
+        std::default_random_engine generator;
+        std::uniform_int_distribution<> uniformDim;
+        std::uniform_int_distribution<> uniformData;
+
+        TuningTest() {
+            generator = std::default_random_engine( (unsigned int)time(0) );
+            uniformDim = std::uniform_int_distribution<>(1, MAX_DIM);
+            uniformData = std::uniform_int_distribution<>(MIN_DATA, MAX_DATA);
+            path = testing::TempDir() + "matrix_tuning_test.profile";
+        }
+
+        ~TuningTest() {
+            std::remove(path.c_str());
+            TuningProfile::instance().load(TuningProfile::defaultPath());
+        }
+
+        template <typename T>
+        Matrix<T> randomMatrix(mat_size_t n_rows, mat_size_t n_cols) {
+            Matrix<T> m = Matrix<T>(std::make_pair(n_rows, n_cols));
+            for (mat_size_t i = 0; i < n_rows; ++i)
+                for (mat_size_t j = 0; j < n_cols; ++j)
+                    m(i, j) = static_cast<T>(uniformData(generator));
+            return m;
+        }
+    };
+
+    TEST_F(TuningTest, Shapes_Are_Classified) {
+        EXPECT_EQ(classifyShape(64, 64, 64), SHAPE_SMALL);
+        EXPECT_EQ(classifyShape(1024, 1024, 1024), SHAPE_SQUARE);
+        EXPECT_EQ(classifyShape(100000, 64, 64), SHAPE_TALL);
+        EXPECT_EQ(classifyShape(64, 100000, 64), SHAPE_WIDE);
+        EXPECT_EQ(classifyShape(64, 64, 100000), SHAPE_DEEP);
+    }
+
+    TEST_F(TuningTest, Missing_Profile_Falls_Back_To_Defaults) {
+        EXPECT_FALSE(TuningProfile::instance().load(path));
+        GemmBlocking b = matmul::tunedBlocking<float>(1024, 1024, 1024);
+        EXPECT_EQ(b.mc, std::size_t(DefaultBlocking<float>::MC));
+        EXPECT_EQ(b.kc, std::size_t(DefaultBlocking<float>::KC));
+        EXPECT_EQ(b.nc, std::size_t(DefaultBlocking<float>::NC));
+        EXPECT_EQ(b.kernel, matmul::defaultKernel<float>().name);
+    }
+
+    TEST_F(TuningTest, Profile_Round_Trips_Through_File) {
+        TuningProfile profile;
+        GemmBlocking b = {"generic", 24, 40, 56};
+        profile.setGemm("float", SHAPE_TALL, b);
+        profile.setTranspose("double", 12);
+        ASSERT_TRUE(profile.save(path));
+
+        ASSERT_TRUE(TuningProfile::instance().load(path));
+        GemmBlocking loaded = matmul::tunedBlocking<float>(100000, 64, 64);
+        EXPECT_EQ(loaded.kernel, "generic");
+        EXPECT_EQ(loaded.mc, 24);
+        EXPECT_EQ(loaded.kc, 40);
+        EXPECT_EQ(loaded.nc, 56);
+        EXPECT_EQ(matmul::tunedBlocking<float>(1024, 1024, 1024).mc, std::size_t(DefaultBlocking<float>::MC));
+
+        std::size_t block = 0;
+        EXPECT_TRUE(TuningProfile::instance().findTranspose("double", block));
+        EXPECT_EQ(block, 12);
+    }
+
+    TEST_F(TuningTest, Tuned_MatMul_Equals_Naive) {
+        GemmBlocking b = {"generic", 12, 20, 24};
+        for (int shape = SHAPE_SMALL; shape < N_SHAPE_CLASSES; ++shape)
+            TuningProfile::instance().setGemm("int64", static_cast<ShapeClass>(shape), b);
+
+        Matrix<data_t> mat1 = randomMatrix<data_t>(uniformDim(generator), uniformDim(generator));
+        Matrix<data_t> mat2 = randomMatrix<data_t>(mat1.shape(1), uniformDim(generator));
+        NaiveMatrix<data_t> naive1(mat1);
+        NaiveMatrix<data_t> naive2(mat2);
+        EXPECT_EQ(mat1 * mat2, naive1 * naive2);
+    }
+
+    TEST_F(TuningTest, Tuned_Transpose_Equals_Naive) {
+        TuningProfile::instance().setTranspose("int32", 5);
+        TuningProfile::instance().setTranspose("double", 7);
+
+        Matrix<int32_t> ints = randomMatrix<int32_t>(uniformDim(generator), uniformDim(generator));
+        NaiveMatrix<int32_t> naiveInts(ints);
+        EXPECT_EQ(ints.transpose(), naiveInts.transpose());
+
+        Matrix<double> doubles = randomMatrix<double>(uniformDim(generator), uniformDim(generator));
+        NaiveMatrix<double> naiveDoubles(doubles);
+        EXPECT_EQ(doubles.transpose(), naiveDoubles.transpose());
+    }
+}
@@ -0,0 +1,172 @@
+#include "matrix.h"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * Measures the GEMM and transpose blocking parameters that run fastest on this host and writes them to a tuning
+ * profile, which operator* and transpose() pick up the next time a program starts.
+ *
+ * For every tuned element type and shape class, the micro-kernel and the I/K/J block sizes are found by coordinate
+ * descent: starting from the compiled-in defaults, each parameter in turn is swept over its candidates while the
+ * others are held fixed, keeping the fastest, for two rounds. Transpose tiles are swept on a square matrix.
+ *
+ * Usage: autotune [profile path]   (defaults to TuningProfile::defaultPath())
+ */
+namespace {
+
+    typedef std::chrono::high_resolution_clock Clock;
+
+    const std::size_t MC_CANDIDATES[] = {48, 72, 96, 120, 144, 192, 240, 288, 384};
+    const std::size_t KC_CANDIDATES[] = {64, 128, 192, 256, 384, 512};
+    const std::size_t NC_CANDIDATES[] = {512, 1024, 2048, 4096, 8192};
+    const std::size_t XPOSE_CANDIDATES[] = {8, 16, 32, 64, 128, 256};
+    const int REPETITIONS = 3;
+
+    struct Shape {
+        ShapeClass shape;
+        std::size_t m, n, k;
+    };
+
+    const Shape SHAPES[] = {
+            {SHAPE_SMALL, 96, 96, 96},
+            {SHAPE_SQUARE, 768, 768, 768},
+            {SHAPE_TALL, 4096, 192, 192},
+            {SHAPE_WIDE, 192, 4096, 192},
+            {SHAPE_DEEP, 192, 192, 4096},
+    };
+
+    std::default_random_engine generator(42);
+
+    template <typename T>
+    std::vector<T> randomData(std::size_t n) {
+        std::uniform_int_distribution<> uniform(-8, 8);
+        std::vector<T> v(n);
+        for (std::size_t i = 0; i < n; ++i)
+            v[i] = static_cast<T>(uniform(generator));
+        return v;
+    }
+
+    /**
+     * @return Best wall time in seconds of a few runs of the product with the given kernel and blocking.
+     */
+    template <typename T>
+    double timeGemm(const Shape& s, const std::vector<T>& a, const std::vector<T>& b, std::vector<T>& c,
+                    const GemmBlocking& blocking) {
+        const matmul::MicroKernel<T>& kernel = matmul::kernelByName<T>(blocking.kernel);
+        double best = 1e30;
+        for (int rep = 0; rep <= REPETITIONS; ++rep) {
+            Clock::time_point start = Clock::now();
+            matmul::multiply<T>(s.m, s.n, s.k, a.data(), s.k, 1, b.data(), s.n, 1, c.data(), s.n, kernel, blocking);
+            std::chrono::duration<double> elapsed = Clock::now() - start;
+            if (rep > 0)  // The first run only warms up caches and the thread pool
+                best = std::min(best, elapsed.count());
+        }  // rep
+        return best;
+    }
+
+    /**
+     * Sweeps one parameter of blocking over candidates, keeping the fastest value.
+     */
+    template <typename T, std::size_t N>
+    void sweep(const Shape& s, const std::vector<T>& a, const std::vector<T>& b, std::vector<T>& c,
+               GemmBlocking& blocking, std::size_t GemmBlocking::*param, const std::size_t (&candidates)[N],
+               double& best) {
+        for (std::size_t i = 0; i < N; ++i) {
+            GemmBlocking trial = blocking;
+            trial.*param = candidates[i];
+            double t = timeGemm(s, a, b, c, trial);
+            if (t < best) {
+                best = t;
+                blocking = trial;
+            }
+        }  // i
+    }
+
+    template <typename T>
+    GemmBlocking tuneGemm(const Shape& s) {
+        std::vector<T> a = randomData<T>(s.m * s.k);
+        std::vector<T> b = randomData<T>(s.k * s.n);
+        std::vector<T> c(s.m * s.n);
+
+        GemmBlocking blocking = matmul::defaultBlocking<T>();
+        double best = timeGemm(s, a, b, c, blocking);
+        for (int round = 0; round < 2; ++round) {
+            const std::vector<matmul::MicroKernel<T> >& kernels = matmul::availableKernels<T>();
+            for (std::size_t i = 0; i < kernels.size(); ++i) {
+                GemmBlocking trial = blocking;
+                trial.kernel = kernels[i].name;
+                double t = timeGemm(s, a, b, c, trial);
+                if (t < best) {
+                    best = t;
+                    blocking = trial;
+                }
+            }  // i
+            sweep(s, a, b, c, blocking, &GemmBlocking::kc, KC_CANDIDATES, best);
+            sweep(s, a, b, c, blocking, &GemmBlocking::mc, MC_CANDIDATES, best);
+            sweep(s, a, b, c, blocking, &GemmBlocking::nc, NC_CANDIDATES, best);
+        }  // round
+
+        const double gflops = 2.0 * s.m * s.n * s.k / best * 1e-9;
+        std::cout << "  " << shapeClassName(s.shape) << ": " << blocking.kernel << " mc=" << blocking.mc
+                  << " kc=" << blocking.kc << " nc=" << blocking.nc << " (" << gflops << " GFLOP/s)" << std::endl;
+        return blocking;
+    }
+
+    template <typename T>
+    std::size_t tuneTranspose() {
+        const mat_size_t dim = 2048;
+        Matrix<T> mat = Matrix<T>(std::make_pair(dim, dim), randomData<T>(dim * dim));
+        const char* type = TypeName<T>::get();
+
+        std::size_t bestBlock = DefaultBlocking<T>::XPOSE;
+        double best = 1e30;
+        for (std::size_t i = 0; i < sizeof(XPOSE_CANDIDATES) / sizeof(XPOSE_CANDIDATES[0]); ++i) {
+            TuningProfile::instance().setTranspose(type, XPOSE_CANDIDATES[i]);
+            for (int rep = 0; rep <= REPETITIONS; ++rep) {
+                Clock::time_point start = Clock::now();
+                mat.transpose();
+                std::chrono::duration<double> elapsed = Clock::now() - start;
+                if (rep > 0 && elapsed.count() < best) {
+                    best = elapsed.count();
+                    bestBlock = XPOSE_CANDIDATES[i];
+                }
+            }  // rep
+        }  // i
+        std::cout << "  transpose: block=" << bestBlock << std::endl;
+        return bestBlock;
+    }
+
+    template <typename T>
+    void tuneType(TuningProfile& profile) {
+        const char* type = TypeName<T>::get();
+        std::cout << type << std::endl;
+        for (std::size_t i = 0; i < sizeof(SHAPES) / sizeof(SHAPES[0]); ++i)
+            profile.setGemm(type, SHAPES[i].shape, tuneGemm<T>(SHAPES[i]));
+        profile.setTranspose(type, tuneTranspose<T>());
+    }
+}
+
+int main(int argc, char** argv) {
+    const std::string path = argc > 1 ? argv[1] : TuningProfile::defaultPath();
+
+    // Tune against the compiled-in defaults, not against a previous profile
+    TuningProfile::instance().clear();
+    TuningProfile profile;
+
+    std::cout << "Tuning with " << getNumThreads() << " thread(s)" << std::endl;
+    tuneType<float>(profile);
+    tuneType<double>(profile);
+    tuneType<int32_t>(profile);
+    tuneType<int64_t>(profile);
+
+    if (!profile.save(path)) {
+        std::cerr << "Could not write profile to " << path << std::endl;
+        return 1;
+    }
+    std::cout << "Wrote " << path << std::endl;
+    return 0;
+}